@@ -87,4 +87,20 @@ void * array_get(array * desc, size_t i)
 size_t array_size(array * desc)
 {
         return desc->count;
-}
\ No newline at end of file
+}
+
+size_t array_stride(array * desc)
+{
+        return desc->stride;
+}
+
+void array_pop(array * desc)
+{
+        assert(desc->count > 0);
+        desc->count--;
+}
+
+void array_clear(array * desc)
+{
+        desc->count = 0;
+}
@@ -34,5 +34,10 @@ void array_resize(array * desc, size_t capacity);
 void * array_push(array * desc);
 void * array_get(array * desc, size_t i);
 size_t array_size(array * desc);
+size_t array_stride(array * desc);
+// Remove the last element
+void array_pop(array * desc);
+// Empty the array, keeping its capacity
+void array_clear(array * desc);
 
 #endif
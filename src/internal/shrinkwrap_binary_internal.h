@@ -0,0 +1,100 @@
+//
+//  shrinkwrap_binary_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_binary_internal_h
+#define shrinkwrap_binary_internal_h
+
+#include "shrinkwrap_internal_t.h"
+#include "../shrinkwrap_binary.h"
+#include "zlib-1.2.8/zlib.h"
+
+// Bytes handed to zlib at a time, in and out
+static const size_t binary_chunk_size = 16384;
+
+// Deflate can't expand a byte of stream to more than this many bytes of output
+static const uint64_t binary_max_inflate_ratio = 1032;
+
+// A directory entry waiting for the directory to be sorted
+typedef struct binary_entry_struct {
+        binary_frame frame;
+        char * name;
+        // Position in the atlas, to keep frames with the same hash in order
+        size_t order;
+} binary_entry;
+
+typedef struct binary_sink_state_struct {
+        FILE * output;
+        // Bytes written so far
+        size_t offset;
+        array * entries;
+        uint32_t atlasWidth;
+        uint32_t atlasHeight;
+        // Set once a write fails or the file passes 4GB
+        int failed;
+        // Deflates the blobs, names and directory when compressing, otherwise NULL
+        z_stream * stream;
+        uint8_t * compressed;
+        size_t compressedSize;
+        unsigned transforms;
+} binary_sink_state;
+
+struct binary_inflater_struct {
+        z_stream stream;
+        // binary_container_size bytes
+        uint8_t container[64];
+        size_t containerFill;
+        unsigned transforms;
+        uint32_t compressedSize;
+        // The plain file, allocated once the container has arrived
+        uint8_t * data;
+        size_t size;
+        int finished;
+        int failed;
+};
+
+size_t align_binary(size_t offset);
+int compare_binary_entries(const void * a, const void * b);
+void put_binary_u16(uint8_t * p, uint16_t value);
+void put_binary_u32(uint8_t * p, uint32_t value);
+void put_binary_f32(uint8_t * p, float value);
+uint16_t get_binary_u16(const uint8_t * p);
+uint32_t get_binary_u32(const uint8_t * p);
+float get_binary_f32(const uint8_t * p);
+void write_binary_frame(uint8_t * p, const binary_frame * frame);
+void write_binary_vertices(uint8_t * p, shrinkwrap * sw);
+void write_binary_indices(uint8_t * p, array * indices);
+void write_binary_header(uint8_t * p, const binary_header * header);
+void write_binary_zeros(binary_sink_state * state, size_t size);
+size_t write_binary_padding(binary_sink_state * state);
+void write_binary_blob(binary_sink_state * state, const uint8_t * data, size_t size);
+void write_binary_output(binary_sink_state * state, const uint8_t * data, size_t size);
+void deflate_binary(binary_sink_state * state, const uint8_t * data, size_t size, int flush);
+uint32_t zigzag_binary(uint32_t difference, size_t width);
+uint32_t unzigzag_binary(uint32_t value, size_t width);
+void delta_encode_binary(uint8_t * p, size_t count, size_t width, size_t interleave);
+void delta_decode_binary(uint8_t * p, size_t count, size_t width, size_t interleave);
+int decode_binary_transforms(uint8_t * data, size_t size, unsigned transforms);
+int read_binary_container(binary_inflater * inflater);
+int binary_sink_begin(mesh_sink * sink, uint32_t atlasWidth, uint32_t atlasHeight);
+int binary_sink_frame(mesh_sink * sink, shrinkwrap * sw, const char * name);
+int binary_sink_end(mesh_sink * sink);
+void binary_sink_destroy(mesh_sink * sink);
+#endif
@@ -0,0 +1,44 @@
+//
+//  shrinkwrap_cache_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_cache_internal_h
+#define shrinkwrap_cache_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// Size of the LRU cache modelled while reordering
+#define VERTEX_CACHE_SIZE 32
+
+typedef struct cache_vertex_struct {
+        // Position in the modelled cache, or -1
+        int position;
+        float score;
+        // Triangles not yet emitted, listed from 'first' in the triangle table
+        uint32_t remaining;
+        uint32_t first;
+} cache_vertex;
+
+void optimise_vertex_cache(shrinkwrap * sw);
+void optimise_indices(array * indices, size_t vertexCount);
+float vertex_score(const cache_vertex * v);
+float vertex_cache_acmr(shrinkwrap * sw, size_t cacheSize);
+size_t simulate_cache_misses(array * indices, size_t cacheSize);
+#endif
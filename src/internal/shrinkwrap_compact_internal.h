@@ -0,0 +1,38 @@
+//
+//  shrinkwrap_compact_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_compact_internal_h
+#define shrinkwrap_compact_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// A referenced vertex, sorted by position to find duplicates
+typedef struct weld_entry_struct {
+        float x;
+        float y;
+        uint32_t index;
+} weld_entry;
+
+void compact_vertices(shrinkwrap * sw);
+size_t weld_vertices(array * vertices, const uch * referenced, uint32_t * outWelded);
+size_t remap_indices(array * indices, const uint32_t * welded, uint32_t * remap, size_t next);
+array * narrow_indices(array * indices, index_width width);
+#endif
@@ -0,0 +1,96 @@
+//
+//  shrinkwrap_contour_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_contour_internal_h
+#define shrinkwrap_contour_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// Steps between pixel corners, turning right with each increment
+typedef enum contour_step_enum {
+        STEP_EAST,
+        STEP_SOUTH,
+        STEP_WEST,
+        STEP_NORTH
+} contour_step;
+
+typedef enum ring_side_enum {
+        RING_OUTSIDE,
+        RING_INSIDE,
+        RING_BOUNDARY
+} ring_side;
+
+typedef struct contour_bounds_struct {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+} contour_bounds;
+
+// State for simplifying one contour against the live points of every contour
+typedef struct contour_simplify_struct {
+        contour_list * cl;
+        size_t current;
+        // Points of the current contour that are still kept
+        uint8_t * kept;
+        contour_bounds * bounds;
+        float bleed;
+        // 1 where the contour may only grow its region, -1 where it may only shrink it
+        float direction;
+} contour_simplify;
+
+static inline contour * get_contour(contour_list * cl, size_t i) {return (contour *)array_get(cl->contours, i);}
+
+contour_list * trace_contours(const tpxl * tpixels, pxl_size w, pxl_size h);
+void simplify_contours(contour_list * cl, float bleed);
+shrinkwrap * triangulate_contours(contour_list * cl);
+void destroy_contour_list(contour_list * cl);
+const char * mesh_engine_name(mesh_engine engine);
+int mesh_engine_from_name(const char * name, mesh_engine * outEngine);
+
+// Marching squares
+void trace_alpha_contours(contour_list * cl, const tpxl * tpixels, pxl_size w, pxl_size h, alpha a,
+                          uint8_t * visited);
+void trace_contour(contour_list * cl, const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                   uint8_t * visited);
+int pixel_in_region(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y);
+int contour_step_exists(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                        contour_step step);
+contour_step next_contour_step(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                               contour_step step);
+
+// Conservative Douglas-Peucker
+void simplify_contour(contour_simplify * s);
+void simplify_contour_span(contour_simplify * s, const vert * points, size_t count, size_t first, size_t last);
+int contour_chord_allowed(const contour_simplify * s, const vert * points, size_t count, size_t first, size_t last);
+int chord_meets_contour(const contour_simplify * s, size_t other, size_t first, size_t last,
+                        const contour_bounds * notch);
+int chord_crosses(const vert * a, const vert * b, const vert * c, const vert * d);
+ring_side point_ring_side(const vert * points, size_t count, size_t first, size_t last, const vert * p);
+void measure_contour_bounds(contour * c, contour_bounds * outBounds);
+
+// Triangulation
+int contour_is_meshed(contour * c);
+int contour_in_mesh(const contour * c, alpha mesh);
+int contour_is_outer(const contour * c, alpha mesh);
+int contour_contains(contour * outer, contour * inner);
+void triangulate_contour_mesh(shrinkwrap * sw, contour_list * cl, alpha mesh);
+#endif
@@ -0,0 +1,57 @@
+//
+//  shrinkwrap_convex_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_convex_internal_h
+#define shrinkwrap_convex_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// A triangle edge, keyed by its lower and higher vertex index to find the triangle on its other side
+typedef struct convex_edge_struct {
+        uint32_t low;
+        uint32_t high;
+        uint32_t triangle;
+        // TRUE if the triangle runs from low to high
+        uint8_t forward;
+        uint8_t full;
+} convex_edge;
+
+// Triangles merged into convex polygons.  Each triangle starts as a polygon of its own; merged polygons are found
+// through 'parent'.
+typedef struct convex_merge_struct {
+        array * vertices;
+        // Corner lists, one per triangle, each holding uint32_t vertex indices clockwise on screen
+        array ** polygons;
+        uint32_t * parent;
+        uint8_t * full;
+        size_t count;
+} convex_merge;
+
+void merge_convex(shrinkwrap * sw);
+
+int compare_convex_edges(const void * a, const void * b);
+uint32_t find_convex_polygon(convex_merge * m, uint32_t polygon);
+int merge_convex_pair(convex_merge * m, uint32_t first, uint32_t second, uint32_t a, uint32_t b);
+size_t find_polygon_corner(array * polygon, uint32_t vertex);
+double corner_turn(array * vertices, uint32_t prev, uint32_t corner, uint32_t next);
+void mark_bent_corners(convex_merge * m, uint8_t * bent);
+void fan_convex_polygon(array * polygon, const uint8_t * bent, array * indices);
+#endif
@@ -0,0 +1,36 @@
+//
+//  shrinkwrap_core_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_core_internal_h
+#define shrinkwrap_core_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+int find_opaque_rect(const tpxl * tpixels, pxl_size w, const pixel_rect * region, pxl_size minSide,
+                     pixel_rect * outRect);
+size_t split_opaque_cores(const tpxl * tpixels, pxl_size w, pxl_size h, pxl_size minSide, pxl_size overlap,
+                          size_t maxCores, pixel_rect * outCores, size_t * outCoreCount, pixel_rect * outRegions);
+tpxl * crop_typemap(const tpxl * tpixels, pxl_size w, const pixel_rect * rect);
+shrinkwrap * merge_shrinkwraps(shrinkwrap ** parts, const pixel_rect * regions, size_t count,
+                               const pixel_rect * cores, size_t coreCount);
+int region_has_alpha(const tpxl * tpixels, pxl_size w, const pixel_rect * region);
+size_t split_region(const pixel_rect * region, pixel_rect * inOutCore, pxl_size overlap, pixel_rect * outParts);
+#endif
@@ -0,0 +1,33 @@
+//
+//  shrinkwrap_cost_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_cost_internal_h
+#define shrinkwrap_cost_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+float mesh_cost(shrinkwrap * sw, const device_profile * device, mesh_choice choice, float width, float height);
+mesh_choice choose_mesh(shrinkwrap * sw, const device_profile * device, float width, float height);
+void apply_mesh_choice(shrinkwrap * sw, mesh_choice choice, float width, float height, float shiftY);
+const char * mesh_choice_name(mesh_choice choice);
+const device_profile * device_profile_from_name(const char * name);
+size_t referenced_vertices(array * indices, size_t vertexCount, uch * marks);
+#endif
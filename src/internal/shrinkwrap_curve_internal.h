@@ -41,8 +41,10 @@ CP * get_last_point(C * c);
 C * destroy_curve(C * c);
 
 // Curve lists
+curve_list * build_curves(const tpxl * tpixels, pxl_size w, pxl_size h);
 CN * create_node(C * c, CP * p);
 curve_list * create_curve_list(size_t scanlines);
+curve_list * destroy_curve_list(curve_list * cl);
 void try_add_curve(curve_list * cl, alpha type, alpha lastType, const tpxl * tpixels, float x,
                                float y, pxl_size w, pxl_size h);
 void add_curve(curve_list * cl, C * c, CP * p);
@@ -75,6 +77,9 @@ void collapse_curve_endings(curve_list * cl, pxl_size w, pxl_size h, pxl_size bl
 void smooth_fix_up(curve_list * cl);
 
 // Optimisation
+void smooth_curves_ex(curve_list * cl, float bleed, pxl_size w, pxl_size h, const smooth_options * options);
+void smooth_curves_parallel(curve_list * cl, float w, float bleed, simplifier method, size_t threads);
+size_t smoothCurve(C * c, float w, float maxBleed);
 conserve conserve_direction(const CN * scanline, const C * c);
 void protect_right_point(CP * p);
 void protect_subdivision_points(curve_list * cl, pxl_size w);
@@ -0,0 +1,77 @@
+//
+//  shrinkwrap_earclip_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_earclip_internal_h
+#define shrinkwrap_earclip_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// A ring of polygon vertices numbered from 'index' in order
+typedef struct ear_ring_struct {
+        const vert * points;
+        size_t count;
+        uint32_t index;
+} ear_ring;
+
+typedef struct ear_node_struct {
+        float x;
+        float y;
+        uint32_t index;
+        struct ear_node_struct * prev;
+        struct ear_node_struct * next;
+} ear_node;
+
+// Nodes are allocated in blocks and freed together once a polygon is clipped
+#define EAR_BLOCK_SIZE 256
+typedef struct ear_block_struct {
+        ear_node nodes[EAR_BLOCK_SIZE];
+        struct ear_block_struct * next;
+} ear_block;
+
+typedef struct ear_pool_struct {
+        ear_block * blocks;
+        size_t used;
+} ear_pool;
+
+void earclip(array * indices, const ear_ring * outer, const ear_ring * holes, size_t holeCount);
+ear_node * ear_ring_nodes(ear_pool * pool, const ear_ring * ring, int outer);
+ear_node * create_ear_node(ear_pool * pool, float x, float y, uint32_t index, ear_node * last);
+void remove_ear_node(ear_node * p);
+void destroy_ear_pool(ear_pool * pool);
+ear_node * leftmost_ear_node(ear_node * start);
+int compare_ear_node_x(const void * a, const void * b);
+ear_node * eliminate_hole(ear_pool * pool, ear_node * hole, ear_node * outer);
+ear_node * find_hole_bridge(const ear_node * hole, ear_node * outer);
+int sector_contains_sector(const ear_node * m, const ear_node * p);
+ear_node * filter_ear_nodes(ear_node * start, ear_node * end);
+void clip_ears(ear_pool * pool, array * indices, ear_node * ear, int pass);
+int is_ear(const ear_node * ear);
+ear_node * cure_local_intersections(ear_node * start, array * indices);
+void split_clip_ears(ear_pool * pool, array * indices, ear_node * start);
+ear_node * split_ear_polygon(ear_pool * pool, ear_node * a, ear_node * b);
+int is_valid_diagonal(const ear_node * a, const ear_node * b);
+float ear_area(const ear_node * p, const ear_node * q, const ear_node * r);
+int ear_point_in_triangle(float ax, float ay, float bx, float by, float cx, float cy, float px, float py);
+int ear_nodes_intersect(const ear_node * p1, const ear_node * q1, const ear_node * p2, const ear_node * q2);
+int ear_locally_inside(const ear_node * a, const ear_node * b);
+int ear_middle_inside(const ear_node * a, const ear_node * b);
+double ring_signed_area(const vert * points, size_t count);
+#endif
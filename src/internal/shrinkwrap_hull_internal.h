@@ -0,0 +1,65 @@
+//
+//  shrinkwrap_hull_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_hull_internal_h
+#define shrinkwrap_hull_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// Summed-area tables of a type pixel map: entry (x, y) of each counts the pixels above and left of pixel (x, y), so
+// each holds (w + 1) * (h + 1) entries
+typedef struct alpha_sums_struct {
+        uint32_t * visible;
+        uint32_t * full;
+        pxl_size width;
+        pxl_size height;
+} alpha_sums;
+
+// State for dividing one frame.  Index lists hold 32-bit indices until the vertex count is known.
+typedef struct hull_decompose_struct {
+        const alpha_sums * sums;
+        array * vertices;
+        array * indicesFullAlpha;
+        array * indicesPartialAlpha;
+        float maxWaste;
+        // Room for the corners of every row of the frame
+        vert * points;
+        vert * hull;
+} hull_decompose;
+
+shrinkwrap * decompose_hulls(const tpxl * tpixels, pxl_size w, pxl_size h, float maxWaste);
+
+// Summed-area tables
+alpha_sums * create_alpha_sums(const tpxl * tpixels, pxl_size w, pxl_size h);
+void destroy_alpha_sums(alpha_sums * sums);
+uint32_t sum_rect(const uint32_t * table, pxl_size w, const pixel_rect * rect);
+pxl_size visible_prefix(const alpha_sums * sums, const pixel_rect * rect, int columns, uint32_t count);
+int fit_visible_rect(const alpha_sums * sums, const pixel_rect * rect, pixel_rect * outRect);
+float rect_waste(const alpha_sums * sums, const pixel_rect * rect);
+
+// Division
+void decompose_rect(hull_decompose * d, const pixel_rect * rect);
+int choose_hull_cut(const alpha_sums * sums, const pixel_rect * rect, pixel_rect * outFirst, pixel_rect * outSecond);
+size_t visible_hull(const alpha_sums * sums, const pixel_rect * rect, vert * points, vert * outHull);
+int compare_hull_points(const void * a, const void * b);
+float hull_turn(const vert * o, const vert * a, const vert * b);
+void add_hull_fan(hull_decompose * d, const vert * hull, size_t count, array * indices);
+#endif
@@ -97,6 +97,7 @@ struct curve_struct {
         CP * pointList;
         CP * removed;
         alpha alphaType;
+        size_t order;
 };
 static const size_t c_size = sizeof(C);
 
@@ -117,4 +118,23 @@ struct curves_list_struct {
         CN * lastCurve;
 };
 static const size_t curves_size = sizeof(curve_list);
+
+// A closed border traced along pixel edges with the region it bounds on its right, so outer borders run clockwise on
+// screen and holes anticlockwise.  Points are the corners where the border turns.
+typedef struct contour_struct {
+        array * points;
+        // ALPHA_ANYALPHA borders the visible pixels and ALPHA_FULL the opaque ones
+        alpha alphaType;
+        int hole;
+        // Vertex index of the first point, set by triangulate_contours
+        uint32_t index;
+} contour;
+static const size_t contour_size = sizeof(contour);
+
+struct contour_list_struct {
+        array * contours;
+        pxl_size width;
+        pxl_size height;
+};
+static const size_t contour_list_size = sizeof(contour_list);
 #endif
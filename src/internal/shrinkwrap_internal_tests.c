@@ -1,9 +1,29 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <memory.h>
+#include <math.h>
+#include <pthread.h>
 #include "minunit.h"
 #include "shrinkwrap_triangle_internal.h"
 #include "shrinkwrap_curve_internal.h"
+#include "shrinkwrap_simplify_internal.h"
+#include "shrinkwrap_monotone_internal.h"
+#include "shrinkwrap_strip_internal.h"
+#include "shrinkwrap_cache_internal.h"
+#include "shrinkwrap_compact_internal.h"
+#include "shrinkwrap_quantise_internal.h"
+#include "shrinkwrap_stats_internal.h"
+#include "shrinkwrap_cost_internal.h"
+#include "shrinkwrap_core_internal.h"
+#include "shrinkwrap_contour_internal.h"
+#include "shrinkwrap_hull_internal.h"
+#include "shrinkwrap_refine_internal.h"
+#include "shrinkwrap_convex_internal.h"
+#include "shrinkwrap_pixel_internal.h"
+#include "shrinkwrap_binary_internal.h"
+#include "../textwriter.h"
+#include "../taskpool.h"
+#include "../workqueue.h"
 
 typedef struct {
         CP * l;
@@ -185,9 +205,1075 @@ char * test_conserve_direction() {
         return NULL;
 }
 
+size_t count_points(C * c) {
+        size_t count = 0;
+        for (CP * p = c->pointList; p; p = p->next) count++;
+        return count;
+}
+
+char * check_simplifier(simplifier method) {
+        slopes_fixture fixture = create_slopes_fixture();
+        test_point straight[] = {
+                {1.f, 0.f},
+                {1.f, 1.f},
+                {1.f, 2.f},
+                {1.f, 3.f}
+        };
+        // straight curves collapse to their endings unless a point is protected
+        {
+                test_point_list curves[3] = {
+                        make_point_list(fixture.leftedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                        , make_point_list(straight, ALPHA_FULL, SLOPE_HEIGHT)
+                        , make_point_list(fixture.rightedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                };
+                curve_list * cl = create_test_curve_list_static_array(curves, SLOPE_HEIGHT);
+                simplify_curve(curves[1].curveresult, 3.f, 0.5f, method);
+                mu_equals_int(2, count_points(curves[1].curveresult));
+                destroy_curve_list(cl);
+        }
+        {
+                test_point_list curves[3] = {
+                        make_point_list(fixture.leftedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                        , make_point_list(straight, ALPHA_FULL, SLOPE_HEIGHT)
+                        , make_point_list(fixture.rightedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                };
+                curve_list * cl = create_test_curve_list_static_array(curves, SLOPE_HEIGHT);
+                get(curves[1].curveresult->pointList, 1)->preserve = PRESERVE_DONOTREMOVE;
+                simplify_curve(curves[1].curveresult, 3.f, 0.5f, method);
+                mu_equals_int(3, count_points(curves[1].curveresult));
+                destroy_curve_list(cl);
+        }
+        // full-alpha left edges may only give way to the left, however large the tolerance
+        {
+                test_point_list curves[3] = {
+                        make_point_list(fixture.leftedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                        , make_point_list(fixture.decreaseslope, ALPHA_FULL, SLOPE_HEIGHT)
+                        , make_point_list(fixture.rightedge, ALPHA_ZERO, SLOPE_HEIGHT)
+                };
+                curve_list * cl = create_test_curve_list_static_array(curves, SLOPE_HEIGHT);
+                simplify_curve(curves[1].curveresult, 3.f, 8.f, method);
+                mu_equals_int(SLOPE_HEIGHT, count_points(curves[1].curveresult));
+                destroy_curve_list(cl);
+        }
+        destroy_slopes_fixture(fixture);
+        return NULL;
+}
+
+// Smoothing on several threads must give exactly the points smoothing serially does.  The sprite is a grid of blobs
+// of varying shape with blended borders, so the curves of neighbouring blobs share scanlines and limit each other.
+char * test_smooth_parallel() {
+        const pxl_size w = 96;
+        const pxl_size h = 64;
+        tpxl * tpixels = (tpxl *)calloc(w * h, sizeof(tpxl));
+        for (pxl_size y = 0; y < h; y++) {
+                for (pxl_size x = 0; x < w; x++) {
+                        int cx = (int)(x % 12) - 6;
+                        int cy = (int)(y % 16) - 8;
+                        int size = 3 + (int)((x / 12 * 7 + y / 16 * 3) % 4);
+                        int d = cx * cx + cy * cy / 2;
+                        if (d < size * size / 2) {
+                                tpixels[y * w + x] = ALPHA_FULL;
+                        } else if (d < size * size) {
+                                tpixels[y * w + x] = ALPHA_PARTIAL;
+                        }
+                }
+        }
+        for (int method = 0; method < SIMPLIFY_COUNT; method++) {
+                curve_list * serial = build_curves(tpixels, w, h);
+                curve_list * parallel = build_curves(tpixels, w, h);
+                smooth_options options = {1, (simplifier)method};
+                smooth_curves_ex(serial, 4.0f, w, h, &options);
+                options.threads = 4;
+                smooth_curves_ex(parallel, 4.0f, w, h, &options);
+                size_t curves = 0;
+                CN * a = serial->head->next;
+                CN * b = parallel->head->next;
+                for (; a && b; a = a->next, b = b->next, curves++) {
+                        CP * pa = a->curve->pointList;
+                        CP * pb = b->curve->pointList;
+                        for (; pa && pb; pa = pa->next, pb = pb->next) {
+                                mu_assert("Point differs", pa->vertex.x == pb->vertex.x &&
+                                          pa->vertex.y == pb->vertex.y);
+                        }
+                        mu_assert("Point count differs", pa == NULL && pb == NULL);
+                }
+                mu_assert("Curve count differs", a == NULL && b == NULL);
+                mu_assert("Too few curves to share out", curves > 64);
+                destroy_curve_list(serial);
+                destroy_curve_list(parallel);
+        }
+        free(tpixels);
+        return NULL;
+}
+
+char * test_simplifiers() {
+        mu_run_test(check_simplifier(SIMPLIFY_DOUGLAS_PEUCKER));
+        mu_run_test(check_simplifier(SIMPLIFY_VISVALINGAM_WHYATT));
+        mu_run_test(check_simplifier(SIMPLIFY_REUMANN_WITKAM));
+        return NULL;
+}
+
+void link_test_points(CP * points, const test_point * const coords, size_t count) {
+        memset(points, 0, cp_size * count);
+        for (size_t i = 0; i < count; i++) {
+                points[i].vertex.x = coords[i].x;
+                points[i].vertex.y = coords[i].y;
+                points[i].next = (i + 1 < count) ? points + i + 1 : NULL;
+        }
+}
+
+char * test_self_intersection_left() {
+        const vert a = {0.f, 0.f};
+        const vert b = {4.f, 3.f};
+        // a segment spanning the end of the line crosses it
+        {
+                const test_point coords[] = {{1.f, 0.f}, {-1.f, 4.f}, {5.f, 5.f}, {5.f, 9.f}};
+                CP points[4];
+                link_test_points(points, coords, 4);
+                mu_equals_int(TRUE, self_intersection_curve_left(&a, &b, b.y, points));
+        }
+        // segments below the line are never reached
+        {
+                const test_point coords[] = {{0.f, 0.f}, {0.f, 4.f}, {4.f, 5.f}, {-4.f, 6.f}, {4.f, 7.f}};
+                CP points[5];
+                link_test_points(points, coords, 5);
+                mu_equals_int(FALSE, self_intersection_curve_left(&a, &b, b.y, points));
+        }
+        return NULL;
+}
+
+// Each segment tested alone and in a batch must agree with intersect.
+char * test_intersect_batch() {
+        const vert a = {0.f, 0.f};
+        const vert b = {4.f, 4.f};
+        const vert segments[][2] = {
+                {{0.f, 4.f}, {4.f, 0.f}},       // crosses
+                {{1.f, 0.f}, {5.f, 4.f}},       // parallel
+                {{0.f, 4.f}, {1.f, 3.f}},       // stops short
+                {{4.f, 0.f}, {0.f, 4.f}},       // crosses the other way
+                {{2.f, 2.f}, {4.f, 0.f}},       // touches
+                {{3.f, 1.f}, {1.f, 3.f}}        // crosses inside
+        };
+        const size_t count = sizeof(segments) / sizeof(segments[0]);
+        for (size_t i = 0; i < count; i++) {
+                segment_batch batch;
+                segment_batch_clear(&batch);
+                segment_batch_add(&batch, &segments[i][0], &segments[i][1]);
+                mu_equals_int(intersect(&a, &b, &segments[i][0], &segments[i][1]), intersect_batch(&a, &b, &batch));
+        }
+        segment_batch batch;
+        segment_batch_clear(&batch);
+        segment_batch_add(&batch, &segments[1][0], &segments[1][1]);
+        segment_batch_add(&batch, &segments[2][0], &segments[2][1]);
+        segment_batch_add(&batch, &segments[4][0], &segments[4][1]);
+        mu_equals_int(FALSE, intersect_batch(&a, &b, &batch));
+        segment_batch_clear(&batch);
+        segment_batch_add(&batch, &segments[1][0], &segments[1][1]);
+        segment_batch_add(&batch, &segments[2][0], &segments[2][1]);
+        segment_batch_add(&batch, &segments[4][0], &segments[4][1]);
+        segment_batch_add(&batch, &segments[5][0], &segments[5][1]);
+        mu_equals_int(TRUE, intersect_batch(&a, &b, &batch));
+        return NULL;
+}
+
+char * test_monotone_polygon() {
+        // the right-hand chain doubles back along y = 2 where it steps between curves
+        const test_point coords[] = {{0.f, 0.f}, {4.f, 0.f}, {0.f, 2.f}, {6.f, 2.f}, {4.f, 2.f}, {0.f, 4.f},
+                {4.f, 4.f}};
+        const chain sides[] = {CHAIN_LEFT, CHAIN_RIGHT, CHAIN_LEFT, CHAIN_RIGHT, CHAIN_RIGHT, CHAIN_LEFT, CHAIN_RIGHT};
+        const size_t count = 7;
+        CP points[7];
+        monotone_vertex vertices[7];
+        monotone_vertex stack[7];
+        link_test_points(points, coords, count);
+        for (size_t i = 0; i < count; i++) {
+                points[i].index = (uint32_t)i;
+                vertices[i].point = points + i;
+                vertices[i].side = sides[i];
+        }
+        shrinkwrap * sw = create_shrink_wrap(count);
+        triangulate_monotone_polygon(sw, ALPHA_FULL, vertices, count, stack);
+        array * indices = sw->indicesFullAlpha;
+        float area = 0.f;
+        for (size_t i = 0; i < array_size(indices); i += 3) {
+                float t = turn(points + get_index(indices, i), points + get_index(indices, i + 1),
+                               points + get_index(indices, i + 2));
+                mu_assert("Triangle is not wound like the zipper", t > 0.f);
+                area += t * 0.5f;
+        }
+        mu_equals_int(18, (int)area);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// Expanding the strip must give back every triangle once, wound as in the list.
+char * check_stripify(primitive mode, size_t stride) {
+        // a fan around vertex 0 and a separate triangle
+        const uint32_t list[] = {0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 5, 6, 7, 8};
+        const size_t count = sizeof(list) / sizeof(list[0]);
+        array * indices = array_create(count, stride);
+        for (size_t i = 0; i < count; i++) push_index(indices, list[i]);
+        array * strip = stripify_indices(indices, mode);
+        mu_equals_int((int)stride, (int)array_stride(strip));
+        strip_builder builder;
+        builder.indices = list;
+        int found[5] = {0};
+        size_t first = 0;
+        for (size_t k = 0; k + 2 < array_size(strip); k++) {
+                uint32_t a = get_index(strip, k);
+                uint32_t b = get_index(strip, k + 1);
+                uint32_t c = get_index(strip, k + 2);
+                if (a == shrinkwrap_restart_index) {
+                        mu_assert("Restart index in degenerate strip", mode == PRIMITIVE_STRIP_RESTART);
+                        first = k + 1;
+                        continue;
+                }
+                if (b == shrinkwrap_restart_index || c == shrinkwrap_restart_index) continue;
+                if (a == b || b == c || c == a) continue;
+                // Odd triangles of a strip reverse their first two vertices
+                int odd = ((k - first) % 2) == 1;
+                int matched = FALSE;
+                for (uint32_t t = 0; t < 5; t++) {
+                        if (winding_matches(&builder, t, odd ? b : a, odd ? a : b, c)) {
+                                mu_assert("Triangle drawn twice", found[t] == 0);
+                                found[t] = 1;
+                                matched = TRUE;
+                        }
+                }
+                mu_assert("Strip triangle not in list or wound differently", matched);
+        }
+        for (int t = 0; t < 5; t++) mu_equals_int(1, found[t]);
+        mu_assert("Strip is no smaller than the list", array_size(strip) < count);
+        array_destroy(strip);
+        array_destroy(indices);
+        return NULL;
+}
+
+char * test_stripify() {
+        mu_run_test(check_stripify(PRIMITIVE_STRIP_DEGENERATE, INDEX_WIDTH_32));
+        mu_run_test(check_stripify(PRIMITIVE_STRIP_RESTART, INDEX_WIDTH_32));
+        mu_run_test(check_stripify(PRIMITIVE_STRIP_DEGENERATE, INDEX_WIDTH_16));
+        mu_run_test(check_stripify(PRIMITIVE_STRIP_RESTART, INDEX_WIDTH_16));
+        return NULL;
+}
+
+// Index lists narrow to 16 bits while every index and the restart index fit.
+char * test_index_width() {
+        shrinkwrap * sw = create_shrink_wrap(0xFFFF);
+        mu_equals_int(INDEX_WIDTH_16, sw->indexWidth);
+        mu_equals_int((int)sizeof(uint16_t), (int)array_stride(sw->indicesFullAlpha));
+        push_index(sw->indicesFullAlpha, 0xFFFE);
+        push_index(sw->indicesFullAlpha, shrinkwrap_restart_index);
+        mu_assert("16-bit index not read back", get_index(sw->indicesFullAlpha, 0) == 0xFFFE);
+        mu_assert("16-bit restart not read back", get_index(sw->indicesFullAlpha, 1) == shrinkwrap_restart_index);
+        destroy_shrinkwrap(sw);
+        sw = create_shrink_wrap(0x10000);
+        mu_equals_int(INDEX_WIDTH_32, sw->indexWidth);
+        push_index(sw->indicesPartialAlpha, 0xFFFF);
+        mu_assert("32-bit index not read back", get_index(sw->indicesPartialAlpha, 0) == 0xFFFF);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// A grid drawn in a scattered order must come back with fewer cache misses and the same triangles.
+char * test_vertex_cache() {
+        const uint32_t side = 8;
+        const size_t triangles = (side - 1) * (side - 1) * 2;
+        array * indices = array_create(triangles * 3, sizeof(uint32_t));
+        for (size_t i = 0; i < triangles; i++) {
+                // Visit the triangles with a stride coprime to their count
+                size_t t = (i * 37) % triangles;
+                uint32_t cell = (uint32_t)(t / 2);
+                uint32_t x = cell % (side - 1);
+                uint32_t y = cell / (side - 1);
+                uint32_t v = y * side + x;
+                if (t % 2 == 0) {
+                        push_index(indices, v);
+                        push_index(indices, v + 1);
+                        push_index(indices, v + side);
+                } else {
+                        push_index(indices, v + 1);
+                        push_index(indices, v + side + 1);
+                        push_index(indices, v + side);
+                }
+        }
+        uint32_t before[(8 - 1) * (8 - 1) * 2 * 3];
+        memcpy(before, array_get(indices, 0), sizeof(before));
+        size_t missesBefore = simulate_cache_misses(indices, 16);
+        optimise_indices(indices, side * side);
+        size_t missesAfter = simulate_cache_misses(indices, 16);
+        mu_assert("Reordering did not reduce cache misses", missesAfter < missesBefore);
+        strip_builder builder;
+        builder.indices = before;
+        for (size_t i = 0; i < triangles; i++) {
+                const uint32_t * t = (const uint32_t *)array_get(indices, i * 3);
+                int matched = FALSE;
+                for (uint32_t j = 0; j < triangles && matched == FALSE; j++) {
+                        matched = winding_matches(&builder, j, t[0], t[1], t[2]);
+                }
+                mu_assert("Reordered triangle not in list or wound differently", matched);
+        }
+        array_destroy(indices);
+        return NULL;
+}
+
+// Unused vertices go, coincident ones merge and the triangles keep their positions.
+char * test_compact_vertices() {
+        const float positions[][2] = {{0, 0}, {9, 9}, {4, 0}, {0, 4}, {4, 0}, {4, 4}};
+        const uint32_t full[] = {0, 2, 3};
+        const uint32_t partial[] = {3, 4, 5};
+        shrinkwrap * sw = create_shrink_wrap(6);
+        for (size_t v = 0; v < 6; v++) {
+                vertp vertex = add_vert(sw->vertices);
+                vertex->x = positions[v][0];
+                vertex->y = positions[v][1];
+        }
+        for (size_t i = 0; i < 3; i++) {
+                push_index(sw->indicesFullAlpha, full[i]);
+                push_index(sw->indicesPartialAlpha, partial[i]);
+        }
+        compact_vertices(sw);
+        mu_equals_int(4, (int)array_size(sw->vertices));
+        for (size_t i = 0; i < 3; i++) {
+                vertp before = get_vert(sw->vertices, get_index(sw->indicesFullAlpha, i));
+                mu_assert("Full triangle moved", before->x == positions[full[i]][0] &&
+                          before->y == positions[full[i]][1]);
+                vertp after = get_vert(sw->vertices, get_index(sw->indicesPartialAlpha, i));
+                mu_assert("Partial triangle moved", after->x == positions[partial[i]][0] &&
+                          after->y == positions[partial[i]][1]);
+        }
+        // Welded vertices are shared between the lists and numbered by first use
+        mu_equals_int(1, (int)get_index(sw->indicesPartialAlpha, 1));
+        mu_equals_int(3, (int)get_index(sw->indicesPartialAlpha, 2));
+        destroy_shrinkwrap(sw);
+        // A frame compacted below 65536 vertices narrows its indices
+        sw = create_shrink_wrap(0x10000);
+        for (uint32_t v = 0; v < 0x10000; v++) {
+                vertp vertex = add_vert(sw->vertices);
+                vertex->x = (float)v;
+                vertex->y = 0.f;
+        }
+        push_index(sw->indicesFullAlpha, 0);
+        push_index(sw->indicesFullAlpha, 0x8000);
+        push_index(sw->indicesFullAlpha, 0xFFFF);
+        compact_vertices(sw);
+        mu_equals_int(INDEX_WIDTH_16, sw->indexWidth);
+        mu_equals_int((int)sizeof(uint16_t), (int)array_stride(sw->indicesFullAlpha));
+        mu_equals_int(2, (int)get_index(sw->indicesFullAlpha, 2));
+        mu_assert("Narrowed index moved", get_vert(sw->vertices, 2)->x == (float)0xFFFF);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// Half pixel positions come back exactly and everything else within half a quantisation step.
+char * test_quantise_vertices() {
+        const vert verts[] = {{-3.5f, 12.0f, 0.25f, 0.5f}, {100.5f, -0.5f, 0.375f, 0.5f}, {7.3f, 2.0f, 0.3f, 0.5f}};
+        shrinkwrap * sw = create_shrink_wrap(3);
+        for (size_t i = 0; i < 3; i++) {
+                *add_vert(sw->vertices) = verts[i];
+        }
+        quantise_vertices(sw);
+        mu_equals_int(VERTEX_FORMAT_QUANTISED, sw->vertexFormat);
+        mu_equals_int(3, (int)array_size(sw->quantisedVertices));
+        const vertex_quantisation * q = &sw->quantisation;
+        for (size_t i = 0; i < 3; i++) {
+                vert back = dequantise_vertex(q, (const quantised_vert *)array_get(sw->quantisedVertices, i));
+                if (i < 2) {
+                        mu_assert("Half pixel position not exact", back.x == verts[i].x && back.y == verts[i].y);
+                }
+                mu_assert("Position error too large", fabsf(back.x - verts[i].x) <= q->scale.x * 0.5f);
+                mu_assert("UV error too large", fabsf(back.u - verts[i].u) <= q->scale.u * 0.5f + 1e-7f);
+                mu_assert("Flat UV not kept", back.v == verts[i].v);
+        }
+        mu_assert("Max error not recorded", q->maxError.x > 0.f && q->maxError.x <= 0.25f);
+        mu_assert("Default scale not half pixel", q->scale.x == 0.5f);
+        mu_assert("Large frame not rescaled", position_scale(40000.f) == 2.0f);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// The uv transform rebuilds the UVs set_texture_coordinates gives, and position-only frames are written without them.
+char * test_position_vertices() {
+        const vert verts[] = {{0.0f, 0.0f, 0.0f, 0.0f}, {31.5f, 4.0f, 0.0f, 0.0f}, {7.0f, 19.5f, 0.0f, 0.0f}};
+        shrinkwrap * sw = create_shrink_wrap(3);
+        for (size_t i = 0; i < 3; i++) {
+                *add_vert(sw->vertices) = verts[i];
+                push_index(sw->indicesPartialAlpha, (uint32_t)i);
+        }
+        set_texture_coordinates(sw, 100.0f, 60.0f, 256.0f, 128.0f, -3.0f, 2.5f);
+        for (size_t i = 0; i < 3; i++) {
+                const vert * v = get_vert(sw->vertices, i);
+                vert back = apply_uv_transform(&sw->uvTransform, v->x, v->y);
+                mu_assert("UV not rebuilt", fabsf(back.u - v->u) < 1e-6f && fabsf(back.v - v->v) < 1e-6f);
+        }
+        mu_equals_int(8, (int)vertex_format_size(VERTEX_FORMAT_POSITION));
+        mu_equals_int(4, (int)vertex_format_size(VERTEX_FORMAT_QUANTISED_POSITION));
+        drop_texture_coordinates(sw);
+        mu_equals_int(VERTEX_FORMAT_POSITION, sw->vertexFormat);
+        FILE * file = tmpfile();
+        const char * name = "run_0";
+        mu_assert("Binary not written", save_binary(file, &sw, &name, 1, 256, 128));
+        size_t size = (size_t)ftell(file);
+        uint8_t * data = (uint8_t *)malloc(size);
+        rewind(file);
+        mu_assert("Binary not read", fread(data, 1, size, file) == size);
+        fclose(file);
+        binary_frame frame;
+        mu_assert("Frame not found", find_binary_frame(data, size, name, &frame));
+        mu_equals_int(VERTEX_FORMAT_POSITION, frame.vertexFormat);
+        mu_assert("UV transform not stored", memcmp(&frame.uvTransform, &sw->uvTransform, sizeof(uv_transform)) == 0);
+        const uint8_t * p = data + frame.vertexOffset + 2 * vertex_format_size(VERTEX_FORMAT_POSITION);
+        mu_assert("Position not packed", get_binary_f32(p) == get_vert(sw->vertices, 2)->x &&
+                  get_binary_f32(p + 4) == get_vert(sw->vertices, 2)->y);
+        mu_assert("Partial indices overlap vertices", frame.partialOffset >= frame.vertexOffset + 3 * 8);
+        free(data);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// Areas and counts must not depend on whether the lists were stripped.
+char * test_measure_shrinkwrap() {
+        const float positions[][2] = {{0, 0}, {2, 0}, {2, 2}, {0, 2}, {4, 0}};
+        const uint32_t full[] = {0, 1, 2, 0, 2, 3};
+        const uint32_t partial[] = {1, 4, 2};
+        shrinkwrap * sw = create_shrink_wrap(5);
+        for (size_t v = 0; v < 5; v++) {
+                vertp vertex = add_vert(sw->vertices);
+                vertex->x = positions[v][0];
+                vertex->y = positions[v][1];
+        }
+        for (size_t i = 0; i < 6; i++) push_index(sw->indicesFullAlpha, full[i]);
+        for (size_t i = 0; i < 3; i++) push_index(sw->indicesPartialAlpha, partial[i]);
+        for (int pass = 0; pass < 2; pass++) {
+                shrinkwrap_stats stats;
+                measure_shrinkwrap(sw, &stats);
+                mu_assert("Opaque area wrong", stats.fullFill == 4.0);
+                mu_assert("Blended area wrong", stats.partialFill == 2.0);
+                mu_equals_int(3, (int)stats.triangles);
+                mu_equals_int(5, (int)stats.vertices);
+                if (pass == 0) {
+                        stripify(sw, PRIMITIVE_STRIP_RESTART);
+                        mu_equals_int(PRIMITIVE_STRIP_RESTART, sw->primitiveType);
+                }
+        }
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// An opaque square wants splitting, unless vertices are too dear; then a quad covering the frame replaces it.
+char * test_choose_mesh() {
+        const float positions[][2] = {{0, 0}, {8, 0}, {8, 8}, {0, 8}};
+        const uint32_t full[] = {0, 1, 2, 0, 2, 3};
+        shrinkwrap * sw = create_shrink_wrap(4);
+        for (size_t v = 0; v < 4; v++) {
+                vertp vertex = add_vert(sw->vertices);
+                vertex->x = positions[v][0];
+                vertex->y = positions[v][1];
+        }
+        for (size_t i = 0; i < 6; i++) push_index(sw->indicesFullAlpha, full[i]);
+        device_profile cheapVertices = {"test", 1.0f, 1.0f, 0.5f};
+        device_profile dearVertices = {"test", 1000.0f, 1.0f, 0.5f};
+        mu_equals_int(MESH_SPLIT, choose_mesh(sw, &cheapVertices, 10.f, 10.f));
+        mu_assert("Split cost wrong", mesh_cost(sw, &cheapVertices, MESH_SPLIT, 10.f, 10.f) == 4.f + 32.f);
+        mu_assert("Hull cost wrong", mesh_cost(sw, &cheapVertices, MESH_HULL, 10.f, 10.f) == 4.f + 64.f);
+        mu_equals_int(MESH_QUAD, choose_mesh(sw, &dearVertices, 4.f, 4.f));
+        apply_mesh_choice(sw, MESH_QUAD, 4.f, 4.f, 0.5f);
+        mu_equals_int(MESH_QUAD, sw->meshType);
+        shrinkwrap_stats stats;
+        measure_shrinkwrap(sw, &stats);
+        mu_assert("Quad does not cover the frame", stats.partialFill == 16.0 && stats.fullFill == 0.0);
+        mu_equals_int(4, (int)stats.vertices);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// A panel with a partial-alpha border: its opaque inside becomes a quad, and the border meshed in four parts covers the
+// same area as meshing the whole panel.
+char * test_opaque_cores() {
+        const pxl_size w = 40;
+        const pxl_size h = 24;
+        tpxl * tpixels = (tpxl *)malloc(w * h);
+        for (pxl_size y = 0; y < h; y++) {
+                for (pxl_size x = 0; x < w; x++) {
+                        int border = x < 2 || y < 2 || x >= w - 2 || y >= h - 2;
+                        tpixels[y * w + x] = border ? ALPHA_PARTIAL : ALPHA_FULL;
+                }
+        }
+        pixel_rect cores[2];
+        pixel_rect regions[7];
+        size_t coreCount = 0;
+        size_t count = split_opaque_cores(tpixels, w, h, 8, 2, 2, cores, &coreCount, regions);
+        mu_equals_int(1, (int)coreCount);
+        mu_equals_int(4, (int)count);
+        // The inside is rows 2 to 21 of columns 2 to 37, less the columns the left and right parts take
+        mu_assert("Core in the wrong place", cores[0].x == 4 && cores[0].y == 2 && cores[0].w == 32 &&
+                  cores[0].h == 20);
+        shrinkwrap * parts[7];
+        for (size_t r = 0; r < count; r++) {
+                tpxl * cropped = crop_typemap(tpixels, w, regions + r);
+                curve_list * cl = build_curves(cropped, regions[r].w, regions[r].h);
+                parts[r] = triangulate_monotone(cl);
+                destroy_curve_list(cl);
+                free(cropped);
+        }
+        shrinkwrap * sw = merge_shrinkwraps(parts, regions, count, cores, coreCount);
+        curve_list * cl = build_curves(tpixels, w, h);
+        shrinkwrap * whole = triangulate_monotone(cl);
+        shrinkwrap_stats split;
+        shrinkwrap_stats expected;
+        measure_shrinkwrap(sw, &split);
+        measure_shrinkwrap(whole, &expected);
+        mu_assert("Opaque area differs", split.fullFill == expected.fullFill);
+        mu_assert("Blended area differs", split.partialFill == expected.partialFill);
+        for (size_t r = 0; r < count; r++) {
+                destroy_shrinkwrap(parts[r]);
+        }
+        destroy_shrinkwrap(sw);
+        destroy_shrinkwrap(whole);
+        destroy_curve_list(cl);
+        free(tpixels);
+        return NULL;
+}
+
+// A panel with a partial border, an opaque inside with a transparent pixel in it and two partial pixels that only touch
+// at a corner.  Raw contours mesh to exactly the classified pixels; simplified ones never grow the opaque area nor
+// uncover a visible pixel.
+char * test_contours() {
+        const pxl_size w = 12;
+        const pxl_size h = 10;
+        tpxl * tpixels = (tpxl *)calloc(w * h, sizeof(tpxl));
+        for (pxl_size y = 1; y <= 8; y++) {
+                for (pxl_size x = 1; x <= 8; x++) {
+                        int inside = x >= 3 && x <= 6 && y >= 3 && y <= 6;
+                        tpixels[y * w + x] = inside ? ALPHA_FULL : ALPHA_PARTIAL;
+                }
+        }
+        tpixels[4 * w + 4] = ALPHA_ZERO;
+        tpixels[1 * w + 10] = ALPHA_PARTIAL;
+        tpixels[2 * w + 11] = ALPHA_PARTIAL;
+        for (int pass = 0; pass < 2; pass++) {
+                contour_list * cl = trace_contours(tpixels, w, h);
+                // Visible: the panel, its hole and both corner pixels.  Opaque: the inside and its hole.
+                mu_equals_int(6, (int)array_size(cl->contours));
+                if (pass == 1) {
+                        simplify_contours(cl, 1.0f);
+                }
+                shrinkwrap * sw = triangulate_contours(cl);
+                shrinkwrap_stats stats;
+                measure_shrinkwrap(sw, &stats);
+                if (pass == 0) {
+                        mu_assert("Opaque area wrong", stats.fullFill == 15.0);
+                        mu_assert("Blended area wrong", stats.partialFill == 50.0);
+                } else {
+                        mu_assert("Opaque area grew", stats.fullFill <= 15.0);
+                        mu_assert("Visible area shrank", stats.fullFill + stats.partialFill >= 65.0);
+                }
+                destroy_shrinkwrap(sw);
+                destroy_contour_list(cl);
+        }
+        free(tpixels);
+        return NULL;
+}
+
+// Contours bound whole pixels and are not moved when placed, so a quad chosen for a contour mesh spans the same rows.
+char * test_contour_quad() {
+        const pxl_size w = 6;
+        const pxl_size h = 5;
+        tpxl * tpixels = (tpxl *)malloc(w * h);
+        memset(tpixels, ALPHA_PARTIAL, w * h);
+        contour_list * cl = trace_contours(tpixels, w, h);
+        shrinkwrap * sw = triangulate_contours(cl);
+        float top = INFINITY;
+        float bottom = -INFINITY;
+        for (size_t v = 0; v < array_size(sw->vertices); v++) {
+                vertp vertex = (vertp)array_get(sw->vertices, v);
+                top = fminf(top, vertex->y);
+                bottom = fmaxf(bottom, vertex->y);
+        }
+        mu_assert("Contour does not bound the frame", top == 0.f && bottom == (float)h);
+        apply_mesh_choice(sw, MESH_QUAD, (float)w, (float)h, 0.f);
+        mu_equals_int(4, (int)array_size(sw->vertices));
+        for (size_t v = 0; v < 4; v++) {
+                vertp vertex = (vertp)array_get(sw->vertices, v);
+                mu_assert("Quad moved off the contour rows", vertex->y == top || vertex->y == bottom);
+        }
+        destroy_shrinkwrap(sw);
+        destroy_contour_list(cl);
+        free(tpixels);
+        return NULL;
+}
+
+// A diamond of partial pixels around an opaque square.  Dividing until nothing is wasted blends exactly the partial
+// pixels and fills exactly the opaque ones; allowing the whole frame to be wasted draws one hull.
+char * test_decompose_hulls() {
+        const pxl_size w = 16;
+        const pxl_size h = 16;
+        tpxl * tpixels = (tpxl *)calloc(w * h, sizeof(tpxl));
+        size_t partial = 0;
+        for (pxl_size y = 0; y < h; y++) {
+                for (pxl_size x = 0; x < w; x++) {
+                        int dx = abs((int)x * 2 - 15);
+                        int dy = abs((int)y * 2 - 15);
+                        if (dx <= 3 && dy <= 3) {
+                                tpixels[y * w + x] = ALPHA_FULL;
+                        } else if (dx + dy <= 16) {
+                                tpixels[y * w + x] = ALPHA_PARTIAL;
+                                partial++;
+                        }
+                }
+        }
+        shrinkwrap * sw = decompose_hulls(tpixels, w, h, 0.0f);
+        shrinkwrap_stats stats;
+        measure_shrinkwrap(sw, &stats);
+        mu_assert("Opaque area wrong", stats.fullFill == 16.0);
+        mu_assert("Blended area wrong", stats.partialFill == (double)partial);
+        destroy_shrinkwrap(sw);
+        sw = decompose_hulls(tpixels, w, h, (float)(w * h));
+        measure_shrinkwrap(sw, &stats);
+        mu_assert("Hull drawn opaque", stats.fullFill == 0.0);
+        mu_assert("Hull misses visible pixels", stats.partialFill >= (double)partial + 16.0);
+        // One fan
+        mu_equals_int((int)array_size(sw->vertices) - 2, (int)array_size(sw->indicesPartialAlpha) / 3);
+        destroy_shrinkwrap(sw);
+        free(tpixels);
+        return NULL;
+}
+
+// A blended quad two pixels too big all round shrinks onto the partial square it covers.
+char * test_refine_shrinkwrap() {
+        const pxl_size w = 16;
+        const pxl_size h = 16;
+        tpxl * tpixels = (tpxl *)calloc(w * h, sizeof(tpxl));
+        for (pxl_size y = 4; y < 12; y++) {
+                for (pxl_size x = 4; x < 12; x++) {
+                        tpixels[y * w + x] = ALPHA_PARTIAL;
+                }
+        }
+        const float positions[][2] = {{2, 2}, {14, 2}, {14, 14}, {2, 14}};
+        const uint32_t partial[] = {0, 1, 2, 0, 2, 3};
+        shrinkwrap * sw = create_shrink_wrap(4);
+        for (size_t v = 0; v < 4; v++) {
+                vertp vertex = add_vert(sw->vertices);
+                memset(vertex, 0, sizeof(vert));
+                vertex->x = positions[v][0];
+                vertex->y = positions[v][1];
+        }
+        for (size_t i = 0; i < 6; i++) push_index(sw->indicesPartialAlpha, partial[i]);
+        refine_options options = {0.0, 2000, 2, 8.0f, 1};
+        refine_report report;
+        refine_shrinkwrap(sw, tpixels, w, h, 0.0f, &options, &report);
+        // 80 transparent pixels blended plus two triangles
+        mu_assert("Start fitness wrong", report.startFitness == 96.0);
+        mu_assert("Mesh did not shrink", report.fitness == 16.0);
+        mu_equals_int(6, (int)array_size(sw->indicesPartialAlpha));
+        destroy_shrinkwrap(sw);
+        free(tpixels);
+        return NULL;
+}
+
+// Classifying and refining a frame must depend only on its pixels.  Dilation once read the row after the frame, so
+// the same frame followed by different memory classified, and so refined, differently.  Each frame here is followed
+// by a row of different pixels, and both are refined on several islands.
+char * test_refine_repeatable() {
+        const pxl_size w = 24;
+        const pxl_size h = 20;
+        refine_report reports[2];
+        tpxl * dilated[2];
+        for (int run = 0; run < 2; run++) {
+                tpxl * tpixels = (tpxl *)calloc(w * (h + 1), sizeof(tpxl));
+                for (pxl_size y = 0; y < h; y++) {
+                        for (pxl_size x = 0; x < w; x++) {
+                                int d = abs((int)x - 12) + abs((int)y - 14);
+                                tpixels[y * w + x] = (d < 5) ? ALPHA_FULL : (d < 9) ? ALPHA_PARTIAL : ALPHA_ZERO;
+                        }
+                }
+                memset(tpixels + w * h, run == 0 ? ALPHA_ZERO : ALPHA_PARTIAL, w);
+                dilated[run] = dilate_alpha(tpixels, w, h, 3);
+                free(tpixels);
+                curve_list * cl = build_curves(dilated[run], w, h);
+                smooth_curves_ex(cl, 4.0f, w, h, NULL);
+                shrinkwrap * sw = triangulate(cl);
+                destroy_curve_list(cl);
+                refine_options options = {0.0, 200, 3, 8.0f, 1};
+                refine_shrinkwrap(sw, dilated[run], w, h, 0.5f, &options, reports + run);
+                destroy_shrinkwrap(sw);
+        }
+        mu_assert("Classification read past the frame", memcmp(dilated[0], dilated[1], w * h) == 0);
+        mu_assert("Start fitness differs", reports[0].startFitness == reports[1].startFitness);
+        mu_assert("Fitness differs", reports[0].fitness == reports[1].fitness);
+        mu_equals_int((int)reports[0].mutations, (int)reports[1].mutations);
+        mu_equals_int((int)reports[0].accepted, (int)reports[1].accepted);
+        free(dilated[0]);
+        free(dilated[1]);
+        return NULL;
+}
+
+// A blended strip beside an opaque one, each cut into a pair of triangles per row as scanline meshes are.  Merging
+// leaves two triangles per strip, drops the row ends that lie along the sides and keeps both areas.
+char * test_merge_convex() {
+        const uint32_t rows = 4;
+        const float columns[] = {0.0f, 4.0f, 6.0f};
+        shrinkwrap * sw = create_shrink_wrap(rows * 3);
+        for (size_t c = 0; c < 3; c++) {
+                for (uint32_t r = 0; r < rows; r++) {
+                        vertp vertex = add_vert(sw->vertices);
+                        memset(vertex, 0, sizeof(vert));
+                        vertex->x = columns[c];
+                        vertex->y = (float)r;
+                }
+        }
+        for (uint32_t c = 0; c < 2; c++) {
+                array * indices = (c == 0) ? sw->indicesPartialAlpha : sw->indicesFullAlpha;
+                for (uint32_t r = 0; r + 1 < rows; r++) {
+                        uint32_t left = c * rows + r;
+                        uint32_t right = left + rows;
+                        push_index(indices, left);
+                        push_index(indices, right);
+                        push_index(indices, right + 1);
+                        push_index(indices, left);
+                        push_index(indices, right + 1);
+                        push_index(indices, left + 1);
+                }
+        }
+        merge_convex(sw);
+        mu_equals_int(6, (int)array_size(sw->indicesPartialAlpha));
+        mu_equals_int(6, (int)array_size(sw->indicesFullAlpha));
+        mu_equals_int(6, (int)array_size(sw->vertices));
+        shrinkwrap_stats stats;
+        measure_shrinkwrap(sw, &stats);
+        mu_assert("Blended area changed", stats.partialFill == 12.0);
+        mu_assert("Opaque area changed", stats.fullFill == 6.0);
+        destroy_shrinkwrap(sw);
+        return NULL;
+}
+
+// A float frame and a quantised frame written out, found again by name and read back from their blobs.
+char * test_binary_output() {
+        const vert verts[] = {{0.0f, 0.0f, 0.0f, 0.0f}, {4.0f, 0.0f, 0.5f, 0.0f}, {4.0f, 2.5f, 0.5f, 0.25f}};
+        shrinkwrap * shrinkwraps[2];
+        for (size_t f = 0; f < 2; f++) {
+                shrinkwrap * sw = create_shrink_wrap(3);
+                for (size_t i = 0; i < 3; i++) {
+                        *add_vert(sw->vertices) = verts[i];
+                }
+                push_index(f == 0 ? sw->indicesPartialAlpha : sw->indicesFullAlpha, 0);
+                push_index(f == 0 ? sw->indicesPartialAlpha : sw->indicesFullAlpha, 1);
+                push_index(f == 0 ? sw->indicesPartialAlpha : sw->indicesFullAlpha, 2);
+                sw->origX = 10.0f * f;
+                shrinkwraps[f] = sw;
+        }
+        quantise_vertices(shrinkwraps[1]);
+        const char * names[] = {"walk_0", "walk_1"};
+        FILE * file = tmpfile();
+        mu_assert("Binary not written", save_binary(file, shrinkwraps, names, 2, 64, 32));
+        size_t size = (size_t)ftell(file);
+        uint8_t * data = (uint8_t *)malloc(size);
+        rewind(file);
+        mu_assert("Binary not read", fread(data, 1, size, file) == size);
+        fclose(file);
+        mu_assert("Size not aligned", size % binary_alignment == 0);
+        binary_header header;
+        mu_assert("Header rejected", read_binary_header(data, size, &header));
+        mu_equals_int(2, (int)header.frameCount);
+        mu_equals_int(64, (int)header.atlasWidth);
+        mu_assert("Truncated file accepted", read_binary_header(data, size - 1, &header) == FALSE);
+        binary_frame frame;
+        mu_assert("Missing frame found", find_binary_frame(data, size, "walk_2", &frame) == FALSE);
+        for (size_t f = 0; f < 2; f++) {
+                mu_assert("Frame not found", find_binary_frame(data, size, names[f], &frame));
+                mu_assert("Origin wrong", frame.origX == 10.0f * f);
+                mu_equals_int(3, (int)frame.vertexCount);
+                uint32_t partialCount = (f == 0) ? 3 : 0;
+                mu_equals_int(partialCount, frame.partialCount);
+                mu_equals_int(3 - partialCount, frame.fullCount);
+                mu_equals_int(INDEX_WIDTH_16, frame.indexWidth);
+                mu_assert("Blob not aligned", frame.vertexOffset % binary_alignment == 0 &&
+                          frame.partialOffset % binary_alignment == 0 && frame.fullOffset % binary_alignment == 0);
+                const uint8_t * indices = data + (f == 0 ? frame.partialOffset : frame.fullOffset);
+                mu_equals_int(2, get_binary_u16(indices + 4));
+                for (size_t i = 0; i < 3; i++) {
+                        vert v;
+                        if (f == 0) {
+                                const uint8_t * p = data + frame.vertexOffset + i * sizeof(vert);
+                                v.x = get_binary_f32(p);
+                                v.y = get_binary_f32(p + 4);
+                        } else {
+                                const uint8_t * p = data + frame.vertexOffset + i * sizeof(quantised_vert);
+                                v.x = (int16_t)get_binary_u16(p) * frame.scale.x + frame.bias.x;
+                                v.y = (int16_t)get_binary_u16(p + 2) * frame.scale.y + frame.bias.y;
+                        }
+                        mu_assert("Vertex wrong", v.x == verts[i].x && v.y == verts[i].y);
+                }
+        }
+        free(data);
+        destroy_shrinkwrap(shrinkwraps[0]);
+        destroy_shrinkwrap(shrinkwraps[1]);
+        return NULL;
+}
+
+// The compressed container inflates back to the plain file, whether it is loaded whole or pushed a byte at a time, and
+// the delta transforms wrap at the width of their values.
+char * test_compressed_binary() {
+        uint8_t values[8];
+        const uint16_t indices[] = {7, 3, 0xFFFF, 4};
+        for (size_t i = 0; i < 4; i++) {
+                put_binary_u16(values + i * 2, indices[i]);
+        }
+        delta_encode_binary(values, 4, sizeof(uint16_t), 1);
+        mu_equals_int(14, get_binary_u16(values));
+        mu_equals_int(7, get_binary_u16(values + 2));
+        mu_equals_int(7, get_binary_u16(values + 4));
+        delta_decode_binary(values, 4, sizeof(uint16_t), 1);
+        for (size_t i = 0; i < 4; i++) {
+                mu_equals_int(indices[i], get_binary_u16(values + i * 2));
+        }
+        shrinkwrap * shrinkwraps[2];
+        for (size_t f = 0; f < 2; f++) {
+                shrinkwrap * sw = create_shrink_wrap(40);
+                for (size_t i = 0; i < 40; i++) {
+                        vert v = {1.5f * i, 40.0f - i, 0.25f * i, 0.5f};
+                        *add_vert(sw->vertices) = v;
+                        push_index(sw->indicesPartialAlpha, (uint32_t)(i * 7 % 40));
+                }
+                shrinkwraps[f] = sw;
+        }
+        quantise_vertices(shrinkwraps[1]);
+        const char * names[] = {"idle_0", "idle_1"};
+        FILE * plainFile = tmpfile();
+        mu_assert("Binary not written", save_binary(plainFile, shrinkwraps, names, 2, 64, 64));
+        size_t plainSize = (size_t)ftell(plainFile);
+        uint8_t * plain = (uint8_t *)malloc(plainSize);
+        rewind(plainFile);
+        mu_assert("Binary not read", fread(plain, 1, plainSize, plainFile) == plainSize);
+        fclose(plainFile);
+        FILE * file = tmpfile();
+        mesh_sink * sink = create_compressed_binary_sink(file, 9, BINARY_TRANSFORM_ALL);
+        int written = sink->begin(sink, 64, 64);
+        written = sink->frame(sink, shrinkwraps[0], names[0]) && written;
+        written = sink->frame(sink, shrinkwraps[1], names[1]) && written;
+        written = sink->end(sink) && written;
+        sink->destroy(sink);
+        mu_assert("Compressed binary not written", written);
+        size_t size = (size_t)ftell(file);
+        mu_assert("Not compressed", size < plainSize);
+        rewind(file);
+        size_t loadedSize = 0;
+        uint8_t * loaded = load_binary(file, &loadedSize);
+        mu_assert("Compressed binary not loaded", loaded != NULL);
+        mu_assert("Inflated file differs", loadedSize == plainSize && memcmp(loaded, plain, plainSize) == 0);
+        free(loaded);
+        uint8_t * data = (uint8_t *)malloc(size);
+        rewind(file);
+        mu_assert("Compressed binary not read", fread(data, 1, size, file) == size);
+        fclose(file);
+        binary_inflater * inflater = binary_inflater_create();
+        for (size_t i = 0; i + 1 < size; i++) {
+                mu_assert("Byte rejected", binary_inflater_push(inflater, data + i, 1));
+        }
+        mu_assert("Truncated stream accepted", binary_inflater_finish(inflater, &loadedSize) == NULL);
+        binary_inflater_destroy(inflater);
+        inflater = binary_inflater_create();
+        for (size_t i = 0; i < size; i++) {
+                binary_inflater_push(inflater, data + i, 1);
+        }
+        loaded = binary_inflater_finish(inflater, &loadedSize);
+        binary_inflater_destroy(inflater);
+        mu_assert("Streamed file differs", loaded && loadedSize == plainSize && memcmp(loaded, plain, plainSize) == 0);
+        free(loaded);
+        data[binary_container_size + 8] ^= 0xFF;
+        inflater = binary_inflater_create();
+        int accepted = binary_inflater_push(inflater, data, size);
+        loaded = binary_inflater_finish(inflater, &loadedSize);
+        binary_inflater_destroy(inflater);
+        mu_assert("Corrupt stream accepted", accepted == FALSE || loaded == NULL);
+        free(loaded);
+        uint8_t * fileSize = data + binary_container_size - binary_header_size + 36;
+        fileSize[0] = fileSize[1] = fileSize[2] = fileSize[3] = 0xFF;
+        inflater = binary_inflater_create();
+        mu_assert("Oversized file accepted", binary_inflater_push(inflater, data, size) == FALSE);
+        binary_inflater_destroy(inflater);
+        free(data);
+        free(plain);
+        destroy_shrinkwrap(shrinkwraps[0]);
+        destroy_shrinkwrap(shrinkwraps[1]);
+        return NULL;
+}
+
+// Shortest round-trip text for floats, in both the plain and scientific ranges and across the 64-bit and big integer
+// paths.
+char * test_format_float() {
+        const float values[] = {0.1f, 1.0f / 3.0f, 16777216.0f, 1e30f, -0.0f, 1.4e-45f, 123456789.0f, 10.5f, 0.0001f,
+                                2.5e-5f, 3.4028235e38f};
+        const char * const expected[] = {"0.1", "0.33333334", "16777216", "1e30", "-0", "1e-45", "123456790", "10.5",
+                                         "0.0001", "2.5e-5", "3.4028235e38"};
+        char text[TEXT_FLOAT_SIZE];
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+                format_float(values[i], text);
+                mu_assert("Float text wrong", strcmp(text, expected[i]) == 0);
+        }
+        // Every 9973rd bit pattern reads back exactly
+        for (uint32_t bits = 0; bits < 0x7F800000; bits += 9973) {
+                float value;
+                memcpy(&value, &bits, sizeof(value));
+                size_t length = format_float(value, text);
+                mu_assert("Float text too long", length < TEXT_FLOAT_SIZE);
+                mu_assert("Float does not round trip", strtof(text, NULL) == value);
+        }
+        return NULL;
+}
+
+// A small buffer written on the background thread gives the same bytes as one written in place, including printf
+// output longer than the buffer.
+char * test_textwriter() {
+        char * contents[2];
+        size_t sizes[2];
+        for (int background = 0; background < 2; background++) {
+                FILE * file = tmpfile();
+                textwriter * writer = background ? textwriter_create_background(file, 32) : textwriter_create(file, 32);
+                for (int i = 0; i < 200; i++) {
+                        textwriter_printf(writer, "\t\t\tcontext.lineTo(%f, %f);\n", i * 0.25f, -i * 4.0f);
+                        textwriter_float(writer, i / 7.0f);
+                        textwriter_char(writer, ',');
+                        textwriter_int(writer, -i);
+                }
+                textwriter_printf(writer, "%s\n", "a line longer than the 32-byte buffer it is written through");
+                mu_assert("Write failed", textwriter_flush(writer));
+                textwriter_destroy(writer);
+                sizes[background] = (size_t)ftell(file);
+                contents[background] = (char *)malloc(sizes[background]);
+                rewind(file);
+                mu_assert("Read failed", fread(contents[background], 1, sizes[background], file) == sizes[background]);
+                fclose(file);
+        }
+        mu_assert("Sizes differ", sizes[0] == sizes[1]);
+        mu_assert("Contents differ", memcmp(contents[0], contents[1], sizes[0]) == 0);
+        const char * first = "\t\t\tcontext.lineTo(0.000000, 0.000000);\n0,0\t";
+        mu_assert("Line lost", memcmp(contents[0], first, strlen(first)) == 0);
+        free(contents[0]);
+        free(contents[1]);
+        return NULL;
+}
+
+// A memory writer keeps everything written to it, growing past its starting capacity.
+char * test_textwriter_memory() {
+        textwriter * writer = textwriter_create_memory(8);
+        for (int i = 0; i < 100; i++) {
+                textwriter_printf(writer, "frame %d of %d\n", i, 100);
+        }
+        mu_assert("Flush failed", textwriter_flush(writer));
+        size_t length = 0;
+        const char * text = textwriter_contents(writer, &length);
+        mu_assert("Text lost", length > 100 * strlen("frame 0 of 100\n"));
+        mu_assert("First line lost", strncmp(text, "frame 0 of 100\nframe 1 of 100\n", 30) == 0);
+        mu_assert("Last line lost", strcmp(text + length - strlen("frame 99 of 100\n"), "frame 99 of 100\n") == 0);
+        textwriter_destroy(writer);
+        return NULL;
+}
+
+typedef struct taskpool_test_struct {
+        pthread_mutex_t lock;
+        size_t * runs;
+        size_t fanout;
+} taskpool_test;
+
+static void taskpool_test_task(taskpool * pool, void * context, size_t task)
+{
+        taskpool_test * t = (taskpool_test *)context;
+        if (task < t->fanout) {
+                for (size_t i = 0; i < t->fanout; i++) {
+                        taskpool_submit(pool, taskpool_test_task, t, t->fanout + task * t->fanout + i);
+                }
+        }
+        pthread_mutex_lock(&t->lock);
+        t->runs[task]++;
+        pthread_mutex_unlock(&t->lock);
+}
+
+// Every task runs exactly once, including tasks submitted by tasks, whatever the number of threads.
+char * test_taskpool() {
+        const size_t fanout = 16;
+        const size_t count = fanout + fanout * fanout;
+        for (size_t threads = 1; threads <= 4; threads++) {
+                taskpool_test t;
+                pthread_mutex_init(&t.lock, NULL);
+                t.runs = (size_t *)calloc(count, sizeof(size_t));
+                t.fanout = fanout;
+                taskpool * pool = taskpool_create(threads);
+                for (size_t i = 0; i < fanout; i++) {
+                        taskpool_submit(pool, taskpool_test_task, &t, i);
+                }
+                taskpool_wait(pool);
+                taskpool_destroy(pool);
+                for (size_t i = 0; i < count; i++) {
+                        mu_assert("Task not run exactly once", t.runs[i] == 1);
+                }
+                free(t.runs);
+                pthread_mutex_destroy(&t.lock);
+        }
+        return NULL;
+}
+
+static void * workqueue_test_producer(void * data)
+{
+        workqueue * queue = (workqueue *)data;
+        static size_t items[100];
+        for (size_t i = 0; i < 100; i++) {
+                items[i] = i;
+                workqueue_push(queue, items + i);
+        }
+        workqueue_close(queue);
+        return NULL;
+}
+
+// Items pushed through a queue smaller than the run come out once each, in order, and pop returns NULL once the
+// queue is closed and empty.
+char * test_workqueue() {
+        workqueue * queue = workqueue_create(2);
+        pthread_t producer;
+        pthread_create(&producer, NULL, workqueue_test_producer, queue);
+        size_t expected = 0;
+        size_t * item;
+        while ((item = (size_t *)workqueue_pop(queue)) != NULL) {
+                mu_assert("Item out of order", *item == expected);
+                expected++;
+        }
+        pthread_join(producer, NULL);
+        mu_assert("Items lost", expected == 100);
+        mu_assert("Closed queue not empty", workqueue_pop(queue) == NULL);
+        workqueue_destroy(queue);
+        return NULL;
+}
+
 char * test_shrinkwrap_internal() {
         mu_run_test(test_optimise());
         mu_run_test(test_conserve_direction());
+        mu_run_test(test_simplifiers());
+        mu_run_test(test_smooth_parallel());
+        mu_run_test(test_self_intersection_left());
+        mu_run_test(test_intersect_batch());
+        mu_run_test(test_monotone_polygon());
+        mu_run_test(test_stripify());
+        mu_run_test(test_vertex_cache());
+        mu_run_test(test_index_width());
+        mu_run_test(test_compact_vertices());
+        mu_run_test(test_quantise_vertices());
+        mu_run_test(test_position_vertices());
+        mu_run_test(test_measure_shrinkwrap());
+        mu_run_test(test_choose_mesh());
+        mu_run_test(test_opaque_cores());
+        mu_run_test(test_contours());
+        mu_run_test(test_contour_quad());
+        mu_run_test(test_decompose_hulls());
+        mu_run_test(test_refine_shrinkwrap());
+        mu_run_test(test_refine_repeatable());
+        mu_run_test(test_merge_convex());
+        mu_run_test(test_binary_output());
+        mu_run_test(test_compressed_binary());
+        mu_run_test(test_format_float());
+        mu_run_test(test_textwriter());
+        mu_run_test(test_textwriter_memory());
+        mu_run_test(test_taskpool());
+        mu_run_test(test_workqueue());
         return NULL;
 }
 
@@ -0,0 +1,55 @@
+//
+//  shrinkwrap_monotone_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_monotone_internal_h
+#define shrinkwrap_monotone_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+typedef enum chain_enum {
+        CHAIN_LEFT,
+        CHAIN_RIGHT
+} chain;
+
+typedef struct monotone_vertex_struct {
+        const CP * point;
+        chain side;
+} monotone_vertex;
+
+// Scratch space reused across the regions of one curve_list
+typedef struct monotone_buffer_struct {
+        array * left;
+        array * right;
+        monotone_vertex * merged;
+        monotone_vertex * stack;
+        size_t capacity;
+} monotone_buffer;
+
+shrinkwrap * triangulate_monotone(curve_list * cl);
+void collect_monotone_chains(const CN * left, monotone_buffer * buffer);
+size_t merge_monotone_chains(monotone_buffer * buffer);
+void triangulate_monotone_polygon(shrinkwrap * sw, alpha a, const monotone_vertex * vertices, size_t count,
+                                  monotone_vertex * stack);
+int vertex_above(const vert * a, const vert * b);
+int doubles_back(const CP * a, const CP * b, const CP * c);
+void add_oriented_triangle(shrinkwrap * sw, alpha a, const CP * p1, const CP * p2, const CP * p3);
+float turn(const CP * a, const CP * b, const CP * c);
+#endif
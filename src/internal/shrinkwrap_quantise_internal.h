@@ -0,0 +1,40 @@
+//
+//  shrinkwrap_quantise_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_quantise_internal_h
+#define shrinkwrap_quantise_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// Positions are stored on a half pixel grid unless the frame is too large for int16
+static const float c_position_step = 0.5f;
+
+void quantise_vertices(shrinkwrap * sw);
+vert dequantise_vertex(const vertex_quantisation * quantisation, const quantised_vert * q);
+float position_scale(float maxMagnitude);
+void drop_texture_coordinates(shrinkwrap * sw);
+vert apply_uv_transform(const uv_transform * transform, float x, float y);
+int vertex_format_is_quantised(vertex_format format);
+int vertex_format_has_uvs(vertex_format format);
+size_t vertex_format_size(vertex_format format);
+const char * vertex_format_name(vertex_format format);
+int vertex_format_from_name(const char * name, vertex_format * outFormat);
+#endif
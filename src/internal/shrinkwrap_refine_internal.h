@@ -0,0 +1,100 @@
+//
+//  shrinkwrap_refine_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_refine_internal_h
+#define shrinkwrap_refine_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+typedef struct refine_triangle_struct {
+        uint32_t corner[3];
+        // Sign of the triangle's area, which mutations may not flip
+        int8_t orientation;
+        uint8_t full;
+        uint8_t alive;
+} refine_triangle;
+
+// Bounds of the triangles a mutation touches, in mesh coordinates
+typedef struct refine_bounds_struct {
+        float minX;
+        float minY;
+        float maxX;
+        float maxY;
+} refine_bounds;
+
+// One (1+1)-ES population: a mesh, how many triangles of each alpha type cover each pixel and its fitness
+typedef struct refine_island_struct {
+        vert * positions;
+        refine_triangle * triangles;
+        uint16_t * partialCover;
+        uint16_t * fullCover;
+        double fitness;
+        uint32_t random;
+        // Standard deviation of vertex moves, adapted by the 1/5 success rule
+        float sigma;
+        size_t moves;
+        size_t movesAccepted;
+        size_t mutations;
+        size_t accepted;
+        // Triangles touched by the current mutation and their state before it
+        size_t * affected;
+        refine_triangle * saved;
+} refine_island;
+
+typedef struct refine_state_struct {
+        const tpxl * tpixels;
+        pxl_size width;
+        pxl_size height;
+        float shiftY;
+        float triangleCost;
+        size_t vertexCount;
+        size_t triangleCount;
+        refine_island * islands;
+        size_t islandCount;
+        // Mutations each island tries this epoch
+        size_t epochIterations;
+        // Wall-clock time to stop at, or 0
+        double deadline;
+} refine_state;
+
+void refine_shrinkwrap(shrinkwrap * sw, const tpxl * tpixels, pxl_size w, pxl_size h, float shiftY,
+                       const refine_options * options, refine_report * outReport);
+
+// Islands
+void init_refine_island(refine_state * s, refine_island * island, const shrinkwrap * sw, uint32_t seed);
+void destroy_refine_island(refine_island * island);
+void copy_refine_island(const refine_state * s, refine_island * to, const refine_island * from);
+int mutate_refine_island(const refine_state * s, refine_island * island);
+int move_refine_vertex(const refine_state * s, refine_island * island, uint32_t v, size_t count);
+int collapse_refine_vertex(const refine_state * s, refine_island * island, uint32_t v, uint32_t to, size_t count);
+
+// Fitness
+double refine_fitness(const refine_state * s, const refine_island * island);
+double refine_region_cost(const refine_state * s, const refine_island * island, const refine_bounds * bounds);
+float refine_pixel_cost(alpha a, uint32_t partial, uint32_t full);
+void raster_refine_triangle(const refine_state * s, refine_island * island, const refine_triangle * t, int delta);
+void refine_triangle_bounds(const refine_island * island, const refine_triangle * t, refine_bounds * inOutBounds);
+int refine_pixel_rect(const refine_state * s, const refine_bounds * bounds, pixel_rect * outRect);
+float refine_triangle_area(const refine_island * island, const refine_triangle * t);
+uint32_t refine_random(refine_island * island);
+float refine_gaussian(refine_island * island);
+double refine_now_milliseconds(void);
+#endif
@@ -0,0 +1,41 @@
+//
+//  shrinkwrap_simplify_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_simplify_internal_h
+#define shrinkwrap_simplify_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+// Simplifiers
+void simplify_curve(C * c, float w, float bleed, simplifier method);
+void simplify_douglas_peucker(C * c, CP ** points, size_t count, float w, float bleed);
+void simplify_visvalingam_whyatt(C * c, CP ** points, size_t count, float w, float bleed);
+void simplify_reumann_witkam(C * c, CP ** points, size_t count, float w, float bleed);
+const char * simplifier_name(simplifier method);
+int simplifier_from_name(const char * name, simplifier * outMethod);
+
+// Tolerance contract
+float chord_x(const CP * a, const CP * b, float y);
+int chord_allowed(const C * c, const CP * a, const CP * b, CP * p, float w, float bleed);
+int span_allowed(const C * c, const CP * a, const CP * b, float w, float bleed);
+int is_fixed_point(CP ** points, size_t count, size_t i);
+void remove_span(CP ** points, size_t first, size_t last);
+#endif
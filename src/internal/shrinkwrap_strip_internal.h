@@ -0,0 +1,54 @@
+//
+//  shrinkwrap_strip_internal.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_strip_internal_h
+#define shrinkwrap_strip_internal_h
+
+#include "shrinkwrap_internal_t.h"
+
+static const uint32_t c_no_triangle = 0xFFFFFFFF;
+
+// Triangle adjacency and progress for stripifying one index list
+typedef struct strip_builder_struct {
+        const uint32_t * indices;
+        size_t triangles;
+        // Triangle across each edge; edge e of triangle t runs from vertex e to vertex e + 1
+        uint32_t * adjacent;
+        uch * used;
+        // Marks triangles taken by the strip currently being tried
+        uint32_t * trial;
+        uint32_t attempt;
+} strip_builder;
+
+void stripify(shrinkwrap * sw, primitive mode);
+array * stripify_indices(array * indices, primitive mode);
+const char * primitive_name(primitive mode);
+int primitive_from_name(const char * name, primitive * outMode);
+int next_triangle(array * indices, primitive mode, size_t * inOutPosition, uint32_t * outTriangle);
+
+void build_adjacency(strip_builder * builder);
+uint32_t find_adjacent(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b);
+uint32_t opposite_vertex(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b);
+int winding_matches(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b, uint32_t c);
+size_t grow_strip(strip_builder * builder, uint32_t triangle, int rotation, array * strip, int commit);
+uint32_t choose_strip_start(const strip_builder * builder);
+void join_strip(array * out, const uint32_t * strip, size_t count, primitive mode);
+#endif
@@ -23,7 +23,19 @@
 #define shrinkwrap_triangle_internal_h
 #include "shrinkwrap_internal_t.h"
 
+// Segments tested against one line per call to intersect_batch, stored as structure-of-arrays lanes
+#define SEGMENT_BATCH_SIZE 4
+typedef struct segment_batch_struct {
+        float ax[SEGMENT_BATCH_SIZE];
+        float ay[SEGMENT_BATCH_SIZE];
+        float dx[SEGMENT_BATCH_SIZE];
+        float dy[SEGMENT_BATCH_SIZE];
+        size_t count;
+} segment_batch;
+
 CN * find_next_curve(CP * p, C * c, int skip);
+shrinkwrap * triangulate(curve_list * cl);
+shrinkwrap * triangulate_ex(curve_list * cl, triangulation engine);
 int point_line_has_curve(const CP * p, const C * c);
 
 int self_intersection_curve_left(const vert * a1, const vert * b1, float stopy, const CP * first);
@@ -40,6 +52,9 @@ int triangle_is_degenerate(const CP * p1, const CP * p2, const CP * p3);
 void add_triangle(shrinkwrap * shrinkwrap, alpha a, const CP * p1, const CP * p2,
                  const CP * p3);
 int intersect(const vert * a1, const vert * b1, const vert * a2, const vert * b2);
+void segment_batch_clear(segment_batch * batch);
+void segment_batch_add(segment_batch * batch, const vert * a, const vert * b);
+int intersect_batch(const vert * a1, const vert * b1, const segment_batch * batch);
 CP * get_next_right(CP * pr, const CP * pl, C * left, const CN ** inOutRight);
 
 float lineInwards(const vert * a1, const vert * b1, const vert * a2, const vert * b2, int right);
@@ -53,6 +68,8 @@ int self_intersection(const CP * l, CP * r, const CP * rprev2,
 uint32_t assign_indices(curve_list * cl);
 shrinkwrap * create_shrink_wrap(uint32_t numverts);
 void destroy_shrinkwrap(shrinkwrap * sw);
+void set_texture_coordinates(shrinkwrap * geometry, float framex, float framey, float texturewidth,
+                                 float textureheight, float frameoffsetx, float frameoffsety);
 void add_vertices(shrinkwrap * sw, curve_list * cl);
 int point_is_same(const CP * a, const CP * b);
 int triangle_is_degenerate(const CP * p1, const CP * p2, const CP * p3);
@@ -20,15 +20,25 @@
 //  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
 //
 
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 199309L
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
 #include <string.h>
+#include <time.h>
+#include <pthread.h>
 #include "xmlload.h"
 #include "pngload.h"
 #include "shrinkwrap.h"
 #include "shrinkwrap_html.h"
+#include "shrinkwrap_binary.h"
+#include "shrinkwrap_csv.h"
 #include "array.h"
+#include "taskpool.h"
+#include "textwriter.h"
+#include "workqueue.h"
 #define PROGNAME "shrinkwrap"
 #define VERSION "0.0.0"
 #define LONGNAME "Shrink wrap geometry creator for the Starling shrinkWrap extension"
@@ -39,6 +49,48 @@
 #endif
 
 static const size_t XML_BUFFER_SIZE = 8192;
+
+typedef enum output_format_enum {
+        OUTPUT_HTML,
+        OUTPUT_BINARY,
+        OUTPUT_CSV,
+        OUTPUT_COUNT
+} output_format;
+
+static const char * const c_outputFormatNames[] = {"html", "binary", "csv"};
+
+typedef struct options_struct {
+        const char * pngFilename;
+        const char * xmlFilename;
+        const char * outFilename;
+        const char * statsFilename;
+        // Meshes every atlas listed in this manifest instead of the one named on the command line
+        const char * batchFilename;
+        smooth_options smooth;
+        refine_options refine;
+        mesh_engine engine;
+        triangulation triangulator;
+        primitive primitiveType;
+        int optimiseCache;
+        int compact;
+        vertex_format vertexFormat;
+        // Chooses between quad, hull and split meshes per frame when set
+        const device_profile * device;
+        device_profile customDevice;
+        // Draws large full-alpha rectangles as quads and traces only the regions around them when set
+        int opaqueCores;
+        // Merges each frame's triangles into convex polygons and re-fans them when set
+        int mergeConvex;
+        output_format format;
+        // Deflates binary output, see create_compressed_binary_sink
+        int compress;
+        // Threads meshing frames at once; 0 or 1 meshes them one after another
+        size_t jobs;
+        // Writes the traced and smoothed borders of every frame to data/curves.html and data/curves-smooth.html
+        int diagnostics;
+        int benchmark;
+} options;
+
 xml_image * loadXML(FILE ** file, const char * filename)
 {
         if (!(*file = fopen(filename, "r"))) {
@@ -48,8 +100,10 @@ xml_image * loadXML(FILE ** file, const char * filename)
         return processXML(*file, XML_BUFFER_SIZE);
 }
 
-void loadPNG(readpng_contextp context, FILE ** file, const char * filename, uch ** outPixels, size_t * outWidth,
-             size_t * outHeight)
+// Returns 0 once the image is decoded, or the status to exit with: 2 if the file can't be read, 3 if it can't be
+// decoded.
+int loadPNG(readpng_contextp context, FILE ** file, const char * filename, uch ** outPixels, size_t * outWidth,
+            size_t * outHeight)
 {
         *outPixels = NULL;
         *outWidth = 0;
@@ -85,13 +139,12 @@ void loadPNG(readpng_contextp context, FILE ** file, const char * filename, uch
                 if (error) {
                         fclose(*file);
                         *file = NULL;
-                        return;
+                        return 3;
                 }
         }
         
         if (error) {
-                fprintf(stderr, PROGNAME ":  aborting.\n");
-                exit(2);
+                return 2;
         }
         
         /* if the user didn't specify a background color on the command line,
@@ -103,77 +156,940 @@ void loadPNG(readpng_contextp context, FILE ** file, const char * filename, uch
                 fclose(*file);
                 *file = NULL;
                 fprintf(stderr, PROGNAME ":  libpng error while checking for background color\n");
-                exit(2);
+                return 2;
         }
         
         *outPixels = readpng_get_image(context, display_exponent, &image_channels, &image_rowbytes);
         *outWidth = image_width;
         *outHeight = image_height;
+        return *outPixels ? 0 : 3;
+}
+
+static const pxl_size c_bleed = 3;
+static const float c_smoothBleed = 4.0;
+// Pixels a convex hull may blend needlessly before decompose_hulls divides it
+static const float c_hullWaste = 64.0;
+// Misclassified pixels refinement trades for one triangle
+static const float c_refineTriangleCost = 8.0;
+// Diagnostic pages are written out a buffer of this size at a time
+static const size_t c_diagnosticBufferSize = 1 << 20;
+// zlib level for --compress; meshes are small enough that the slowest is still quick
+static const int c_compressionLevel = 9;
+
+// TEMP: WIP - frames that are traced but not yet meshed
+int isSkippedFrame(int i)
+{
+        return i == 30 || i == 31;
+}
+
+// Classify the frame's pixels by alpha type.
+tpxl * classifyFrame(const xml_image * image, uch * imageAtlasRGBA, pxl_size atlasWidth)
+{
+        const pxl_pos x = image->x;
+        const pxl_pos y = image->y;
+        const pxl_pos w = image->width;
+        const pxl_pos height = image->height;
+        tpxl * typePixels = generate_typemap(imageAtlasRGBA, x, y, w, height, atlasWidth);
+        tpxl * antiDither = reduce_dither(typePixels, w, height, c_bleed);
+        tpxl * dilated = dilate_alpha(antiDither, w, height, c_bleed);
+        free(typePixels);
+        free(antiDither);
+        return dilated;
+}
+
+// Classify the frame's pixels and trace the borders between alpha types.
+curve_list * traceFrame(const xml_image * image, uch * imageAtlasRGBA, pxl_size atlasWidth)
+{
+        tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+        curve_list * cl = build_curves(finalPixels, image->width, image->height);
+        free(finalPixels);
+        return cl;
+}
+
+static const pxl_size c_coreMinSide = 32;
+// Wider than c_smoothBleed, so smoothing never snaps a curve onto the inner edge of a region beside a core
+static const pxl_size c_coreOverlap = 5;
+#define MAX_CORES 4
+
+// Diagnostic writers are NULL unless --diagnostics is given.
+void drawCurves(textwriter * diagnostic, curve_list * cl, float x, float y)
+{
+        if (diagnostic) {
+                html_draw_curves(diagnostic, cl, x, y);
+        }
+}
+
+// Open a diagnostic page, written out on a background thread.
+textwriter * openDiagnostic(const char * filename, FILE ** outFile, pxl_size atlasWidth, pxl_size atlasHeight)
+{
+        *outFile = fopen(filename, "w");
+        if (*outFile == NULL) {
+                fprintf(stderr, PROGNAME ":  unable to open diagnostic file [%s]\n", filename);
+                return NULL;
+        }
+        textwriter * diagnostic = textwriter_create_background(*outFile, c_diagnosticBufferSize);
+        html_prologue(diagnostic, atlasWidth, atlasHeight);
+        return diagnostic;
+}
+
+void closeDiagnostic(textwriter * diagnostic, FILE * file)
+{
+        if (diagnostic == NULL) return;
+        html_epilogue(diagnostic);
+        if (textwriter_flush(diagnostic) == FALSE) {
+                fprintf(stderr, PROGNAME ":  unable to write diagnostic file\n");
+        }
+        textwriter_destroy(diagnostic);
+        fclose(file);
+}
+
+// Draw a frame's largest full-alpha rectangles as quads, then trace, smooth and triangulate the regions around them.
+// Regions are cut through the middle of shapes, leaving long straight edges that the zipper cannot fill without
+// overlapping triangles, so they are always swept by the monotone engine.
+shrinkwrap * meshFrameCores(textwriter * log, textwriter * curvesFile, textwriter * smoothFile, int frame,
+                            const xml_image * image, uch * imageAtlasRGBA, pxl_size atlasWidth, const options * opts)
+{
+        tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+        pixel_rect cores[MAX_CORES];
+        pixel_rect regions[MAX_CORES * 3 + 1];
+        size_t coreCount = 0;
+        size_t count = split_opaque_cores(finalPixels, image->width, image->height, c_coreMinSide, c_coreOverlap,
+                                          MAX_CORES, cores, &coreCount, regions);
+        shrinkwrap * parts[MAX_CORES * 3 + 1];
+        for (size_t r = 0; r < count; r++) {
+                const pixel_rect * region = regions + r;
+                tpxl * cropped = crop_typemap(finalPixels, image->width, region);
+                curve_list * cl = build_curves(cropped, region->w, region->h);
+                drawCurves(curvesFile, cl, image->x + region->x, image->y + region->y);
+                smooth_curves_ex(cl, c_smoothBleed, region->w, region->h, &opts->smooth);
+                drawCurves(smoothFile, cl, image->x + region->x, image->y + region->y);
+                parts[r] = triangulate_ex(cl, TRIANGULATE_MONOTONE);
+                destroy_curve_list(cl);
+                free(cropped);
+        }
+        shrinkwrap * sw = merge_shrinkwraps(parts, regions, count, cores, coreCount);
+        for (size_t r = 0; r < count; r++) {
+                destroy_shrinkwrap(parts[r]);
+        }
+        free(finalPixels);
+        textwriter_printf(log, "frame %d: %zu opaque cores, %zu regions traced\n", frame, coreCount, count);
+        return sw;
 }
 
-void processImageList(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth,
-                      pxl_size atlasHeight)
+// Trace the frame's visible and opaque borders as closed contours, simplify them and ear clip them.
+shrinkwrap * meshFrameContours(textwriter * curvesFile, textwriter * smoothFile, const xml_image * image,
+                               uch * imageAtlasRGBA, pxl_size atlasWidth)
 {
-        char * outFilename = "data/curves.html";
-        FILE * outFile = fopen(outFilename, "w");
-        html_prologue(outFile, (float)atlasWidth, (float)atlasHeight);
-        char * outFilename2 = "data/curves-smooth.html";
-        FILE * outFile2 = fopen(outFilename2, "w");
-        html_prologue(outFile2, (float)atlasWidth, (float)atlasHeight);
-        array * shrinkwraps = array_create(64, sizeof(shrinkwrap *));
+        tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+        contour_list * cl = trace_contours(finalPixels, image->width, image->height);
+        free(finalPixels);
+        if (curvesFile) {
+                html_draw_contours(curvesFile, cl, image->x, image->y);
+        }
+        simplify_contours(cl, c_smoothBleed);
+        if (smoothFile) {
+                html_draw_contours(smoothFile, cl, image->x, image->y);
+        }
+        shrinkwrap * sw = triangulate_contours(cl);
+        destroy_contour_list(cl);
+        return sw;
+}
+
+// Divide the frame into opaque quads and blended convex hulls.
+shrinkwrap * meshFrameHulls(const xml_image * image, uch * imageAtlasRGBA, pxl_size atlasWidth)
+{
+        tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+        shrinkwrap * sw = decompose_hulls(finalPixels, image->width, image->height, c_hullWaste);
+        free(finalPixels);
+        return sw;
+}
+
+// Scanline meshes stop a row short of the frame, so they are centred on it by moving them down half a pixel.
+// Contours bound whole pixels and are not moved.
+static const float c_scanlineShiftY = 0.5f;
+
+// Place a triangulated frame in texture space.
+void placeFrame(shrinkwrap * sw, const xml_image * image, pxl_size atlasWidth, pxl_size atlasHeight, float shiftY)
+{
+        const pxl_pos x = image->x;
+        const pxl_pos y = image->y;
+        const pxl_diff frameOffsetX = image->xOffset;
+        const pxl_diff frameOffsetY = image->yOffset;
+        const pxl_pos frameX = ((pxl_diff)x + frameOffsetX < 0) ? 0 : (x + frameOffsetX);
+        const pxl_pos frameY = ((pxl_diff)y + frameOffsetY < 0) ? 0 : (y + frameOffsetY);
+        set_texture_coordinates(sw, frameX, frameY, atlasWidth, atlasHeight, frameOffsetX,
+                                    frameOffsetY - shiftY);
+        sw->origX = frameX;
+        sw->origY = frameY;
+}
+
+static const size_t c_reportedCacheSize = 16;
+
+// Choose the cheapest mesh for a frame on the device and report the costs.
+void costFrame(textwriter * log, shrinkwrap * sw, int frame, const device_profile * device, const xml_image * image,
+               float shiftY)
+{
+        float costs[MESH_COUNT];
+        for (int choice = 0; choice < MESH_COUNT; choice++) {
+                costs[choice] = mesh_cost(sw, device, (mesh_choice)choice, image->width, image->height);
+        }
+        mesh_choice choice = choose_mesh(sw, device, image->width, image->height);
+        apply_mesh_choice(sw, choice, image->width, image->height, shiftY);
+        textwriter_printf(log, "frame %d: quad %.0f, hull %.0f, split %.0f -> %s\n", frame, costs[MESH_QUAD],
+                          costs[MESH_HULL], costs[MESH_SPLIT], mesh_choice_name(choice));
+}
+
+// Reorder a frame's triangles for the vertex cache and report the change in cache misses.
+void optimiseFrame(textwriter * log, shrinkwrap * sw, int frame)
+{
+        float before = vertex_cache_acmr(sw, c_reportedCacheSize);
+        optimise_vertex_cache(sw);
+        float after = vertex_cache_acmr(sw, c_reportedCacheSize);
+        textwriter_printf(log, "frame %d: ACMR %.3f -> %.3f\n", frame, before, after);
+}
+
+// Evolve a frame's mesh against its pixels and report the change in fitness and triangle count.
+void refineFrame(textwriter * log, shrinkwrap * sw, int frame, const xml_image * image, uch * imageAtlasRGBA,
+                 pxl_size atlasWidth, float shiftY, const refine_options * refine)
+{
+        size_t before = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+        refine_report report;
+        refine_shrinkwrap(sw, finalPixels, image->width, image->height, shiftY, refine, &report);
+        free(finalPixels);
+        size_t after = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        textwriter_printf(log, "frame %d: fitness %.1f -> %.1f, %zu -> %zu triangles, %zu of %zu mutations kept\n",
+                          frame, report.startFitness, report.fitness, before, after, report.accepted,
+                          report.mutations);
+}
+
+// Merge a frame's triangles into convex polygons and report the change in triangle count.
+void mergeFrame(textwriter * log, shrinkwrap * sw, int frame)
+{
+        size_t before = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        merge_convex(sw);
+        size_t after = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        textwriter_printf(log, "frame %d: %zu -> %zu triangles, %zu saved by convex merging\n", frame, before, after,
+                          before - after);
+}
+
+// Compact a frame's vertices and report the change in vertex count.
+void compactFrame(textwriter * log, shrinkwrap * sw, int frame)
+{
+        size_t before = array_size(sw->vertices);
+        compact_vertices(sw);
+        textwriter_printf(log, "frame %d: %zu -> %zu vertices\n", frame, before, array_size(sw->vertices));
+}
+
+// Quantise a frame's vertices and report the largest error in pixels and texels.
+void quantiseFrame(textwriter * log, shrinkwrap * sw, int frame, pxl_size atlasWidth, pxl_size atlasHeight)
+{
+        quantise_vertices(sw);
+        const vert * error = &sw->quantisation.maxError;
+        float positionError = (error->x > error->y) ? error->x : error->y;
+        float texelErrorU = error->u * (float)atlasWidth;
+        float texelErrorV = error->v * (float)atlasHeight;
+        float texelError = (texelErrorU > texelErrorV) ? texelErrorU : texelErrorV;
+        textwriter_printf(log, "frame %d: %zu bytes -> %zu bytes per vertex, max error %.4f px, %.4f texels\n", frame,
+                          sizeof(vert), sizeof(quantised_vert), positionError, texelError);
+}
+
+// Leave the UVs of a frame to its uv transform and report the vertex size saved.
+void dropFrameUVs(textwriter * log, shrinkwrap * sw, int frame)
+{
+        size_t before = vertex_format_size(sw->vertexFormat);
+        drop_texture_coordinates(sw);
+        textwriter_printf(log, "frame %d: %zu bytes -> %zu bytes per vertex, uv = (x, y) * (%g, %g) + (%g, %g)\n",
+                          frame, before, vertex_format_size(sw->vertexFormat), sw->uvTransform.scaleU,
+                          sw->uvTransform.scaleV, sw->uvTransform.biasU, sw->uvTransform.biasV);
+}
+
+// Convert a frame's geometry to strips and report the change in index count.
+void stripFrame(textwriter * log, shrinkwrap * sw, int frame, primitive mode)
+{
+        size_t before = array_size(sw->indicesFullAlpha) + array_size(sw->indicesPartialAlpha);
+        stripify(sw, mode);
+        size_t after = array_size(sw->indicesFullAlpha) + array_size(sw->indicesPartialAlpha);
+        float percent = (before > 0) ? 100.0f * (float)after / (float)before : 100.0f;
+        textwriter_printf(log, "frame %d: %zu triangle indices, %zu %s indices (%.1f%%)\n", frame, before, after,
+                          primitive_name(sw->primitiveType), percent);
+}
+
+// Write a CSV row comparing a mesh's blended and opaque areas with drawing its frame as one blended quad.
+void writeStatsRow(textwriter * output, const char * name, const char * mesh, double quadArea,
+                   const shrinkwrap_stats * stats)
+{
+        double saved = quadArea - stats->partialFill;
+        double percent = (quadArea > 0.0) ? 100.0 * saved / quadArea : 0.0;
+        csvField(output, name);
+        textwriter_printf(output, ",%s,%.1f,%.1f,%.1f,%.1f,%.1f,%zu,%zu\n", mesh, quadArea, stats->partialFill,
+                          stats->fullFill, saved, percent, stats->triangles, stats->vertices);
+}
+
+// A frame and everything meshing it writes, held until the frames before it have been written so that output is
+// the same whatever order frames finish in.
+typedef struct frame_job_struct {
+        xml_image * image;
+        int frame;
+        // NULL for skipped frames
+        shrinkwrap * sw;
+        // Created when meshing starts; the diagnostic ones are NULL unless diagnostics are written
+        textwriter * log;
+        textwriter * curves;
+        textwriter * smooth;
+        int done;
+} frame_job;
+
+// Shared by every frame task.  The members after 'lock' are only used with it held.
+typedef struct frame_batch_struct {
+        const options * opts;
+        uch * imageAtlasRGBA;
+        pxl_size atlasWidth;
+        pxl_size atlasHeight;
+        frame_job * jobs;
+        size_t count;
+        pthread_mutex_t lock;
+        size_t nextWritten;
+        mesh_sink * sink;
+        int written;
+        textwriter * curvesFile;
+        textwriter * smoothFile;
+        FILE * curvesOutput;
+        FILE * smoothOutput;
+        textwriter * statsFile;
+        FILE * statsOutput;
+        shrinkwrap_stats totals;
+        double totalQuadArea;
+} frame_batch;
+
+static const size_t c_frameLogSize = 256;
+static const size_t c_statsBufferSize = 1 << 12;
+static const size_t c_frameDiagnosticSize = 1 << 14;
+
+// Mesh one frame into its job.  Only reads what other frames share.
+void meshFrame(const frame_batch * batch, frame_job * job)
+{
+        const options * opts = batch->opts;
+        xml_image * image = job->image;
+        uch * imageAtlasRGBA = batch->imageAtlasRGBA;
+        pxl_size atlasWidth = batch->atlasWidth;
+        job->log = textwriter_create_memory(c_frameLogSize);
+        job->curves = opts->diagnostics ? textwriter_create_memory(c_frameDiagnosticSize) : NULL;
+        job->smooth = opts->diagnostics ? textwriter_create_memory(c_frameDiagnosticSize) : NULL;
+        textwriter * log = job->log;
+        int i = job->frame;
+        curve_list * cl = NULL;
+        shrinkwrap * sw = NULL;
+        float shiftY = c_scanlineShiftY;
+        if (opts->engine == ENGINE_CONTOUR && isSkippedFrame(i) == FALSE) {
+                sw = meshFrameContours(job->curves, job->smooth, image, imageAtlasRGBA, atlasWidth);
+                shiftY = 0.0f;
+        } else if (opts->engine == ENGINE_HULL && isSkippedFrame(i) == FALSE) {
+                sw = meshFrameHulls(image, imageAtlasRGBA, atlasWidth);
+                shiftY = 0.0f;
+        } else if (opts->opaqueCores && isSkippedFrame(i) == FALSE) {
+                sw = meshFrameCores(log, job->curves, job->smooth, i, image, imageAtlasRGBA, atlasWidth, opts);
+        } else {
+                cl = traceFrame(image, imageAtlasRGBA, atlasWidth);
+                drawCurves(job->curves, cl, image->x, image->y);
+                if (isSkippedFrame(i)) {
+                        destroy_curve_list(cl);
+                        return;
+                }
+                smooth_curves_ex(cl, c_smoothBleed, image->width, image->height, &opts->smooth);
+                drawCurves(job->smooth, cl, image->x, image->y);
+                sw = triangulate_ex(cl, opts->triangulator);
+                destroy_curve_list(cl);
+        }
+        if (opts->refine.milliseconds > 0.0 || opts->refine.iterations > 0) {
+                refineFrame(log, sw, i, image, imageAtlasRGBA, atlasWidth, shiftY, &opts->refine);
+        }
+        if (opts->mergeConvex) {
+                mergeFrame(log, sw, i);
+        }
+        if (opts->device) {
+                costFrame(log, sw, i, opts->device, image, shiftY);
+        }
+        if (opts->optimiseCache) {
+                optimiseFrame(log, sw, i);
+        }
+        if (opts->compact) {
+                compactFrame(log, sw, i);
+        }
+        if (opts->primitiveType != PRIMITIVE_TRIANGLES) {
+                stripFrame(log, sw, i, opts->primitiveType);
+        }
+        placeFrame(sw, image, atlasWidth, batch->atlasHeight, shiftY);
+        if (vertex_format_is_quantised(opts->vertexFormat)) {
+                quantiseFrame(log, sw, i, atlasWidth, batch->atlasHeight);
+        }
+        if (vertex_format_has_uvs(opts->vertexFormat) == FALSE) {
+                dropFrameUVs(log, sw, i);
+        }
+        job->sw = sw;
+}
+
+// Copy a frame's buffered text to where it belongs and free it.
+void writeFrameText(textwriter * text, textwriter * destination, FILE * file)
+{
+        if (text == NULL) return;
+        size_t length = 0;
+        const char * contents = textwriter_contents(text, &length);
+        if (destination) {
+                textwriter_write(destination, contents, length);
+        } else if (file) {
+                fwrite(contents, 1, length, file);
+        }
+        textwriter_destroy(text);
+}
+
+// Write out a finished frame and free it.  Called with the batch locked, in frame order.
+void writeFrame(frame_batch * batch, frame_job * job)
+{
+        writeFrameText(job->log, NULL, stdout);
+        writeFrameText(job->curves, batch->curvesFile, NULL);
+        writeFrameText(job->smooth, batch->smoothFile, NULL);
+        shrinkwrap * sw = job->sw;
+        if (sw == NULL) return;
+        xml_image * image = job->image;
+        if (batch->statsFile) {
+                shrinkwrap_stats stats;
+                measure_shrinkwrap(sw, &stats);
+                double quadArea = (double)image->width * image->height;
+                char frameName[32];
+                snprintf(frameName, sizeof(frameName), "frame %d", job->frame);
+                writeStatsRow(batch->statsFile, image->name ? image->name : frameName, mesh_choice_name(sw->meshType),
+                              quadArea, &stats);
+                batch->totalQuadArea += quadArea;
+                batch->totals.partialFill += stats.partialFill;
+                batch->totals.fullFill += stats.fullFill;
+                batch->totals.triangles += stats.triangles;
+                batch->totals.vertices += stats.vertices;
+        }
+        batch->written = batch->sink->frame(batch->sink, sw, image->name) && batch->written;
+        destroy_shrinkwrap(sw);
+        job->sw = NULL;
+}
+
+// Mesh a frame, then, if the batch is open, write it and any later frames that were waiting on it.
+void meshFrameTask(taskpool * pool, void * context, size_t index)
+{
+        frame_batch * batch = (frame_batch *)context;
+        meshFrame(batch, batch->jobs + index);
+        pthread_mutex_lock(&batch->lock);
+        batch->jobs[index].done = TRUE;
+        while (batch->sink && batch->nextWritten < batch->count && batch->jobs[batch->nextWritten].done) {
+                writeFrame(batch, batch->jobs + batch->nextWritten);
+                batch->nextWritten++;
+        }
+        pthread_mutex_unlock(&batch->lock);
+}
+
+int compareFrameArea(const void * a, const void * b)
+{
+        const frame_job * ja = *(const frame_job * const *)a;
+        const frame_job * jb = *(const frame_job * const *)b;
+        float areaA = ja->image->width * ja->image->height;
+        float areaB = jb->image->width * jb->image->height;
+        if (areaA != areaB) return (areaA > areaB) ? -1 : 1;
+        return (ja->frame > jb->frame) - (ja->frame < jb->frame);
+}
+
+mesh_sink * createSink(FILE * output, const options * opts)
+{
+        switch (opts->format) {
+                case OUTPUT_BINARY:
+                        if (opts->compress) {
+                                return create_compressed_binary_sink(output, c_compressionLevel, BINARY_TRANSFORM_ALL);
+                        }
+                        return create_binary_sink(output);
+                case OUTPUT_CSV:
+                        return create_csv_sink(output);
+                default:
+                        return create_html_sink(output);
+        }
+}
+
+FILE * openOutput(const char * filename, const options * opts)
+{
+        return fopen(filename, opts->format == OUTPUT_BINARY && opts->benchmark == FALSE ? "wb" : "w");
+}
+
+// Set up a job for every frame of an atlas.
+void initFrameBatch(frame_batch * batch, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth,
+                    pxl_size atlasHeight, const options * opts)
+{
+        memset(batch, 0, sizeof(frame_batch));
+        batch->opts = opts;
+        batch->imageAtlasRGBA = imageAtlasRGBA;
+        batch->atlasWidth = atlasWidth;
+        batch->atlasHeight = atlasHeight;
+        for (xml_image * image = firstImage; image; image = getNextImage(image)) {
+                batch->count++;
+        }
+        batch->jobs = (frame_job *)calloc(batch->count ? batch->count : 1, sizeof(frame_job));
         xml_image * image = firstImage;
-        const pxl_size bleed = 3;
-        const float smoothBleed = 4.0;
+        for (size_t i = 0; i < batch->count; i++, image = getNextImage(image)) {
+                batch->jobs[i].image = image;
+                batch->jobs[i].frame = (int)i + 1;
+        }
+        pthread_mutex_init(&batch->lock, NULL);
+}
+
+// Open the diagnostics, stats and mesh sink that the batch's frames are written to.
+void openFrameBatch(frame_batch * batch, FILE * output)
+{
+        const options * opts = batch->opts;
+        if (opts->diagnostics) {
+                batch->curvesFile = openDiagnostic("data/curves.html", &batch->curvesOutput, batch->atlasWidth,
+                                                   batch->atlasHeight);
+                batch->smoothFile = openDiagnostic("data/curves-smooth.html", &batch->smoothOutput, batch->atlasWidth,
+                                                   batch->atlasHeight);
+        }
+        if (opts->statsFilename) {
+                batch->statsOutput = fopen(opts->statsFilename, "w");
+                if (batch->statsOutput == NULL) {
+                        fprintf(stderr, PROGNAME ":  unable to open stats file [%s]\n", opts->statsFilename);
+                } else {
+                        batch->statsFile = textwriter_create(batch->statsOutput, c_statsBufferSize);
+                        textwriter_string(batch->statsFile, "name,mesh,quad_area,blended_fill,opaque_fill,"
+                                          "blended_fill_saved,blended_fill_saved_percent,triangles,vertices\n");
+                }
+        }
+        batch->sink = createSink(output, opts);
+        batch->written = batch->sink->begin(batch->sink, batch->atlasWidth, batch->atlasHeight);
+}
+
+// Mesh every frame on the pool.  With more than one thread, the largest frames are started first so a big frame does
+// not hold up the end.  If the batch is open, frames are written in atlas order, each as soon as those before it are
+// done; otherwise they are kept for closeFrameBatch.
+void meshFrameBatch(frame_batch * batch, taskpool * pool)
+{
+        frame_job ** order = (frame_job **)malloc(sizeof(frame_job *) * (batch->count ? batch->count : 1));
+        for (size_t i = 0; i < batch->count; i++) {
+                order[i] = batch->jobs + i;
+        }
+        if (taskpool_threads(pool) > 1) {
+                qsort(order, batch->count, sizeof(frame_job *), compareFrameArea);
+        }
+        for (size_t i = 0; i < batch->count; i++) {
+                taskpool_submit(pool, meshFrameTask, batch, (size_t)(order[i] - batch->jobs));
+        }
+        taskpool_wait(pool);
+        free(order);
+}
+
+// Write any frames still kept, close what openFrameBatch opened and free the jobs.  Frames of a batch that was never
+// opened are freed unwritten.  Returns FALSE if the output could not be written.
+int closeFrameBatch(frame_batch * batch)
+{
+        for (; batch->nextWritten < batch->count; batch->nextWritten++) {
+                frame_job * job = batch->jobs + batch->nextWritten;
+                assert(job->done);
+                if (batch->sink) {
+                        writeFrame(batch, job);
+                } else {
+                        writeFrameText(job->log, NULL, NULL);
+                        writeFrameText(job->curves, NULL, NULL);
+                        writeFrameText(job->smooth, NULL, NULL);
+                        if (job->sw) {
+                                destroy_shrinkwrap(job->sw);
+                        }
+                }
+        }
+        pthread_mutex_destroy(&batch->lock);
+        free(batch->jobs);
+        batch->jobs = NULL;
+        closeDiagnostic(batch->curvesFile, batch->curvesOutput);
+        closeDiagnostic(batch->smoothFile, batch->smoothOutput);
+        if (batch->statsFile) {
+                writeStatsRow(batch->statsFile, "total", "", batch->totalQuadArea, &batch->totals);
+                if (textwriter_flush(batch->statsFile) == FALSE) {
+                        fprintf(stderr, PROGNAME ":  unable to write stats file\n");
+                }
+                textwriter_destroy(batch->statsFile);
+                fclose(batch->statsOutput);
+        }
+        if (batch->sink == NULL) return FALSE;
+        int written = batch->sink->end(batch->sink) && batch->written;
+        batch->sink->destroy(batch->sink);
+        return written;
+}
+
+// Mesh every frame on opts->jobs threads, writing each as soon as the frames before it are done.  Returns FALSE if the
+// output could not be written.
+int processImageList(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth,
+                      pxl_size atlasHeight, const options * opts)
+{
+        frame_batch batch;
+        initFrameBatch(&batch, firstImage, imageAtlasRGBA, atlasWidth, atlasHeight, opts);
+        openFrameBatch(&batch, output);
+        taskpool * pool = taskpool_create(opts->jobs);
+        meshFrameBatch(&batch, pool);
+        taskpool_destroy(pool);
+        if (closeFrameBatch(&batch) == FALSE) {
+                fprintf(stderr, PROGNAME ":  unable to write output\n");
+                return FALSE;
+        }
+        return TRUE;
+}
+
+// One atlas of a batch manifest, handed from the decode stage to meshing and on to the write stage.
+typedef struct batch_atlas_struct {
+        // The manifest line, split into the three filenames
+        char * line;
+        const char * pngFilename;
+        const char * xmlFilename;
+        const char * outFilename;
+        uch * pixels;
+        pxl_size width;
+        pxl_size height;
+        xml_image * imageList;
+        frame_batch frames;
+        int failed;
+} batch_atlas;
+
+typedef struct batch_pipeline_struct {
+        const options * opts;
+        batch_atlas * atlases;
+        size_t count;
+        // Decoded atlases waiting to be meshed, then meshed atlases waiting to be written
+        workqueue * decoded;
+        workqueue * meshed;
+        // Only used by the write stage
+        size_t failures;
+} batch_pipeline;
+
+// How many atlases each stage may run ahead of the next.  Decoded atlases are the largest thing held, so this bounds
+// memory at a few atlases whatever the length of the manifest.
+static const size_t c_batchQueueSize = 2;
+static const size_t c_manifestLineSize = 4096;
+
+// Split the next whitespace-separated word off 'text', returning NULL if there is none.
+char * nextWord(char ** text)
+{
+        char * word = *text;
+        while (*word == ' ' || *word == '\t') word++;
+        if (*word == '\0' || *word == '\n' || *word == '\r' || *word == '#') return NULL;
+        char * end = word;
+        while (*end != '\0' && *end != ' ' && *end != '\t' && *end != '\n' && *end != '\r') end++;
+        *text = (*end != '\0') ? end + 1 : end;
+        *end = '\0';
+        return word;
+}
+
+// Read a manifest of "pngfile xmlfile outputfile" lines.  Blank lines and lines starting with '#' are skipped.
+batch_atlas * readManifest(const char * filename, size_t * outCount)
+{
+        *outCount = 0;
+        FILE * file = fopen(filename, "r");
+        if (file == NULL) {
+                fprintf(stderr, PROGNAME ":  can't open batch manifest [%s]\n", filename);
+                return NULL;
+        }
+        array * atlases = array_create(16, sizeof(batch_atlas));
+        char * buffer = (char *)malloc(c_manifestLineSize);
+        size_t lineNumber = 0;
+        int valid = TRUE;
+        while (valid && fgets(buffer, (int)c_manifestLineSize, file)) {
+                lineNumber++;
+                char * line = (char *)malloc(strlen(buffer) + 1);
+                strcpy(line, buffer);
+                char * rest = line;
+                char * words[4];
+                size_t count = 0;
+                while (count < 4 && (words[count] = nextWord(&rest)) != NULL) {
+                        count++;
+                }
+                if (count == 0) {
+                        free(line);
+                        continue;
+                }
+                if (count != 3) {
+                        fprintf(stderr, PROGNAME ":  %s:%zu: expected pngfile xmlfile outputfile\n", filename,
+                                lineNumber);
+                        free(line);
+                        valid = FALSE;
+                        continue;
+                }
+                batch_atlas * atlas = (batch_atlas *)array_push(atlases);
+                memset(atlas, 0, sizeof(batch_atlas));
+                atlas->line = line;
+                atlas->pngFilename = words[0];
+                atlas->xmlFilename = words[1];
+                atlas->outFilename = words[2];
+        }
+        free(buffer);
+        fclose(file);
+        size_t count = array_size(atlases);
+        batch_atlas * result = (batch_atlas *)malloc(sizeof(batch_atlas) * (count ? count : 1));
+        for (size_t i = 0; i < count; i++) {
+                result[i] = *(batch_atlas *)array_get(atlases, i);
+                if (valid == FALSE) {
+                        free(result[i].line);
+                }
+        }
+        array_destroy(atlases);
+        if (valid == FALSE) {
+                free(result);
+                return NULL;
+        }
+        *outCount = count;
+        return result;
+}
+
+// Decode an atlas's png and xml, closing both files.
+void loadAtlas(batch_atlas * atlas)
+{
+        FILE * pngFile = NULL;
+        FILE * xmlFile = NULL;
+        readpng_contextp context = readpng_createcontext();
+        size_t width = 0;
+        size_t height = 0;
+        int status = loadPNG(context, &pngFile, atlas->pngFilename, &atlas->pixels, &width, &height);
+        readpng_cleanup(context, FALSE);
+        readpng_destroycontext(context);
+        if (pngFile) {
+                fclose(pngFile);
+        }
+        if (status != 0) {
+                if (status == 3) {
+                        fprintf(stderr, PROGNAME ":  unable to decode PNG image [%s]\n", atlas->pngFilename);
+                }
+                atlas->failed = TRUE;
+                return;
+        }
+        atlas->width = (pxl_size)width;
+        atlas->height = (pxl_size)height;
+        atlas->imageList = loadXML(&xmlFile, atlas->xmlFilename);
+        if (xmlFile) {
+                fclose(xmlFile);
+        } else {
+                atlas->failed = TRUE;
+        }
+}
+
+// Decode stage
+void * decodeAtlases(void * data)
+{
+        batch_pipeline * pipeline = (batch_pipeline *)data;
+        for (size_t i = 0; i < pipeline->count; i++) {
+                loadAtlas(pipeline->atlases + i);
+                workqueue_push(pipeline->decoded, pipeline->atlases + i);
+        }
+        workqueue_close(pipeline->decoded);
+        return NULL;
+}
+
+// Write stage.  Frees each atlas once it is written.
+void * writeAtlases(void * data)
+{
+        batch_pipeline * pipeline = (batch_pipeline *)data;
+        batch_atlas * atlas;
+        while ((atlas = (batch_atlas *)workqueue_pop(pipeline->meshed)) != NULL) {
+                if (atlas->failed == FALSE) {
+                        printf("%s:\n", atlas->outFilename);
+                        FILE * output = openOutput(atlas->outFilename, pipeline->opts);
+                        if (output == NULL) {
+                                fprintf(stderr, PROGNAME ":  unable to open output file [%s]\n", atlas->outFilename);
+                        } else {
+                                openFrameBatch(&atlas->frames, output);
+                        }
+                        if (closeFrameBatch(&atlas->frames) == FALSE) {
+                                if (output) {
+                                        fprintf(stderr, PROGNAME ":  unable to write output [%s]\n",
+                                                atlas->outFilename);
+                                }
+                                atlas->failed = TRUE;
+                        }
+                        if (output && fclose(output) != 0 && atlas->failed == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unable to write output [%s]\n", atlas->outFilename);
+                                atlas->failed = TRUE;
+                        }
+                }
+                if (atlas->failed) {
+                        pipeline->failures++;
+                }
+                destroyImageStructList(atlas->imageList);
+                atlas->imageList = NULL;
+                free(atlas->pixels);
+                atlas->pixels = NULL;
+        }
+        return NULL;
+}
+
+// Mesh every atlas in a manifest.  Decoding, meshing and writing run on threads of their own, so the next atlas is
+// decoded and the last one written while one is meshed.  Frames are meshed on opts->jobs threads as in
+// processImageList, and atlases are written in manifest order.  Returns the number of atlases that failed.
+size_t processBatch(batch_atlas * atlases, size_t count, const options * opts)
+{
+        batch_pipeline pipeline;
+        pipeline.opts = opts;
+        pipeline.atlases = atlases;
+        pipeline.count = count;
+        pipeline.decoded = workqueue_create(c_batchQueueSize);
+        pipeline.meshed = workqueue_create(c_batchQueueSize);
+        pipeline.failures = 0;
+        pthread_t decoder;
+        pthread_t writer;
+        pthread_create(&decoder, NULL, decodeAtlases, &pipeline);
+        pthread_create(&writer, NULL, writeAtlases, &pipeline);
+        taskpool * pool = taskpool_create(opts->jobs);
+        batch_atlas * atlas;
+        while ((atlas = (batch_atlas *)workqueue_pop(pipeline.decoded)) != NULL) {
+                if (atlas->failed == FALSE) {
+                        initFrameBatch(&atlas->frames, atlas->imageList, atlas->pixels, atlas->width, atlas->height,
+                                       opts);
+                        meshFrameBatch(&atlas->frames, pool);
+                }
+                workqueue_push(pipeline.meshed, atlas);
+        }
+        workqueue_close(pipeline.meshed);
+        taskpool_destroy(pool);
+        pthread_join(decoder, NULL);
+        pthread_join(writer, NULL);
+        workqueue_destroy(pipeline.decoded);
+        workqueue_destroy(pipeline.meshed);
+        return pipeline.failures;
+}
+
+double nowMilliseconds()
+{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
+
+// Totals over every frame meshed by one benchmark configuration
+typedef struct benchmark_totals_struct {
+        size_t frames;
+        size_t vertices;
+        size_t triangles;
+        size_t indexBytes;
+        double blendedFill;
+        double opaqueFill;
+        double traceTime;
+        double smoothTime;
+        double triangulateTime;
+} benchmark_totals;
+
+void addBenchmarkFrame(benchmark_totals * totals, shrinkwrap * sw)
+{
+        totals->frames++;
+        totals->vertices += array_size(sw->vertices);
+        size_t indices = array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha);
+        totals->triangles += indices / 3;
+        totals->indexBytes += indices * sw->indexWidth;
+        shrinkwrap_stats stats;
+        measure_shrinkwrap(sw, &stats);
+        totals->blendedFill += stats.partialFill;
+        totals->opaqueFill += stats.fullFill;
+}
+
+void writeBenchmarkRow(FILE * output, const char * engine, const char * simplifier, const char * triangulator,
+                       const benchmark_totals * totals)
+{
+        fprintf(output, "%s,%s,%s,%zu,%zu,%zu,%zu,%.1f,%.1f,%.3f,%.3f,%.3f\n", engine, simplifier, triangulator,
+                totals->frames, totals->vertices, totals->triangles, totals->indexBytes, totals->blendedFill,
+                totals->opaqueFill, totals->traceTime, totals->smoothTime, totals->triangulateTime);
+}
+
+// Mesh every frame with one simplifier and triangulation engine and write a CSV row of totals.
+void benchmarkConfiguration(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth,
+                            const smooth_options * smooth, triangulation engine)
+{
+        benchmark_totals totals;
+        memset(&totals, 0, sizeof(totals));
         int i = 0;
-        while (image) {
+        for (xml_image * image = firstImage; image; image = getNextImage(image)) {
                 i++;
-                const pxl_pos x = image->x;
-                const pxl_pos y = image->y;
-                const pxl_pos w = image->width;
-                const pxl_pos height = image->height;
-                const pxl_diff frameOffsetX = image->xOffset;
-                const pxl_diff frameOffsetY = image->yOffset;
-                const pxl_pos frameX = ((pxl_diff)x + frameOffsetX < 0) ? 0 : (x + frameOffsetX);
-                const pxl_pos frameY = ((pxl_diff)y + frameOffsetY < 0) ? 0 : (y + frameOffsetY);
-                tpxl * typePixels = generate_typemap(imageAtlasRGBA, x, y, w, height, atlasWidth);
-                tpxl * antiDither = reduce_dither(typePixels, w, height, bleed);
-                tpxl * dilated = dilate_alpha(antiDither, w, height, bleed);
-                tpxl * finalPixels = dilated;
-                curve_list * cl = build_curves(finalPixels, w, height);
-                html_draw_curves(outFile, cl, x, y);
-                // TEMP: WIP
-                if (i == 30 || i == 31) {
-                        image = getNextImage(image);
-                        goto cleanup;
-                }
-                smooth_curves(cl, smoothBleed, w, height);
-                html_draw_curves(outFile2, cl, x, y);
-                shrinkwrap * sw = triangulate(cl);
-                set_texture_coordinates(sw, frameX, frameY, atlasWidth, atlasHeight, frameOffsetX,
-                                            frameOffsetY - 0.5);
-                shrinkwrap ** entry = (shrinkwrap **)array_push(shrinkwraps);
-                sw->origX = frameX;
-                sw->origY = frameY;
-                *entry = sw;
-                image = getNextImage(image);
-        cleanup:
-                free(typePixels);
-                free(antiDither);
-                free(dilated);
+                if (isSkippedFrame(i)) continue;
+                tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+                double start = nowMilliseconds();
+                curve_list * cl = build_curves(finalPixels, image->width, image->height);
+                double traced = nowMilliseconds();
+                smooth_curves_ex(cl, c_smoothBleed, image->width, image->height, smooth);
+                double smoothed = nowMilliseconds();
+                shrinkwrap * sw = triangulate_ex(cl, engine);
+                double triangulated = nowMilliseconds();
+                totals.traceTime += traced - start;
+                totals.smoothTime += smoothed - traced;
+                totals.triangulateTime += triangulated - smoothed;
+                addBenchmarkFrame(&totals, sw);
+                destroy_shrinkwrap(sw);
                 destroy_curve_list(cl);
+                free(finalPixels);
         }
-        html_epilogue(outFile);
-        html_epilogue(outFile2);
-        shrinkwrap ** first = array_get(shrinkwraps, 0);
-        size_t count = array_size(shrinkwraps);
-        save_diagnostic_html(output, first, count, (float)atlasWidth, (float)atlasHeight);
-        shrinkwrap ** sw = first;
-        for (int j = 0; j < count; j++) {
-                destroy_shrinkwrap(*sw);
-                *sw = NULL;
-                sw++;
+        writeBenchmarkRow(output, mesh_engine_name(ENGINE_SCANLINE), simplifier_name(smooth->method),
+                          triangulation_name(engine), &totals);
+}
+
+// Mesh every frame from contours and write a CSV row of totals.
+void benchmarkContours(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth)
+{
+        benchmark_totals totals;
+        memset(&totals, 0, sizeof(totals));
+        int i = 0;
+        for (xml_image * image = firstImage; image; image = getNextImage(image)) {
+                i++;
+                if (isSkippedFrame(i)) continue;
+                tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+                double start = nowMilliseconds();
+                contour_list * cl = trace_contours(finalPixels, image->width, image->height);
+                double traced = nowMilliseconds();
+                simplify_contours(cl, c_smoothBleed);
+                double simplified = nowMilliseconds();
+                shrinkwrap * sw = triangulate_contours(cl);
+                double triangulated = nowMilliseconds();
+                totals.traceTime += traced - start;
+                totals.smoothTime += simplified - traced;
+                totals.triangulateTime += triangulated - simplified;
+                addBenchmarkFrame(&totals, sw);
+                destroy_shrinkwrap(sw);
+                destroy_contour_list(cl);
+                free(finalPixels);
         }
-        array_destroy(shrinkwraps);
+        writeBenchmarkRow(output, mesh_engine_name(ENGINE_CONTOUR), "douglas-peucker", "ear-clipping", &totals);
+}
+
+// Mesh every frame by convex hull decomposition and write a CSV row of totals.  Building the summed-area tables is
+// included in the triangulation time.
+void benchmarkHulls(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth)
+{
+        benchmark_totals totals;
+        memset(&totals, 0, sizeof(totals));
+        int i = 0;
+        for (xml_image * image = firstImage; image; image = getNextImage(image)) {
+                i++;
+                if (isSkippedFrame(i)) continue;
+                tpxl * finalPixels = classifyFrame(image, imageAtlasRGBA, atlasWidth);
+                double start = nowMilliseconds();
+                shrinkwrap * sw = decompose_hulls(finalPixels, image->width, image->height, c_hullWaste);
+                totals.triangulateTime += nowMilliseconds() - start;
+                addBenchmarkFrame(&totals, sw);
+                destroy_shrinkwrap(sw);
+                free(finalPixels);
+        }
+        writeBenchmarkRow(output, mesh_engine_name(ENGINE_HULL), "none", "convex-fan", &totals);
+}
+
+// Mesh every frame once per simplifier and triangulation engine, once from contours and once by hull decomposition,
+// and write a CSV row of totals for each.
+void benchmarkImageList(FILE * output, xml_image * firstImage, uch * imageAtlasRGBA, pxl_size atlasWidth,
+                        const options * opts)
+{
+        fprintf(output, "engine,simplifier,triangulator,frames,vertices,triangles,index_bytes,blended_fill,"
+                "opaque_fill,trace_ms,smooth_ms,triangulate_ms\n");
+        for (int method = 0; method < SIMPLIFY_COUNT; method++) {
+                smooth_options smooth = opts->smooth;
+                smooth.method = (simplifier)method;
+                for (int engine = 0; engine < TRIANGULATE_COUNT; engine++) {
+                        benchmarkConfiguration(output, firstImage, imageAtlasRGBA, atlasWidth, &smooth,
+                                               (triangulation)engine);
+                }
+        }
+        benchmarkContours(output, firstImage, imageAtlasRGBA, atlasWidth);
+        benchmarkHulls(output, firstImage, imageAtlasRGBA, atlasWidth);
 }
 
 size_t stringLen(const char * str, size_t max)
@@ -205,19 +1121,205 @@ int helpRequested(int argc, const char ** argv)
         return requested;
 }
 
+int parseCount(const char * value, size_t * outCount)
+{
+        if (value == NULL) return FALSE;
+        char * end = NULL;
+        long count = strtol(value, &end, 10);
+        if (*value == '\0' || *end != '\0' || count < 0) return FALSE;
+        *outCount = (size_t)count;
+        return TRUE;
+}
+
+int outputFormatFromName(const char * name, output_format * outFormat)
+{
+        for (int format = 0; format < OUTPUT_COUNT; format++) {
+                if (strcmp(name, c_outputFormatNames[format]) == 0) {
+                        *outFormat = (output_format)format;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Reads leading --option arguments followed by the png, xml and output filenames, which --batch replaces.
+int parseOptions(int argc, const char ** argv, options * outOptions)
+{
+        memset(outOptions, 0, sizeof(options));
+        outOptions->smooth.threads = 1;
+        outOptions->refine.threads = 1;
+        outOptions->jobs = 1;
+        outOptions->refine.triangleCost = c_refineTriangleCost;
+        outOptions->refine.seed = 1;
+        int arg = 1;
+        while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+                const char * name = argv[arg];
+                const char * value = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+                if (strcmp(name, "--smooth-threads") == 0) {
+                        if (parseCount(value, &outOptions->smooth.threads) == FALSE) return FALSE;
+                        arg += 2;
+                } else if (strcmp(name, "--simplifier") == 0) {
+                        if (value == NULL || simplifier_from_name(value, &outOptions->smooth.method) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown simplifier [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--engine") == 0) {
+                        if (value == NULL || mesh_engine_from_name(value, &outOptions->engine) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown engine [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--triangulator") == 0) {
+                        if (value == NULL || triangulation_from_name(value, &outOptions->triangulator) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown triangulator [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--primitive") == 0) {
+                        if (value == NULL || primitive_from_name(value, &outOptions->primitiveType) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown primitive [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--vertex-cache") == 0) {
+                        outOptions->optimiseCache = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--vertex-format") == 0) {
+                        if (value == NULL || vertex_format_from_name(value, &outOptions->vertexFormat) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown vertex format [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--stats") == 0) {
+                        if (value == NULL) {
+                                fprintf(stderr, PROGNAME ":  missing stats file\n");
+                                return FALSE;
+                        }
+                        outOptions->statsFilename = value;
+                        arg += 2;
+                } else if (strcmp(name, "--device") == 0) {
+                        outOptions->device = value ? device_profile_from_name(value) : NULL;
+                        if (outOptions->device == NULL) {
+                                fprintf(stderr, PROGNAME ":  unknown device [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--device-costs") == 0) {
+                        device_profile * custom = &outOptions->customDevice;
+                        custom->name = "custom";
+                        if (value == NULL || sscanf(value, "%f,%f,%f", &custom->vertexCost, &custom->blendedPixelCost,
+                                                    &custom->opaquePixelCost) != 3) {
+                                fprintf(stderr, PROGNAME ":  device costs must be vertex,blended,opaque\n");
+                                return FALSE;
+                        }
+                        outOptions->device = custom;
+                        arg += 2;
+                } else if (strcmp(name, "--refine-ms") == 0) {
+                        size_t milliseconds = 0;
+                        if (parseCount(value, &milliseconds) == FALSE) return FALSE;
+                        outOptions->refine.milliseconds = (double)milliseconds;
+                        arg += 2;
+                } else if (strcmp(name, "--refine-iterations") == 0) {
+                        if (parseCount(value, &outOptions->refine.iterations) == FALSE) return FALSE;
+                        arg += 2;
+                } else if (strcmp(name, "--refine-threads") == 0) {
+                        if (parseCount(value, &outOptions->refine.threads) == FALSE) return FALSE;
+                        arg += 2;
+                } else if (strcmp(name, "--opaque-cores") == 0) {
+                        outOptions->opaqueCores = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--format") == 0) {
+                        if (value == NULL || outputFormatFromName(value, &outOptions->format) == FALSE) {
+                                fprintf(stderr, PROGNAME ":  unknown format [%s]\n", value ? value : "");
+                                return FALSE;
+                        }
+                        arg += 2;
+                } else if (strcmp(name, "--batch") == 0) {
+                        if (value == NULL) {
+                                fprintf(stderr, PROGNAME ":  missing batch manifest\n");
+                                return FALSE;
+                        }
+                        outOptions->batchFilename = value;
+                        arg += 2;
+                } else if (strcmp(name, "--jobs") == 0) {
+                        if (parseCount(value, &outOptions->jobs) == FALSE) return FALSE;
+                        arg += 2;
+                } else if (strcmp(name, "--compress") == 0) {
+                        outOptions->compress = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--diagnostics") == 0) {
+                        outOptions->diagnostics = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--merge-convex") == 0) {
+                        outOptions->mergeConvex = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--compact") == 0) {
+                        outOptions->compact = TRUE;
+                        arg += 1;
+                } else if (strcmp(name, "--benchmark") == 0) {
+                        outOptions->benchmark = TRUE;
+                        arg += 1;
+                } else {
+                        fprintf(stderr, PROGNAME ":  unknown option [%s]\n", name);
+                        return FALSE;
+                }
+        }
+        if (outOptions->opaqueCores && outOptions->engine != ENGINE_SCANLINE) {
+                fprintf(stderr, PROGNAME ":  --opaque-cores needs the scanline engine\n");
+                return FALSE;
+        }
+        if (outOptions->compress && outOptions->format != OUTPUT_BINARY) {
+                fprintf(stderr, PROGNAME ":  --compress needs the binary format\n");
+                return FALSE;
+        }
+        if (outOptions->batchFilename) {
+                if (outOptions->diagnostics || outOptions->statsFilename || outOptions->benchmark) {
+                        fprintf(stderr, PROGNAME ":  --batch can't be used with --diagnostics, --stats or "
+                                "--benchmark\n");
+                        return FALSE;
+                }
+                return argc == arg;
+        }
+        if (argc - arg != 3) return FALSE;
+        outOptions->pngFilename = argv[arg];
+        outOptions->xmlFilename = argv[arg + 1];
+        outOptions->outFilename = argv[arg + 2];
+        return TRUE;
+}
+
 int main(int argc, const char ** argv)
 {
-        if (argc != 4 || helpRequested(argc, argv)) {
+        options opts;
+        if (helpRequested(argc, argv) || parseOptions(argc, argv, &opts) == FALSE) {
                 system("nroff -man shrinkwrap.1 | more");
                 exit(2);
         }
         
-        const char * pngFilename = argv[1];
-        const char * xmlFilename = argv[2];
-        const char * outFilename = argv[3];
+        if (opts.batchFilename) {
+                size_t count = 0;
+                batch_atlas * atlases = readManifest(opts.batchFilename, &count);
+                if (atlases == NULL) {
+                        exit(2);
+                }
+                size_t failures = processBatch(atlases, count, &opts);
+                for (size_t i = 0; i < count; i++) {
+                        free(atlases[i].line);
+                }
+                free(atlases);
+                if (failures > 0) {
+                        fprintf(stderr, PROGNAME ":  %zu of %zu atlases failed\n", failures, count);
+                        exit(3);
+                }
+                return 0;
+        }
+        
+        const char * pngFilename = opts.pngFilename;
+        const char * xmlFilename = opts.xmlFilename;
+        const char * outFilename = opts.outFilename;
         FILE * pngFile = NULL;
         FILE * xmlFile = NULL;
-        FILE * outFile = fopen(outFilename, "w");
+        FILE * outFile = openOutput(outFilename, &opts);
         
         if (outFile == NULL) {
                 fprintf(stderr, PROGNAME ":  unable to open output file\n");
@@ -228,26 +1330,38 @@ int main(int argc, const char ** argv)
         uch * pixels;
         size_t width;
         size_t height;
-        loadPNG(readPNGContextP, &pngFile, pngFilename, &pixels, &width, &height);
+        int status = loadPNG(readPNGContextP, &pngFile, pngFilename, &pixels, &width, &height);
         
         readpng_cleanup(readPNGContextP, FALSE);
-        if (!pixels) {
-                fprintf(stderr, PROGNAME ":  unable to decode PNG image\n");
+        if (status != 0) {
+                if (status == 3) {
+                        fprintf(stderr, PROGNAME ":  unable to decode PNG image\n");
+                } else {
+                        fprintf(stderr, PROGNAME ":  aborting.\n");
+                }
                 if (pngFile) {
                         fclose(pngFile);
                 }
-                exit(3);
+                exit(status);
         }
         
         xml_image * imageList = loadXML(&xmlFile, xmlFilename);
-        processImageList(outFile, imageList, pixels, (pxl_size)width, (pxl_size)height);
+        int written = TRUE;
+        if (opts.benchmark) {
+                benchmarkImageList(outFile, imageList, pixels, (pxl_size)width, &opts);
+        } else {
+                written = processImageList(outFile, imageList, pixels, (pxl_size)width, (pxl_size)height, &opts);
+        }
         destroyImageStructList(imageList);
         imageList = NULL;
         
         free(pixels);
         readpng_destroycontext(readPNGContextP);
         
-        fclose(outFile);
+        if (fclose(outFile) != 0 && written) {
+                fprintf(stderr, PROGNAME ":  unable to write output\n");
+                written = FALSE;
+        }
         
-        return 0;
+        return written ? 0 : 3;
 }
@@ -32,4 +32,12 @@ typedef uint32_t pxl_size;
 typedef int32_t pxl_diff;
 typedef float vtx_pos;
 typedef uint8_t tpxl;
+
+// A block of whole pixels: columns x to x + w - 1 of rows y to y + h - 1
+typedef struct pixel_rect_struct {
+        pxl_pos x;
+        pxl_pos y;
+        pxl_size w;
+        pxl_size h;
+} pixel_rect;
 #endif
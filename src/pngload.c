@@ -41,7 +41,7 @@ static const size_t readpng_context_size = sizeof(readpng_context);
 
 readpng_contextp readpng_createcontext()
 {
-        return (readpng_contextp)malloc(readpng_context_size);
+        return (readpng_contextp)calloc(1, readpng_context_size);
 }
 
 void readpng_destroycontext(readpng_contextp context)
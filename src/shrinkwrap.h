@@ -41,7 +41,8 @@
 // 2) Bleed partial-alpha pixels into their neighbours to account for bilinear filtering and reduce alpha complexitity.
 //    (TODO: Use convolution to apply this on the Y axis)
 // 3) Run a scan-line dithering filter that replaces high-frequency alpha changes with partial-alpha blocks.
-// 4) Use simple X-axis scan-line edge detection to generate curves.
+// 4) Use simple X-axis scan-line edge detection to generate curves, or trace closed contours with marching squares.
+//    Alternatively divide the frame into convex hulls directly, skipping steps 5 and 6.
 // 5) Reduce complexity of curves by removing superfluous points.
 // 6) Iterate through all curves - find right-hand side pairs - to generate triangles for final geometry complete
 //    with appropriate UVs.
@@ -81,11 +82,134 @@ curve_list * build_curves(const tpxl * tpixels, pxl_size w, pxl_size h);
 // Note: Will mutate curve geometries in-place
 void smooth_curves(curve_list * cl, float bleed, pxl_size w, pxl_size h);
 
+// As smooth_curves, with options.  With more than one thread, curves that do not share a scanline are smoothed
+// concurrently; the result is identical to serial smoothing.
+void smooth_curves_ex(curve_list * cl, float bleed, pxl_size w, pxl_size h, const smooth_options * options);
+
+// Command-line names of the curve simplifiers, e.g. "douglas-peucker"
+const char * simplifier_name(simplifier method);
+int simplifier_from_name(const char * name, simplifier * outMethod);
+
 // Iterates through each downward vertex list of each section and creates 2 indexed triangle lists for full and partial
 // alpha with one final vertex list
 // Note: Safe to destroy geometrySections after this process
 shrinkwrap * triangulate(const curve_list * curve_list);
 
+// As triangulate, with the choice of triangulation engine
+shrinkwrap * triangulate_ex(const curve_list * curve_list, triangulation engine);
+
+// Command-line names of the triangulation engines, e.g. "monotone"
+const char * triangulation_name(triangulation engine);
+int triangulation_from_name(const char * name, triangulation * outEngine);
+
+// Trace the closed borders of the visible and opaque regions with marching squares.  Unlike build_curves, contours
+// bound whole pixels, including the last row, and are not limited to y-monotone runs.
+contour_list * trace_contours(const tpxl * tpixels, pxl_size w, pxl_size h);
+
+// Remove points from each contour with Douglas-Peucker, moving visible borders only outwards and opaque borders only
+// inwards, by no more than 'bleed' pixels and without letting borders cross
+// Note: Will mutate contours in-place
+void simplify_contours(contour_list * cl, float bleed);
+
+// Ear clip the opaque regions into the full alpha list and the visible regions less the opaque ones into the partial
+// alpha list, holes included
+// Note: Safe to destroy the contours after this process
+shrinkwrap * triangulate_contours(contour_list * cl);
+
+// Divide a frame from its bounding quad down into rectangles until each is all opaque, drawn as a full alpha quad, or
+// its visible pixels have a convex hull that draws no more than maxWaste pixels blended needlessly, drawn as partial
+// alpha.  Cuts are chosen with summed-area tables to waste the least.
+shrinkwrap * decompose_hulls(const tpxl * tpixels, pxl_size w, pxl_size h, float maxWaste);
+
+// Command-line names of the mesh engines, e.g. "contour"
+const char * mesh_engine_name(mesh_engine engine);
+int mesh_engine_from_name(const char * name, mesh_engine * outEngine);
+
+// Convert both index lists to triangle strips joined by degenerate triangles or the primitive restart index.  The
+// lists are kept when strips would not be smaller; check primitiveType.
+// Note: Will replace the index lists
+void stripify(shrinkwrap * geometry, primitive mode);
+
+// Command-line names of the primitive types, e.g. "strip-restart"
+const char * primitive_name(primitive mode);
+int primitive_from_name(const char * name, primitive * outMode);
+
+// Step through the triangles an index list draws, starting from position 0, expanding strips as drawn
+int next_triangle(array * indices, primitive mode, size_t * inOutPosition, uint32_t * outTriangle);
+
+// Reorder the triangles of both lists so GPUs transform each vertex fewer times
+// Note: Call before stripify
+void optimise_vertex_cache(shrinkwrap * geometry);
+
+// Average cache miss ratio of the triangle lists drawn through a FIFO vertex cache of the given size
+float vertex_cache_acmr(shrinkwrap * geometry, size_t cacheSize);
+
+// Evolve a triangle list mesh towards fewer triangles that misclassify fewer pixels of its type pixel map, sampling
+// each pixel at its centre.  shiftY is the distance the mesh lies above its pixels: 0.5 for meshes of build_curves and
+// 0 for contours and hulls, which bound whole pixels.  Vertices are moved and merged; the alpha type of a triangle
+// never changes.
+// Note: Compacts the vertices before and after refining
+void refine_shrinkwrap(shrinkwrap * geometry, const tpxl * tpixels, pxl_size w, pxl_size h, float shiftY,
+                       const refine_options * options, refine_report * outReport);
+
+// Merge the triangles of each alpha type into convex polygons across the edges they share (Hertel-Mehlhorn) and fan
+// each polygon into as few triangles as its true corners allow.  The covered area of each type is unchanged.
+// Note: Call before stripify.  Compacts the vertices before and after merging
+void merge_convex(shrinkwrap * geometry);
+
+// Drop vertices no triangle uses, weld vertices at identical positions and renumber the rest in the order they are
+// first drawn.  Switches to 16-bit indices if the vertex count falls below 65536.
+void compact_vertices(shrinkwrap * geometry);
+
+// Build 8-byte vertices with int16 positions on a half pixel grid and unorm16 UVs across the frame, recording the
+// scale, bias and largest error in the shrinkwrap's quantisation
+// Note: Call after set_texture_coordinates
+void quantise_vertices(shrinkwrap * geometry);
+vert dequantise_vertex(const vertex_quantisation * quantisation, const quantised_vert * q);
+
+// Switch to the position-only version of the vertex format, halving the vertices written.  A runtime rebuilds the
+// UVs with apply_uv_transform, or in a vertex shader:
+//   uv = position * uvTransform.xy + uvTransform.zw;    // uvTransform = (scaleU, scaleV, biasU, biasV)
+// Note: Call after set_texture_coordinates and quantise_vertices
+void drop_texture_coordinates(shrinkwrap * geometry);
+vert apply_uv_transform(const uv_transform * transform, float x, float y);
+
+// Command-line names of the vertex formats, e.g. "quantised"
+const char * vertex_format_name(vertex_format format);
+int vertex_format_from_name(const char * name, vertex_format * outFormat);
+// Whether vertices are stored as quantised_vert, whether they hold UVs, and the bytes each takes when written
+int vertex_format_is_quantised(vertex_format format);
+int vertex_format_has_uvs(vertex_format format);
+size_t vertex_format_size(vertex_format format);
+
+// Cost of drawing a triangulated frame as a quad, hull or split mesh on a device, and the cheapest choice
+// Note: Call straight after triangulate
+float mesh_cost(shrinkwrap * geometry, const device_profile * device, mesh_choice choice, float width, float height);
+mesh_choice choose_mesh(shrinkwrap * geometry, const device_profile * device, float width, float height);
+// Rebuild the geometry as the chosen mesh; sets meshType.  'shiftY' is how far down the frame's mesh will be placed,
+// 0.5 for scanline meshes and 0 for contour and hull meshes, so that a quad covers the frame's pixels.
+void apply_mesh_choice(shrinkwrap * geometry, mesh_choice choice, float width, float height, float shiftY);
+const char * mesh_choice_name(mesh_choice choice);
+// Built-in device profiles, e.g. "mobile", or NULL
+const device_profile * device_profile_from_name(const char * name);
+
+// Carve up to maxCores full-alpha rectangles, at least minSide pixels each way, out of a type pixel map.  The
+// rectangles are drawn as opaque quads and the regions around them traced separately; regions beside a rectangle take
+// 'overlap' of its columns, which should exceed the smoothing bleed.  outRegions must hold 3 * maxCores + 1
+// rectangles.  Returns the number of regions.
+size_t split_opaque_cores(const tpxl * tpixels, pxl_size w, pxl_size h, pxl_size minSide, pxl_size overlap,
+                          size_t maxCores, pixel_rect * outCores, size_t * outCoreCount, pixel_rect * outRegions);
+// Copy a rectangle out of a type pixel map
+tpxl * crop_typemap(const tpxl * tpixels, pxl_size w, const pixel_rect * rect);
+// Join the triangulated regions of a frame and the quads of its cores into one shrinkwrap
+// Note: Call straight after triangulate; safe to destroy the parts after this process
+shrinkwrap * merge_shrinkwraps(shrinkwrap ** parts, const pixel_rect * regions, size_t count,
+                               const pixel_rect * cores, size_t coreCount);
+
+// Measure the pixels filled drawing blended and opaque, counting overlapping triangles once each, and count the
+// triangles and vertices drawn
+void measure_shrinkwrap(shrinkwrap * geometry, shrinkwrap_stats * outStats);
+
 // Set UV's to frame in texture space and translate geometry by the frames offset if desired
 // Note: Will mutate curve geometries in-place
 void set_texture_coordinates(shrinkwrap * geometry, float framex, float framey, float texturewidth,
@@ -94,5 +218,6 @@ void set_texture_coordinates(shrinkwrap * geometry, float framex, float framey,
 // Destructors
 ///////////////////////////////
 void destroy_curve_list(curve_list * todestroy);
+void destroy_contour_list(contour_list * todestroy);
 void destroy_shrinkwrap(shrinkwrap * todestroy);
 #endif
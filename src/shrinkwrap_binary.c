@@ -0,0 +1,719 @@
+//
+//  shrinkwrap_binary.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_binary_internal.h"
+#include "internal/shrinkwrap_quantise_internal.h"
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+mesh_sink * create_binary_sink(FILE * output)
+{
+        binary_sink_state * state = (binary_sink_state *)calloc(1, sizeof(binary_sink_state));
+        state->output = output;
+        state->entries = array_create(64, sizeof(binary_entry));
+        mesh_sink * sink = (mesh_sink *)malloc(sizeof(mesh_sink));
+        sink->begin = binary_sink_begin;
+        sink->frame = binary_sink_frame;
+        sink->end = binary_sink_end;
+        sink->destroy = binary_sink_destroy;
+        sink->context = state;
+        return sink;
+}
+
+mesh_sink * create_compressed_binary_sink(FILE * output, int level, unsigned transforms)
+{
+        mesh_sink * sink = create_binary_sink(output);
+        binary_sink_state * state = (binary_sink_state *)sink->context;
+        state->stream = (z_stream *)calloc(1, sizeof(z_stream));
+        if (deflateInit(state->stream, level) != Z_OK) {
+                free(state->stream);
+                state->stream = NULL;
+                state->failed = TRUE;
+        }
+        state->compressed = (uint8_t *)malloc(binary_chunk_size);
+        state->transforms = transforms;
+        return sink;
+}
+
+int save_binary(FILE * output, shrinkwrap ** geometry_list, const char ** names, size_t count, pxl_size width,
+                pxl_size height)
+{
+        mesh_sink * sink = create_binary_sink(output);
+        int written = sink->begin(sink, width, height);
+        for (size_t i = 0; i < count; i++) {
+                written = sink->frame(sink, geometry_list[i], names ? names[i] : NULL) && written;
+        }
+        written = sink->end(sink) && written;
+        sink->destroy(sink);
+        return written;
+}
+
+int read_binary_header(const uint8_t * data, size_t size, binary_header * outHeader)
+{
+        if (size < binary_header_size || memcmp(data, binary_magic, sizeof(binary_magic)) != 0) return FALSE;
+        outHeader->version = get_binary_u32(data + 4);
+        outHeader->frameCount = get_binary_u32(data + 8);
+        outHeader->directoryOffset = get_binary_u32(data + 12);
+        outHeader->frameSize = get_binary_u32(data + 16);
+        outHeader->namesOffset = get_binary_u32(data + 20);
+        outHeader->namesSize = get_binary_u32(data + 24);
+        outHeader->atlasWidth = get_binary_u32(data + 28);
+        outHeader->atlasHeight = get_binary_u32(data + 32);
+        outHeader->fileSize = get_binary_u32(data + 36);
+        if (outHeader->namesOffset + (uint64_t)outHeader->namesSize > outHeader->fileSize) return FALSE;
+        if (outHeader->version != binary_version || outHeader->fileSize > size) return FALSE;
+        // Later versions may only grow the directory entries
+        if (outHeader->frameSize < binary_frame_size) return FALSE;
+        uint64_t directoryEnd = outHeader->directoryOffset + (uint64_t)outHeader->frameCount * outHeader->frameSize;
+        return directoryEnd <= outHeader->fileSize;
+}
+
+void read_binary_frame(const uint8_t * data, const binary_header * header, size_t i, binary_frame * outFrame)
+{
+        assert(i < header->frameCount);
+        const uint8_t * p = data + header->directoryOffset + i * header->frameSize;
+        outFrame->nameHash = get_binary_u32(p);
+        outFrame->nameOffset = get_binary_u32(p + 4);
+        outFrame->nameLength = get_binary_u32(p + 8);
+        outFrame->meshType = (mesh_choice)p[12];
+        outFrame->primitiveType = (primitive)p[13];
+        outFrame->indexWidth = (index_width)p[14];
+        outFrame->vertexFormat = (vertex_format)p[15];
+        outFrame->vertexOffset = get_binary_u32(p + 16);
+        outFrame->vertexCount = get_binary_u32(p + 20);
+        outFrame->partialOffset = get_binary_u32(p + 24);
+        outFrame->partialCount = get_binary_u32(p + 28);
+        outFrame->fullOffset = get_binary_u32(p + 32);
+        outFrame->fullCount = get_binary_u32(p + 36);
+        outFrame->origX = get_binary_f32(p + 40);
+        outFrame->origY = get_binary_f32(p + 44);
+        float * scale = &outFrame->scale.x;
+        float * bias = &outFrame->bias.x;
+        for (int c = 0; c < 4; c++) {
+                scale[c] = get_binary_f32(p + 48 + c * 4);
+                bias[c] = get_binary_f32(p + 64 + c * 4);
+        }
+        outFrame->uvTransform.scaleU = get_binary_f32(p + 80);
+        outFrame->uvTransform.scaleV = get_binary_f32(p + 84);
+        outFrame->uvTransform.biasU = get_binary_f32(p + 88);
+        outFrame->uvTransform.biasV = get_binary_f32(p + 92);
+}
+
+int find_binary_frame(const uint8_t * data, size_t size, const char * name, binary_frame * outFrame)
+{
+        binary_header header;
+        if (read_binary_header(data, size, &header) == FALSE) return FALSE;
+        uint32_t hash = binary_name_hash(name);
+        size_t length = strlen(name);
+        // First entry whose hash is not below the one sought
+        size_t low = 0;
+        size_t high = header.frameCount;
+        while (low < high) {
+                size_t mid = low + (high - low) / 2;
+                binary_frame frame;
+                read_binary_frame(data, &header, mid, &frame);
+                if (frame.nameHash < hash) {
+                        low = mid + 1;
+                } else {
+                        high = mid;
+                }
+        }
+        for (size_t i = low; i < header.frameCount; i++) {
+                read_binary_frame(data, &header, i, outFrame);
+                if (outFrame->nameHash != hash) break;
+                if (outFrame->nameLength != length || (uint64_t)outFrame->nameOffset + length > header.fileSize) {
+                        continue;
+                }
+                if (memcmp(data + outFrame->nameOffset, name, length) == 0) return TRUE;
+        }
+        return FALSE;
+}
+
+uint32_t binary_name_hash(const char * name)
+{
+        uint32_t hash = 2166136261u;
+        while (*name) {
+                hash ^= (uint8_t)*name++;
+                hash *= 16777619u;
+        }
+        return hash;
+}
+
+binary_inflater * binary_inflater_create(void)
+{
+        return (binary_inflater *)calloc(1, sizeof(binary_inflater));
+}
+
+void binary_inflater_destroy(binary_inflater * inflater)
+{
+        if (inflater->data) {
+                inflateEnd(&inflater->stream);
+                free(inflater->data);
+        }
+        free(inflater);
+}
+
+int binary_inflater_push(binary_inflater * inflater, const uint8_t * data, size_t size)
+{
+        if (inflater->failed) return FALSE;
+        if (inflater->containerFill < binary_container_size) {
+                size_t take = binary_container_size - inflater->containerFill;
+                take = take < size ? take : size;
+                memcpy(inflater->container + inflater->containerFill, data, take);
+                inflater->containerFill += take;
+                data += take;
+                size -= take;
+                if (inflater->containerFill == binary_container_size && read_binary_container(inflater) == FALSE) {
+                        inflater->failed = TRUE;
+                        return FALSE;
+                }
+        }
+        // Anything after the end of the stream is ignored
+        while (size > 0 && inflater->finished == FALSE) {
+                z_stream * stream = &inflater->stream;
+                uInt chunk = (uInt)(size < binary_chunk_size ? size : binary_chunk_size);
+                stream->next_in = (Bytef *)data;
+                stream->avail_in = chunk;
+                int result = inflate(stream, Z_NO_FLUSH);
+                if (result == Z_STREAM_END) {
+                        inflater->finished = TRUE;
+                } else if (result != Z_OK) {
+                        // Z_BUF_ERROR here means the stream holds more than the header says the file does
+                        inflater->failed = TRUE;
+                        return FALSE;
+                }
+                size_t used = chunk - stream->avail_in;
+                data += used;
+                size -= used;
+        }
+        return TRUE;
+}
+
+uint8_t * binary_inflater_finish(binary_inflater * inflater, size_t * outSize)
+{
+        *outSize = 0;
+        if (inflater->failed || inflater->finished == FALSE) return NULL;
+        if (inflater->stream.total_in != inflater->compressedSize ||
+            inflater->stream.total_out != inflater->size - binary_header_size) {
+                return NULL;
+        }
+        if (decode_binary_transforms(inflater->data, inflater->size, inflater->transforms) == FALSE) return NULL;
+        uint8_t * data = inflater->data;
+        *outSize = inflater->size;
+        inflateEnd(&inflater->stream);
+        inflater->data = NULL;
+        inflater->size = 0;
+        inflater->failed = TRUE;
+        return data;
+}
+
+uint8_t * load_binary(FILE * input, size_t * outSize)
+{
+        *outSize = 0;
+        uint8_t * chunk = (uint8_t *)malloc(binary_chunk_size);
+        size_t read = fread(chunk, 1, binary_chunk_size, input);
+        uint8_t * data = NULL;
+        if (read >= sizeof(binary_magic) && memcmp(chunk, binary_magic, sizeof(binary_magic)) == 0) {
+                // A plain file is read as it is
+                size_t size = 0;
+                size_t capacity = binary_chunk_size;
+                data = (uint8_t *)malloc(capacity);
+                while (read > 0) {
+                        if (size + read > capacity) {
+                                capacity *= 2;
+                                data = (uint8_t *)realloc(data, capacity);
+                        }
+                        memcpy(data + size, chunk, read);
+                        size += read;
+                        read = fread(chunk, 1, binary_chunk_size, input);
+                }
+                binary_header header;
+                if (read_binary_header(data, size, &header) == FALSE) {
+                        free(data);
+                        data = NULL;
+                } else {
+                        *outSize = size;
+                }
+        } else {
+                binary_inflater * inflater = binary_inflater_create();
+                while (read > 0 && binary_inflater_push(inflater, chunk, read)) {
+                        read = fread(chunk, 1, binary_chunk_size, input);
+                }
+                data = binary_inflater_finish(inflater, outSize);
+                binary_inflater_destroy(inflater);
+        }
+        free(chunk);
+        return data;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+size_t align_binary(size_t offset)
+{
+        return (offset + binary_alignment - 1) & ~(binary_alignment - 1);
+}
+
+int compare_binary_entries(const void * a, const void * b)
+{
+        const binary_entry * ea = (const binary_entry *)a;
+        const binary_entry * eb = (const binary_entry *)b;
+        if (ea->frame.nameHash != eb->frame.nameHash) return (ea->frame.nameHash < eb->frame.nameHash) ? -1 : 1;
+        return (ea->order < eb->order) ? -1 : (ea->order > eb->order);
+}
+
+void put_binary_u16(uint8_t * p, uint16_t value)
+{
+        p[0] = (uint8_t)value;
+        p[1] = (uint8_t)(value >> 8);
+}
+
+void put_binary_u32(uint8_t * p, uint32_t value)
+{
+        p[0] = (uint8_t)value;
+        p[1] = (uint8_t)(value >> 8);
+        p[2] = (uint8_t)(value >> 16);
+        p[3] = (uint8_t)(value >> 24);
+}
+
+void put_binary_f32(uint8_t * p, float value)
+{
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        put_binary_u32(p, bits);
+}
+
+uint16_t get_binary_u16(const uint8_t * p)
+{
+        return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t get_binary_u32(const uint8_t * p)
+{
+        return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+float get_binary_f32(const uint8_t * p)
+{
+        uint32_t bits = get_binary_u32(p);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+}
+
+void write_binary_frame(uint8_t * p, const binary_frame * frame)
+{
+        put_binary_u32(p, frame->nameHash);
+        put_binary_u32(p + 4, frame->nameOffset);
+        put_binary_u32(p + 8, frame->nameLength);
+        p[12] = (uint8_t)frame->meshType;
+        p[13] = (uint8_t)frame->primitiveType;
+        p[14] = (uint8_t)frame->indexWidth;
+        p[15] = (uint8_t)frame->vertexFormat;
+        put_binary_u32(p + 16, frame->vertexOffset);
+        put_binary_u32(p + 20, frame->vertexCount);
+        put_binary_u32(p + 24, frame->partialOffset);
+        put_binary_u32(p + 28, frame->partialCount);
+        put_binary_u32(p + 32, frame->fullOffset);
+        put_binary_u32(p + 36, frame->fullCount);
+        put_binary_f32(p + 40, frame->origX);
+        put_binary_f32(p + 44, frame->origY);
+        const float * scale = &frame->scale.x;
+        const float * bias = &frame->bias.x;
+        for (int c = 0; c < 4; c++) {
+                put_binary_f32(p + 48 + c * 4, scale[c]);
+                put_binary_f32(p + 64 + c * 4, bias[c]);
+        }
+        put_binary_f32(p + 80, frame->uvTransform.scaleU);
+        put_binary_f32(p + 84, frame->uvTransform.scaleV);
+        put_binary_f32(p + 88, frame->uvTransform.biasU);
+        put_binary_f32(p + 92, frame->uvTransform.biasV);
+}
+
+// Position-only formats stop after y
+void write_binary_vertices(uint8_t * p, shrinkwrap * sw)
+{
+        int uvs = vertex_format_has_uvs(sw->vertexFormat);
+        size_t stride = vertex_format_size(sw->vertexFormat);
+        if (vertex_format_is_quantised(sw->vertexFormat)) {
+                for (size_t i = 0; i < array_size(sw->quantisedVertices); i++, p += stride) {
+                        const quantised_vert * q = (const quantised_vert *)array_get(sw->quantisedVertices, i);
+                        put_binary_u16(p, (uint16_t)q->x);
+                        put_binary_u16(p + 2, (uint16_t)q->y);
+                        if (uvs) {
+                                put_binary_u16(p + 4, q->u);
+                                put_binary_u16(p + 6, q->v);
+                        }
+                }
+        } else {
+                for (size_t i = 0; i < array_size(sw->vertices); i++, p += stride) {
+                        const vert * v = get_vert(sw->vertices, i);
+                        put_binary_f32(p, v->x);
+                        put_binary_f32(p + 4, v->y);
+                        if (uvs) {
+                                put_binary_f32(p + 8, v->u);
+                                put_binary_f32(p + 12, v->v);
+                        }
+                }
+        }
+}
+
+// Restart indices keep the width of their list: 0xFFFF in 16-bit lists
+void write_binary_indices(uint8_t * p, array * indices)
+{
+        size_t stride = array_stride(indices);
+        for (size_t i = 0; i < array_size(indices); i++, p += stride) {
+                if (stride == sizeof(uint16_t)) {
+                        put_binary_u16(p, *(const uint16_t *)array_get(indices, i));
+                } else {
+                        put_binary_u32(p, *(const uint32_t *)array_get(indices, i));
+                }
+        }
+}
+
+void write_binary_header(uint8_t * p, const binary_header * header)
+{
+        memset(p, 0, binary_header_size);
+        memcpy(p, binary_magic, sizeof(binary_magic));
+        put_binary_u32(p + 4, header->version);
+        put_binary_u32(p + 8, header->frameCount);
+        put_binary_u32(p + 12, header->directoryOffset);
+        put_binary_u32(p + 16, header->frameSize);
+        put_binary_u32(p + 20, header->namesOffset);
+        put_binary_u32(p + 24, header->namesSize);
+        put_binary_u32(p + 28, header->atlasWidth);
+        put_binary_u32(p + 32, header->atlasHeight);
+        put_binary_u32(p + 36, header->fileSize);
+}
+
+void write_binary_zeros(binary_sink_state * state, size_t size)
+{
+        static const uint8_t zeros[64] = {0};
+        while (size > 0) {
+                size_t chunk = size < sizeof(zeros) ? size : sizeof(zeros);
+                write_binary_blob(state, zeros, chunk);
+                size -= chunk;
+        }
+}
+
+// Pad the output to the next blob boundary and return its offset
+size_t write_binary_padding(binary_sink_state * state)
+{
+        write_binary_zeros(state, align_binary(state->offset) - state->offset);
+        return state->offset;
+}
+
+// Offsets count the bytes of the plain file, whether or not they are being deflated
+void write_binary_blob(binary_sink_state * state, const uint8_t * data, size_t size)
+{
+        if (size == 0) return;
+        if (state->stream) {
+                deflate_binary(state, data, size, Z_NO_FLUSH);
+        } else {
+                write_binary_output(state, data, size);
+        }
+        state->offset += size;
+        if (state->offset > UINT32_MAX) {
+                state->failed = TRUE;
+        }
+}
+
+void write_binary_output(binary_sink_state * state, const uint8_t * data, size_t size)
+{
+        if (state->failed == FALSE && fwrite(data, 1, size, state->output) != size) {
+                state->failed = TRUE;
+        }
+}
+
+// Feed data to the deflate stream and write out whatever it produces.  Z_FINISH flushes the end of the stream.
+void deflate_binary(binary_sink_state * state, const uint8_t * data, size_t size, int flush)
+{
+        z_stream * stream = state->stream;
+        stream->next_in = (Bytef *)data;
+        stream->avail_in = (uInt)size;
+        do {
+                stream->next_out = state->compressed;
+                stream->avail_out = (uInt)binary_chunk_size;
+                if (deflate(stream, flush) == Z_STREAM_ERROR) {
+                        state->failed = TRUE;
+                        return;
+                }
+                size_t produced = binary_chunk_size - stream->avail_out;
+                write_binary_output(state, state->compressed, produced);
+                state->compressedSize += produced;
+        } while (stream->avail_out == 0);
+}
+
+uint32_t zigzag_binary(uint32_t difference, size_t width)
+{
+        uint32_t mask = (width == sizeof(uint16_t)) ? 0xFFFF : 0xFFFFFFFF;
+        uint32_t sign = (difference >> (width * 8 - 1)) & 1;
+        return ((difference << 1) ^ (0u - sign)) & mask;
+}
+
+uint32_t unzigzag_binary(uint32_t value, size_t width)
+{
+        uint32_t mask = (width == sizeof(uint16_t)) ? 0xFFFF : 0xFFFFFFFF;
+        return ((value >> 1) ^ (0u - (value & 1))) & mask;
+}
+
+// Replace each little-endian value of 'width' bytes with the zig-zag difference from the value 'interleave' places
+// before it, wrapping at the width.  The first 'interleave' values are differenced from zero.
+void delta_encode_binary(uint8_t * p, size_t count, size_t width, size_t interleave)
+{
+        // Backwards, so each value is differenced from the original before it
+        for (size_t i = count; i-- > 0;) {
+                uint8_t * value = p + i * width;
+                uint8_t * before = value - interleave * width;
+                if (width == sizeof(uint16_t)) {
+                        uint32_t previous = (i >= interleave) ? get_binary_u16(before) : 0;
+                        put_binary_u16(value, (uint16_t)zigzag_binary(get_binary_u16(value) - previous, width));
+                } else {
+                        uint32_t previous = (i >= interleave) ? get_binary_u32(before) : 0;
+                        put_binary_u32(value, zigzag_binary(get_binary_u32(value) - previous, width));
+                }
+        }
+}
+
+void delta_decode_binary(uint8_t * p, size_t count, size_t width, size_t interleave)
+{
+        for (size_t i = 0; i < count; i++) {
+                uint8_t * value = p + i * width;
+                uint8_t * before = value - interleave * width;
+                if (width == sizeof(uint16_t)) {
+                        uint32_t previous = (i >= interleave) ? get_binary_u16(before) : 0;
+                        put_binary_u16(value, (uint16_t)(unzigzag_binary(get_binary_u16(value), width) + previous));
+                } else {
+                        uint32_t previous = (i >= interleave) ? get_binary_u32(before) : 0;
+                        put_binary_u32(value, unzigzag_binary(get_binary_u32(value), width) + previous);
+                }
+        }
+}
+
+// Undo the transforms on every frame of an inflated file, checking each blob lies within it
+int decode_binary_transforms(uint8_t * data, size_t size, unsigned transforms)
+{
+        binary_header header;
+        if (read_binary_header(data, size, &header) == FALSE) return FALSE;
+        for (size_t i = 0; i < header.frameCount; i++) {
+                binary_frame frame;
+                read_binary_frame(data, &header, i, &frame);
+                if ((size_t)frame.vertexFormat >= VERTEX_FORMAT_COUNT) return FALSE;
+                size_t components = vertex_format_has_uvs(frame.vertexFormat) ? 4 : 2;
+                size_t vertexWidth = vertex_format_size(frame.vertexFormat) / components;
+                size_t indexWidth = (frame.indexWidth == INDEX_WIDTH_16) ? sizeof(uint16_t) : sizeof(uint32_t);
+                uint64_t vertexEnd = frame.vertexOffset + (uint64_t)frame.vertexCount * components * vertexWidth;
+                uint64_t partialEnd = frame.partialOffset + (uint64_t)frame.partialCount * indexWidth;
+                uint64_t fullEnd = frame.fullOffset + (uint64_t)frame.fullCount * indexWidth;
+                if (vertexEnd > header.fileSize || partialEnd > header.fileSize || fullEnd > header.fileSize) {
+                        return FALSE;
+                }
+                if (transforms & BINARY_TRANSFORM_VERTEX_DELTA) {
+                        delta_decode_binary(data + frame.vertexOffset, frame.vertexCount * components, vertexWidth,
+                                            components);
+                }
+                if (transforms & BINARY_TRANSFORM_INDEX_DELTA) {
+                        delta_decode_binary(data + frame.partialOffset, frame.partialCount, indexWidth, 1);
+                        delta_decode_binary(data + frame.fullOffset, frame.fullCount, indexWidth, 1);
+                }
+        }
+        return TRUE;
+}
+
+// Check the container once it has all arrived, then set up the plain file and the stream that fills it
+int read_binary_container(binary_inflater * inflater)
+{
+        const uint8_t * p = inflater->container;
+        if (memcmp(p, binary_compressed_magic, sizeof(binary_compressed_magic)) != 0) return FALSE;
+        if (get_binary_u32(p + 4) != binary_compressed_version) return FALSE;
+        inflater->transforms = get_binary_u32(p + 8);
+        inflater->compressedSize = get_binary_u32(p + 12);
+        const uint8_t * header = p + binary_container_size - binary_header_size;
+        uint32_t fileSize = get_binary_u32(header + 36);
+        if (memcmp(header, binary_magic, sizeof(binary_magic)) != 0 || fileSize < binary_header_size) return FALSE;
+        // The header is untrusted, so don't allocate more than the stream could possibly inflate to
+        if (fileSize - binary_header_size > (uint64_t)inflater->compressedSize * binary_max_inflate_ratio) return FALSE;
+        uint8_t * data = (uint8_t *)malloc(fileSize);
+        if (data == NULL) return FALSE;
+        if (inflateInit(&inflater->stream) != Z_OK) {
+                free(data);
+                return FALSE;
+        }
+        inflater->size = fileSize;
+        inflater->data = data;
+        memcpy(inflater->data, header, binary_header_size);
+        inflater->stream.next_out = inflater->data + binary_header_size;
+        inflater->stream.avail_out = (uInt)(fileSize - binary_header_size);
+        return TRUE;
+}
+
+// Space for the header is left now and filled in by binary_sink_end.
+int binary_sink_begin(mesh_sink * sink, uint32_t atlasWidth, uint32_t atlasHeight)
+{
+        binary_sink_state * state = (binary_sink_state *)sink->context;
+        state->atlasWidth = atlasWidth;
+        state->atlasHeight = atlasHeight;
+        if (state->stream) {
+                uint8_t * container = (uint8_t *)calloc(1, binary_container_size);
+                write_binary_output(state, container, binary_container_size);
+                free(container);
+                state->offset = binary_header_size;
+        } else {
+                write_binary_zeros(state, binary_header_size);
+        }
+        return state->failed == FALSE;
+}
+
+int binary_sink_frame(mesh_sink * sink, shrinkwrap * sw, const char * name)
+{
+        binary_sink_state * state = (binary_sink_state *)sink->context;
+        binary_entry * entry = (binary_entry *)array_push(state->entries);
+        memset(entry, 0, sizeof(binary_entry));
+        name = name ? name : "";
+        size_t length = strlen(name);
+        entry->name = (char *)malloc(length + 1);
+        memcpy(entry->name, name, length + 1);
+        entry->order = array_size(state->entries) - 1;
+        binary_frame * frame = &entry->frame;
+        frame->nameHash = binary_name_hash(name);
+        frame->nameLength = (uint32_t)length;
+        int quantised = vertex_format_is_quantised(sw->vertexFormat);
+        array * vertices = quantised ? sw->quantisedVertices : sw->vertices;
+        frame->meshType = sw->meshType;
+        frame->primitiveType = sw->primitiveType;
+        frame->indexWidth = sw->indexWidth;
+        frame->vertexFormat = sw->vertexFormat;
+        frame->origX = sw->origX;
+        frame->origY = sw->origY;
+        if (quantised) {
+                frame->scale = sw->quantisation.scale;
+                frame->bias = sw->quantisation.bias;
+        } else {
+                vert one = {1.0f, 1.0f, 1.0f, 1.0f};
+                frame->scale = one;
+        }
+        frame->vertexCount = (uint32_t)array_size(vertices);
+        frame->partialCount = (uint32_t)array_size(sw->indicesPartialAlpha);
+        frame->fullCount = (uint32_t)array_size(sw->indicesFullAlpha);
+        frame->uvTransform = sw->uvTransform;
+        size_t vertexBytes = frame->vertexCount * vertex_format_size(sw->vertexFormat);
+        size_t partialBytes = frame->partialCount * array_stride(sw->indicesPartialAlpha);
+        size_t fullBytes = frame->fullCount * array_stride(sw->indicesFullAlpha);
+        size_t largest = vertexBytes > partialBytes ? vertexBytes : partialBytes;
+        largest = largest > fullBytes ? largest : fullBytes;
+        uint8_t * buffer = (uint8_t *)malloc(largest + 1);
+        frame->vertexOffset = (uint32_t)write_binary_padding(state);
+        write_binary_vertices(buffer, sw);
+        if (state->transforms & BINARY_TRANSFORM_VERTEX_DELTA) {
+                size_t components = vertex_format_has_uvs(sw->vertexFormat) ? 4 : 2;
+                delta_encode_binary(buffer, frame->vertexCount * components, quantised ? sizeof(uint16_t) :
+                                    sizeof(uint32_t), components);
+        }
+        write_binary_blob(state, buffer, vertexBytes);
+        frame->partialOffset = (uint32_t)write_binary_padding(state);
+        write_binary_indices(buffer, sw->indicesPartialAlpha);
+        if (state->transforms & BINARY_TRANSFORM_INDEX_DELTA) {
+                delta_encode_binary(buffer, frame->partialCount, array_stride(sw->indicesPartialAlpha), 1);
+        }
+        write_binary_blob(state, buffer, partialBytes);
+        frame->fullOffset = (uint32_t)write_binary_padding(state);
+        write_binary_indices(buffer, sw->indicesFullAlpha);
+        if (state->transforms & BINARY_TRANSFORM_INDEX_DELTA) {
+                delta_encode_binary(buffer, frame->fullCount, array_stride(sw->indicesFullAlpha), 1);
+        }
+        write_binary_blob(state, buffer, fullBytes);
+        free(buffer);
+        return state->failed == FALSE;
+}
+
+// Write the names and the sorted directory, then go back and fill in the header, or the container when compressing.
+int binary_sink_end(mesh_sink * sink)
+{
+        binary_sink_state * state = (binary_sink_state *)sink->context;
+        size_t count = array_size(state->entries);
+        binary_entry * entries = count ? (binary_entry *)array_get(state->entries, 0) : NULL;
+        binary_header header;
+        memset(&header, 0, sizeof(header));
+        header.namesOffset = (uint32_t)write_binary_padding(state);
+        for (size_t i = 0; i < count; i++) {
+                entries[i].frame.nameOffset = (uint32_t)state->offset;
+                write_binary_blob(state, (const uint8_t *)entries[i].name, entries[i].frame.nameLength + 1);
+        }
+        header.namesSize = (uint32_t)(state->offset - header.namesOffset);
+        if (count) {
+                qsort(entries, count, sizeof(binary_entry), compare_binary_entries);
+        }
+        header.directoryOffset = (uint32_t)write_binary_padding(state);
+        uint8_t * bytes = (uint8_t *)malloc(binary_container_size > binary_frame_size ? binary_container_size :
+                                            binary_frame_size);
+        for (size_t i = 0; i < count; i++) {
+                write_binary_frame(bytes, &entries[i].frame);
+                write_binary_blob(state, bytes, binary_frame_size);
+        }
+        header.version = binary_version;
+        header.frameCount = (uint32_t)count;
+        header.frameSize = (uint32_t)binary_frame_size;
+        header.atlasWidth = state->atlasWidth;
+        header.atlasHeight = state->atlasHeight;
+        header.fileSize = (uint32_t)write_binary_padding(state);
+        size_t headerSize = binary_header_size;
+        if (state->stream) {
+                // The plain header goes uncompressed at the end of the container
+                deflate_binary(state, NULL, 0, Z_FINISH);
+                memcpy(bytes, binary_compressed_magic, sizeof(binary_compressed_magic));
+                put_binary_u32(bytes + 4, binary_compressed_version);
+                put_binary_u32(bytes + 8, state->transforms);
+                put_binary_u32(bytes + 12, (uint32_t)state->compressedSize);
+                headerSize = binary_container_size;
+                if (state->compressedSize > UINT32_MAX) {
+                        state->failed = TRUE;
+                }
+        }
+        write_binary_header(bytes + headerSize - binary_header_size, &header);
+        if (state->failed == FALSE) {
+                if (fseek(state->output, 0, SEEK_SET) != 0 ||
+                    fwrite(bytes, 1, headerSize, state->output) != headerSize) {
+                        state->failed = TRUE;
+                }
+                fseek(state->output, 0, SEEK_END);
+        }
+        free(bytes);
+        return state->failed == FALSE;
+}
+
+void binary_sink_destroy(mesh_sink * sink)
+{
+        binary_sink_state * state = (binary_sink_state *)sink->context;
+        for (size_t i = 0; i < array_size(state->entries); i++) {
+                free(((binary_entry *)array_get(state->entries, i))->name);
+        }
+        array_destroy(state->entries);
+        if (state->stream) {
+                deflateEnd(state->stream);
+                free(state->stream);
+        }
+        free(state->compressed);
+        free(state);
+        free(sink);
+}
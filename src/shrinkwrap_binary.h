@@ -0,0 +1,130 @@
+//
+//  shrinkwrap_binary.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_shrinkwrap_binary_h
+#define shrinkwrap_shrinkwrap_binary_h
+
+#include <stdio.h>
+#include "shrinkwrap_t.h"
+#include "pixel_t.h"
+
+// Binary mesh file, little-endian throughout:
+//   header     binary_header_size bytes
+//   blobs      per frame: vertices, then partial alpha indices, then full alpha indices
+//   names      the frame names, each NUL-terminated
+//   directory  frameCount entries of binary_frame_size bytes, sorted by name hash
+// Every offset is from the start of the file, and every section and blob starts on a binary_alignment boundary, so a
+// mapped file can be handed to vertex and index buffers without copying.  Vertices are laid out as vert or
+// quantised_vert, or just their positions, and indices as 16 or 32-bit integers, as given by the frame's vertexFormat
+// and indexWidth.  The directory comes last so frames can be written as they are meshed; the header is filled in once
+// they are all known.
+static const char binary_magic[4] = {'S', 'W', 'R', 'P'};
+static const uint32_t binary_version = 2;
+static const size_t binary_alignment = 16;
+static const size_t binary_header_size = 48;
+static const size_t binary_frame_size = 96;
+
+// Compressed binary mesh file:
+//   container  binary_container_size bytes: magic, version, transforms, compressed size, then the plain file's header
+//   stream     a zlib stream of the rest of the plain file, each blob first rewritten by the transforms
+// The transforms turn slowly changing vertices and indices into runs of small numbers that deflate well.  A
+// binary_inflater rebuilds the plain file from the container as its bytes arrive.
+static const char binary_compressed_magic[4] = {'S', 'W', 'R', 'Z'};
+static const uint32_t binary_compressed_version = 1;
+static const size_t binary_container_size = 64;
+
+typedef enum binary_transform_enum {
+        BINARY_TRANSFORM_NONE = 0,
+        // Each vertex component is stored as the zig-zag difference from the same component of the previous vertex
+        BINARY_TRANSFORM_VERTEX_DELTA = 1,
+        // Each index is stored as the zig-zag difference from the previous index in its list
+        BINARY_TRANSFORM_INDEX_DELTA = 2,
+        BINARY_TRANSFORM_ALL = 3
+} binary_transform;
+
+typedef struct binary_inflater_struct binary_inflater;
+
+typedef struct binary_header_struct {
+        uint32_t version;
+        uint32_t frameCount;
+        uint32_t directoryOffset;
+        uint32_t frameSize;
+        uint32_t namesOffset;
+        uint32_t namesSize;
+        uint32_t atlasWidth;
+        uint32_t atlasHeight;
+        uint32_t fileSize;
+} binary_header;
+
+// A directory entry.  Counts are in vertices and indices, not bytes.
+typedef struct binary_frame_struct {
+        // FNV-1a of the name, see binary_name_hash
+        uint32_t nameHash;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+        mesh_choice meshType;
+        primitive primitiveType;
+        index_width indexWidth;
+        vertex_format vertexFormat;
+        uint32_t vertexOffset;
+        uint32_t vertexCount;
+        uint32_t partialOffset;
+        uint32_t partialCount;
+        uint32_t fullOffset;
+        uint32_t fullCount;
+        float origX;
+        float origY;
+        // Dequantises quantised vertices; a scale of 1 and bias of 0 for float vertices
+        vert scale;
+        vert bias;
+        // Rebuilds the UVs of position-only vertices from their dequantised positions
+        uv_transform uvTransform;
+} binary_frame;
+
+// Writes each frame's blobs as it arrives, then the names and directory.  The output must be seekable, as the header
+// is written last.
+mesh_sink * create_binary_sink(FILE * output);
+// As create_binary_sink, but deflates everything after the header at a zlib level from 0 to 9.  transforms is a
+// combination of binary_transform flags.
+mesh_sink * create_compressed_binary_sink(FILE * output, int level, unsigned transforms);
+// Write every shrinkwrap, naming each after the matching entry of names.  A NULL name is stored as an empty one.
+// Returns FALSE if the file could not be written or would pass 4GB.
+int save_binary(FILE * output, shrinkwrap ** geometry_list, const char ** names, size_t count, pxl_size width,
+                pxl_size height);
+
+// Check the magic, version and bounds of a binary mesh file and read its header
+int read_binary_header(const uint8_t * data, size_t size, binary_header * outHeader);
+void read_binary_frame(const uint8_t * data, const binary_header * header, size_t i, binary_frame * outFrame);
+// Binary search the directory for a frame by name
+int find_binary_frame(const uint8_t * data, size_t size, const char * name, binary_frame * outFrame);
+uint32_t binary_name_hash(const char * name);
+
+// Streaming decompressor for compressed files
+binary_inflater * binary_inflater_create(void);
+void binary_inflater_destroy(binary_inflater * inflater);
+// Feed the next bytes of the compressed file.  Returns FALSE once the data is known to be bad.
+int binary_inflater_push(binary_inflater * inflater, const uint8_t * data, size_t size);
+// Take the plain file once the whole container has been pushed, or NULL if it is incomplete or bad.  The caller
+// frees the result.
+uint8_t * binary_inflater_finish(binary_inflater * inflater, size_t * outSize);
+// Read a plain or compressed binary mesh file into memory as a plain one.  Returns NULL if it is not a valid file.
+uint8_t * load_binary(FILE * input, size_t * outSize);
+#endif
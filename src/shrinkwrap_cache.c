@@ -0,0 +1,220 @@
+//
+//  shrinkwrap_cache.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_cache_internal.h"
+
+// Vertex cache optimisation
+///////////////////////////////////////////////////////////////////////////////
+// Triangles are reordered with Tom Forsyth's linear-speed vertex cache optimisation: every vertex is scored by its
+// position in a modelled LRU cache and by how few triangles still use it, and the next triangle emitted is the
+// highest scoring triangle touching the cache.  Only the order of triangles changes; each keeps its winding.
+static const float c_cache_decay_power = 1.5f;
+static const float c_last_triangle_score = 0.75f;
+static const float c_valence_boost_scale = 2.0f;
+static const float c_valence_boost_power = 0.5f;
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Reorder both triangle lists of the shrinkwrap for the post-transform vertex cache.
+void optimise_vertex_cache(shrinkwrap * sw)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && "Optimise the vertex cache before stripifying");
+        size_t vertexCount = array_size(sw->vertices);
+        optimise_indices(sw->indicesFullAlpha, vertexCount);
+        optimise_indices(sw->indicesPartialAlpha, vertexCount);
+}
+
+// Average cache miss ratio - vertices transformed per triangle - drawing each triangle list through a FIFO cache.
+float vertex_cache_acmr(shrinkwrap * sw, size_t cacheSize)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES);
+        size_t triangles = (array_size(sw->indicesFullAlpha) + array_size(sw->indicesPartialAlpha)) / 3;
+        if (triangles == 0) return 0.0f;
+        size_t misses = simulate_cache_misses(sw->indicesFullAlpha, cacheSize);
+        misses += simulate_cache_misses(sw->indicesPartialAlpha, cacheSize);
+        return (float)misses / (float)triangles;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Count the vertices transformed drawing an index list through an empty FIFO cache.
+size_t simulate_cache_misses(array * indices, size_t cacheSize)
+{
+        size_t count = array_size(indices);
+        if (count == 0) return 0;
+        uint32_t * fifo = (uint32_t *)malloc(sizeof(uint32_t) * cacheSize);
+        size_t used = 0;
+        size_t next = 0;
+        size_t misses = 0;
+        for (size_t i = 0; i < count; i++) {
+                uint32_t index = get_index(indices, i);
+                int hit = FALSE;
+                for (size_t c = 0; c < used; c++) {
+                        if (fifo[c] == index) {
+                                hit = TRUE;
+                                break;
+                        }
+                }
+                if (hit) continue;
+                misses++;
+                fifo[next] = index;
+                next = (next + 1) % cacheSize;
+                if (used < cacheSize) used++;
+        }
+        free(fifo);
+        return misses;
+}
+
+float vertex_score(const cache_vertex * v)
+{
+        if (v->remaining == 0) return -1.0f;
+        float score = 0.0f;
+        if (v->position >= 0) {
+                if (v->position < 3) {
+                        // The last triangle's vertices score the same so its order does not matter
+                        score = c_last_triangle_score;
+                } else {
+                        const float scaler = 1.0f / (VERTEX_CACHE_SIZE - 3);
+                        score = powf(1.0f - (v->position - 3) * scaler, c_cache_decay_power);
+                }
+        }
+        // Favour vertices with few triangles left to finish them off
+        score += c_valence_boost_scale * powf((float)v->remaining, -c_valence_boost_power);
+        return score;
+}
+
+static float triangle_score(const cache_vertex * vertices, const uint32_t * triangle)
+{
+        return vertices[triangle[0]].score + vertices[triangle[1]].score + vertices[triangle[2]].score;
+}
+
+// Reorder one triangle list in place.
+void optimise_indices(array * indices, size_t vertexCount)
+{
+        size_t count = array_size(indices);
+        assert(count % 3 == 0 && "Indices not divisible by 3!");
+        size_t triangles = count / 3;
+        if (triangles < 2) return;
+        uint32_t * source = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        for (size_t i = 0; i < count; i++) {
+                source[i] = get_index(indices, i);
+        }
+        // Triangles of each vertex, grouped by vertex
+        cache_vertex * vertices = (cache_vertex *)calloc(vertexCount, sizeof(cache_vertex));
+        for (size_t i = 0; i < count; i++) {
+                assert(source[i] < vertexCount);
+                vertices[source[i]].remaining++;
+        }
+        uint32_t offset = 0;
+        for (size_t v = 0; v < vertexCount; v++) {
+                vertices[v].first = offset;
+                offset += vertices[v].remaining;
+                vertices[v].remaining = 0;
+                vertices[v].position = -1;
+        }
+        uint32_t * vertexTriangles = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        for (size_t i = 0; i < count; i++) {
+                cache_vertex * v = vertices + source[i];
+                vertexTriangles[v->first + v->remaining++] = (uint32_t)(i / 3);
+        }
+        for (size_t v = 0; v < vertexCount; v++) {
+                vertices[v].score = vertex_score(vertices + v);
+        }
+        float * scores = (float *)malloc(sizeof(float) * triangles);
+        uch * emitted = (uch *)calloc(triangles, sizeof(uch));
+        for (size_t t = 0; t < triangles; t++) {
+                scores[t] = triangle_score(vertices, source + t * 3);
+        }
+        uint32_t cache[VERTEX_CACHE_SIZE];
+        size_t cached = 0;
+        size_t scan = 0;
+        uint32_t best = 0;
+        for (size_t t = 1; t < triangles; t++) {
+                if (scores[t] > scores[best]) best = (uint32_t)t;
+        }
+        for (size_t out = 0; out < triangles; out++) {
+                const uint32_t * triangle = source + best * 3;
+                set_index(indices, out * 3, triangle[0]);
+                set_index(indices, out * 3 + 1, triangle[1]);
+                set_index(indices, out * 3 + 2, triangle[2]);
+                emitted[best] = TRUE;
+                // Retire the triangle from its vertices
+                for (int i = 0; i < 3; i++) {
+                        cache_vertex * v = vertices + triangle[i];
+                        uint32_t * list = vertexTriangles + v->first;
+                        for (uint32_t j = 0; j < v->remaining; j++) {
+                                if (list[j] == best) {
+                                        list[j] = list[--v->remaining];
+                                        break;
+                                }
+                        }
+                }
+                // Move the triangle's vertices to the front of the cache
+                uint32_t updated[VERTEX_CACHE_SIZE + 3];
+                size_t updatedCount = 0;
+                for (int i = 0; i < 3; i++) updated[updatedCount++] = triangle[i];
+                for (size_t c = 0; c < cached; c++) {
+                        uint32_t index = cache[c];
+                        if (index != triangle[0] && index != triangle[1] && index != triangle[2]) {
+                                updated[updatedCount++] = index;
+                        }
+                }
+                cached = 0;
+                for (size_t c = 0; c < updatedCount; c++) {
+                        cache_vertex * v = vertices + updated[c];
+                        if (c < VERTEX_CACHE_SIZE) {
+                                cache[cached++] = updated[c];
+                                v->position = (int)c;
+                        } else {
+                                v->position = -1;
+                        }
+                        v->score = vertex_score(v);
+                }
+                // Rescore triangles touching the updated vertices and pick the best of them
+                float bestScore = -1.0f;
+                for (size_t c = 0; c < updatedCount; c++) {
+                        const cache_vertex * v = vertices + updated[c];
+                        for (uint32_t j = 0; j < v->remaining; j++) {
+                                uint32_t t = vertexTriangles[v->first + j];
+                                scores[t] = triangle_score(vertices, source + t * 3);
+                                if (scores[t] > bestScore) {
+                                        bestScore = scores[t];
+                                        best = t;
+                                }
+                        }
+                }
+                if (bestScore < 0.0f && out + 1 < triangles) {
+                        // Nothing left touching the cache - continue with the next triangle not yet emitted
+                        while (emitted[scan]) scan++;
+                        best = (uint32_t)scan;
+                }
+        }
+        free(source);
+        free(vertices);
+        free(vertexTriangles);
+        free(scores);
+        free(emitted);
+}
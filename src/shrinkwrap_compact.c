@@ -0,0 +1,144 @@
+//
+//  shrinkwrap_compact.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_compact_internal.h"
+
+static const uint32_t c_unmapped = 0xFFFFFFFF;
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Drop vertices no triangle references, weld vertices at identical positions and renumber the rest in the order they
+// are first drawn.  Frames that fall below 65536 vertices switch to 16-bit indices.
+void compact_vertices(shrinkwrap * sw)
+{
+        size_t count = array_size(sw->vertices);
+        if (count == 0) return;
+        uch * referenced = (uch *)calloc(count, sizeof(uch));
+        array * lists[] = {sw->indicesFullAlpha, sw->indicesPartialAlpha};
+        for (int l = 0; l < 2; l++) {
+                for (size_t i = 0; i < array_size(lists[l]); i++) {
+                        uint32_t index = get_index(lists[l], i);
+                        if (index == shrinkwrap_restart_index) continue;
+                        assert(index < count && "Index outside vertex list");
+                        referenced[index] = TRUE;
+                }
+        }
+        uint32_t * welded = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        weld_vertices(sw->vertices, referenced, welded);
+        uint32_t * remap = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        for (size_t v = 0; v < count; v++) {
+                remap[v] = c_unmapped;
+        }
+        size_t kept = remap_indices(sw->indicesFullAlpha, welded, remap, 0);
+        kept = remap_indices(sw->indicesPartialAlpha, welded, remap, kept);
+        array * vertices = array_create(kept > 0 ? kept : 1, sizeof(vert));
+        for (size_t v = 0; v < kept; v++) {
+                array_push(vertices);
+        }
+        for (size_t v = 0; v < count; v++) {
+                if (remap[v] != c_unmapped) {
+                        *get_vert(vertices, remap[v]) = *get_vert(sw->vertices, v);
+                }
+        }
+        array_destroy(sw->vertices);
+        sw->vertices = vertices;
+        if (sw->indexWidth == INDEX_WIDTH_32 && kept <= shrinkwrap_restart_index16) {
+                sw->indexWidth = INDEX_WIDTH_16;
+                sw->indicesFullAlpha = narrow_indices(sw->indicesFullAlpha, sw->indexWidth);
+                sw->indicesPartialAlpha = narrow_indices(sw->indicesPartialAlpha, sw->indexWidth);
+        }
+        free(referenced);
+        free(welded);
+        free(remap);
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+static int compare_weld_entries(const void * a, const void * b)
+{
+        const weld_entry * ea = (const weld_entry *)a;
+        const weld_entry * eb = (const weld_entry *)b;
+        if (ea->x != eb->x) return (ea->x < eb->x) ? -1 : 1;
+        if (ea->y != eb->y) return (ea->y < eb->y) ? -1 : 1;
+        if (ea->index != eb->index) return (ea->index < eb->index) ? -1 : 1;
+        return 0;
+}
+
+// Point each referenced vertex at the lowest numbered referenced vertex with the same position.  UVs are not compared
+// as they follow from the position.  Returns the number of distinct positions.
+size_t weld_vertices(array * vertices, const uch * referenced, uint32_t * outWelded)
+{
+        size_t count = array_size(vertices);
+        weld_entry * entries = (weld_entry *)malloc(sizeof(weld_entry) * (count > 0 ? count : 1));
+        size_t used = 0;
+        for (size_t v = 0; v < count; v++) {
+                outWelded[v] = c_unmapped;
+                if (referenced[v] == FALSE) continue;
+                vertp vertex = get_vert(vertices, v);
+                weld_entry e = {vertex->x, vertex->y, (uint32_t)v};
+                entries[used++] = e;
+        }
+        qsort(entries, used, sizeof(weld_entry), compare_weld_entries);
+        size_t distinct = 0;
+        uint32_t keep = 0;
+        for (size_t i = 0; i < used; i++) {
+                if (i == 0 || entries[i].x != entries[i - 1].x || entries[i].y != entries[i - 1].y) {
+                        keep = entries[i].index;
+                        distinct++;
+                }
+                outWelded[entries[i].index] = keep;
+        }
+        free(entries);
+        return distinct;
+}
+
+// Rewrite an index list through the welded vertices, numbering vertices in order of first use from 'next'.  Returns
+// the next unused number.
+size_t remap_indices(array * indices, const uint32_t * welded, uint32_t * remap, size_t next)
+{
+        for (size_t i = 0; i < array_size(indices); i++) {
+                uint32_t index = get_index(indices, i);
+                if (index == shrinkwrap_restart_index) continue;
+                uint32_t target = welded[index];
+                assert(target != c_unmapped);
+                if (remap[target] == c_unmapped) {
+                        remap[target] = (uint32_t)next++;
+                }
+                set_index(indices, i, remap[target]);
+        }
+        return next;
+}
+
+// Copy an index list to a narrower one, destroying the original.
+array * narrow_indices(array * indices, index_width width)
+{
+        size_t count = array_size(indices);
+        array * out = array_create(count > 0 ? count : 1, width);
+        for (size_t i = 0; i < count; i++) {
+                push_index(out, get_index(indices, i));
+        }
+        array_destroy(indices);
+        return out;
+}
@@ -0,0 +1,506 @@
+//
+//  shrinkwrap_contour.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_contour_internal.h"
+#include "internal/shrinkwrap_earclip_internal.h"
+#include "internal/shrinkwrap_triangle_internal.h"
+
+static const char * const c_engine_names[] = {"scanline", "contour", "hull"};
+static const size_t c_engine_count = sizeof(c_engine_names) / sizeof(c_engine_names[0]);
+
+// Marching squares
+///////////////////////////////////////////////////////////////////////////////
+// Contours follow pixel edges between lattice corners, corner (x, y) being the top left of pixel (x, y), so they bound
+// whole pixels and cover the last row and column, which build_curves leaves out.  Each step keeps the region on its
+// right.  Where two diagonal pixels of a region meet at a corner the trace turns right, keeping to the pixel it is
+// already following, so regions are 4-connected.  Every edge is followed once: O(perimeter) after one pass over the
+// pixels to find unvisited top edges to start from.
+//
+// Visible pixels and opaque pixels are traced separately.  The partial alpha mesh is the visible region less the
+// opaque one, so both meshes share the opaque borders and cannot leave a gap between them.
+static const pxl_diff c_stepX[] = {1, 0, -1, 0};
+static const pxl_diff c_stepY[] = {0, 1, 0, -1};
+// Pixel on the right of each step from a corner; the pixel on its left is the one right of the step before
+static const pxl_diff c_rightX[] = {0, -1, -1, 0};
+static const pxl_diff c_rightY[] = {0, 0, -1, -1};
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Trace the borders of the visible and opaque regions of a type pixel map.
+contour_list * trace_contours(const tpxl * tpixels, pxl_size w, pxl_size h)
+{
+        contour_list * cl = (contour_list *)malloc(contour_list_size);
+        cl->contours = array_create(16, contour_size);
+        cl->width = w;
+        cl->height = h;
+        uint8_t * visited = (uint8_t *)malloc((size_t)w * (h + 1));
+        trace_alpha_contours(cl, tpixels, w, h, ALPHA_ANYALPHA, visited);
+        trace_alpha_contours(cl, tpixels, w, h, ALPHA_FULL, visited);
+        free(visited);
+        return cl;
+}
+
+// Conservative Douglas-Peucker
+///////////////////////////////////////////////////////////////////////////////
+// Each contour is split at its first point and the point furthest from it, and each half is simplified as in
+// simplify_douglas_peucker.  A chord may replace a run of points only if every point is within 'bleed' pixels of it
+// and on the side the contour may move towards: visible borders only grow and opaque borders only shrink.  So no
+// visible pixel is left uncovered and no blended pixel is drawn opaque.  The chord must also neither cross nor enclose
+// the live points of any contour, including the rest of its own, so the borders stay apart.
+void simplify_contours(contour_list * cl, float bleed)
+{
+        size_t count = array_size(cl->contours);
+        if (count == 0) return;
+        contour_simplify s;
+        s.cl = cl;
+        s.bleed = bleed;
+        // Simplified contours keep a subset of their points, so their first bounds stay valid
+        s.bounds = (contour_bounds *)malloc(sizeof(contour_bounds) * count);
+        size_t maxPoints = 0;
+        for (size_t i = 0; i < count; i++) {
+                contour * c = get_contour(cl, i);
+                measure_contour_bounds(c, s.bounds + i);
+                if (array_size(c->points) > maxPoints) maxPoints = array_size(c->points);
+        }
+        s.kept = (uint8_t *)malloc(maxPoints);
+        for (size_t i = 0; i < count; i++) {
+                s.current = i;
+                simplify_contour(&s);
+        }
+        free(s.kept);
+        free(s.bounds);
+}
+
+// Ear clip the opaque regions into the full alpha mesh and the visible regions less the opaque ones into the partial
+// alpha mesh.  Each hole is clipped with the smallest outer border that contains it.
+shrinkwrap * triangulate_contours(contour_list * cl)
+{
+        size_t count = array_size(cl->contours);
+        uint32_t numVerts = 0;
+        for (size_t i = 0; i < count; i++) {
+                contour * c = get_contour(cl, i);
+                c->index = numVerts;
+                if (contour_is_meshed(c)) {
+                        numVerts += (uint32_t)array_size(c->points);
+                }
+        }
+        shrinkwrap * sw = create_shrink_wrap(numVerts > 0 ? numVerts : 1);
+        for (size_t i = 0; i < count; i++) {
+                contour * c = get_contour(cl, i);
+                if (contour_is_meshed(c) == FALSE) continue;
+                for (size_t p = 0; p < array_size(c->points); p++) {
+                        *add_vert(sw->vertices) = *(vert *)array_get(c->points, p);
+                }
+        }
+        triangulate_contour_mesh(sw, cl, ALPHA_FULL);
+        triangulate_contour_mesh(sw, cl, ALPHA_PARTIAL);
+        return sw;
+}
+
+void destroy_contour_list(contour_list * cl)
+{
+        for (size_t i = 0; i < array_size(cl->contours); i++) {
+                array_destroy(get_contour(cl, i)->points);
+        }
+        array_destroy(cl->contours);
+        free(cl);
+}
+
+const char * mesh_engine_name(mesh_engine engine)
+{
+        assert((size_t)engine < c_engine_count);
+        return c_engine_names[engine];
+}
+
+int mesh_engine_from_name(const char * name, mesh_engine * outEngine)
+{
+        for (size_t i = 0; i < c_engine_count; i++) {
+                if (strcmp(name, c_engine_names[i]) == 0) {
+                        *outEngine = (mesh_engine)i;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Trace every contour of the region of pixels with any of the alpha bits in 'a', starting each from the first
+// unvisited top edge in scan order.
+void trace_alpha_contours(contour_list * cl, const tpxl * tpixels, pxl_size w, pxl_size h, alpha a,
+                          uint8_t * visited)
+{
+        memset(visited, FALSE, (size_t)w * (h + 1));
+        for (pxl_pos y = 0; y <= (pxl_pos)h; y++) {
+                for (pxl_pos x = 0; x < (pxl_pos)w; x++) {
+                        if (visited[y * w + x] == FALSE && contour_step_exists(tpixels, w, h, a, x, y, STEP_EAST)) {
+                                trace_contour(cl, tpixels, w, h, a, x, y, visited);
+                        }
+                }
+        }
+}
+
+// Follow a contour from the top edge at corner (x, y) until it returns there, adding a point at each turn and marking
+// the top edges it passes.  The first corner is always a turn: an edge arriving from the west would have been found
+// first.
+void trace_contour(contour_list * cl, const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                   uint8_t * visited)
+{
+        contour * c = (contour *)array_push(cl->contours);
+        c->points = array_create(16, sizeof(vert));
+        c->alphaType = a;
+        c->index = 0;
+        vert * v = add_vert(c->points);
+        v->x = (float)x;
+        v->y = (float)y;
+        v->u = v->v = 0.0f;
+        pxl_pos cx = x;
+        pxl_pos cy = y;
+        contour_step step = STEP_EAST;
+        while (TRUE) {
+                if (step == STEP_EAST) {
+                        visited[cy * w + cx] = TRUE;
+                }
+                cx += c_stepX[step];
+                cy += c_stepY[step];
+                contour_step next = next_contour_step(tpixels, w, h, a, cx, cy, step);
+                // A contour can pass its first corner twice where it touches itself diagonally
+                if (cx == x && cy == y && next == STEP_EAST) break;
+                if (next != step) {
+                        v = add_vert(c->points);
+                        v->x = (float)cx;
+                        v->y = (float)cy;
+                        v->u = v->v = 0.0f;
+                }
+                step = next;
+        }
+        c->hole = ring_signed_area((vert *)array_get(c->points, 0), array_size(c->points)) < 0.0;
+}
+
+int pixel_in_region(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y)
+{
+        if (x < 0 || y < 0 || x >= (pxl_pos)w || y >= (pxl_pos)h) return FALSE;
+        return (tpixels[y * w + x] & a) != 0;
+}
+
+// A contour steps from a corner along an edge with the region on its right and not on its left.
+int contour_step_exists(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                        contour_step step)
+{
+        contour_step before = (contour_step)((step + 3) & 3);
+        return pixel_in_region(tpixels, w, h, a, x + c_rightX[step], y + c_rightY[step]) &&
+               pixel_in_region(tpixels, w, h, a, x + c_rightX[before], y + c_rightY[before]) == FALSE;
+}
+
+// Choose the step out of a corner, turning right where two steps are possible.
+contour_step next_contour_step(const tpxl * tpixels, pxl_size w, pxl_size h, alpha a, pxl_pos x, pxl_pos y,
+                               contour_step step)
+{
+        contour_step right = (contour_step)((step + 1) & 3);
+        contour_step left = (contour_step)((step + 3) & 3);
+        if (contour_step_exists(tpixels, w, h, a, x, y, right)) return right;
+        if (contour_step_exists(tpixels, w, h, a, x, y, step)) return step;
+        assert(contour_step_exists(tpixels, w, h, a, x, y, left) && "Contour does not continue");
+        return left;
+}
+
+void simplify_contour(contour_simplify * s)
+{
+        contour * c = get_contour(s->cl, s->current);
+        size_t count = array_size(c->points);
+        if (count < 4) return;
+        s->direction = (c->alphaType == ALPHA_FULL) ? -1.0f : 1.0f;
+        memset(s->kept, TRUE, count);
+        vert * points = (vert *)array_get(c->points, 0);
+        size_t furthest = 0;
+        float max = -1.0f;
+        for (size_t i = 1; i < count; i++) {
+                float dx = points[i].x - points[0].x;
+                float dy = points[i].y - points[0].y;
+                if (dx * dx + dy * dy > max) {
+                        max = dx * dx + dy * dy;
+                        furthest = i;
+                }
+        }
+        simplify_contour_span(s, points, count, 0, furthest);
+        simplify_contour_span(s, points, count, furthest, count);
+        size_t kept = 0;
+        for (size_t i = 0; i < count; i++) {
+                if (s->kept[i]) {
+                        points[kept++] = points[i];
+                }
+        }
+        while (array_size(c->points) > kept) {
+                array_pop(c->points);
+        }
+}
+
+// Replace the points between first and last with a chord, or split the span.  Where points lie on the side the
+// contour may not move towards, splitting at the furthest of them lets the chords follow a staircase on its outer
+// corners; otherwise the span is split at the point furthest from the chord.  'last' may be 'count', standing for the
+// first point again.
+void simplify_contour_span(contour_simplify * s, const vert * points, size_t count, size_t first, size_t last)
+{
+        if (last - first < 2) return;
+        if (contour_chord_allowed(s, points, count, first, last)) {
+                for (size_t i = first + 1; i < last; i++) {
+                        s->kept[i] = FALSE;
+                }
+                return;
+        }
+        const vert * a = points + first;
+        const vert * b = points + last % count;
+        float dx = b->x - a->x;
+        float dy = b->y - a->y;
+        int degenerate = dx == 0.0f && dy == 0.0f;
+        size_t split = first + 1;
+        float max = -1.0f;
+        size_t wrongSplit = last;
+        float wrongMax = 0.0f;
+        for (size_t i = first + 1; i < last; i++) {
+                float px = points[i].x - a->x;
+                float py = points[i].y - a->y;
+                float side = (dx * py - dy * px) * s->direction;
+                float distance = degenerate ? px * px + py * py : fabsf(side);
+                if (distance > max) {
+                        max = distance;
+                        split = i;
+                }
+                if (degenerate == FALSE && -side > wrongMax) {
+                        wrongMax = -side;
+                        wrongSplit = i;
+                }
+        }
+        if (wrongSplit < last) {
+                split = wrongSplit;
+        }
+        simplify_contour_span(s, points, count, first, split);
+        simplify_contour_span(s, points, count, split, last);
+}
+
+int contour_chord_allowed(const contour_simplify * s, const vert * points, size_t count, size_t first, size_t last)
+{
+        const vert * a = points + first;
+        const vert * b = points + last % count;
+        float dx = b->x - a->x;
+        float dy = b->y - a->y;
+        float length = sqrtf(dx * dx + dy * dy);
+        if (length == 0.0f) return FALSE;
+        contour_bounds notch = {fminf(a->x, b->x), fminf(a->y, b->y), fmaxf(a->x, b->x), fmaxf(a->y, b->y)};
+        for (size_t i = first + 1; i < last; i++) {
+                const vert * p = points + i;
+                // Positive when p is right of the chord, on the side of the region
+                float side = (dx * (p->y - a->y) - dy * (p->x - a->x)) * s->direction;
+                if (side < 0.0f || side > s->bleed * length) return FALSE;
+                notch.minX = fminf(notch.minX, p->x);
+                notch.minY = fminf(notch.minY, p->y);
+                notch.maxX = fmaxf(notch.maxX, p->x);
+                notch.maxY = fmaxf(notch.maxY, p->y);
+        }
+        size_t contours = array_size(s->cl->contours);
+        for (size_t i = 0; i < contours; i++) {
+                const contour_bounds * bounds = s->bounds + i;
+                if (bounds->maxX < notch.minX || bounds->minX > notch.maxX || bounds->maxY < notch.minY ||
+                    bounds->minY > notch.maxY) continue;
+                if (chord_meets_contour(s, i, first, last, &notch)) return FALSE;
+        }
+        return TRUE;
+}
+
+// Determine if the chord replacing the current contour's points from first to last crosses a live edge of another
+// contour, or of the current one outside the span, or encloses one of its points.
+int chord_meets_contour(const contour_simplify * s, size_t other, size_t first, size_t last,
+                        const contour_bounds * notch)
+{
+        contour * current = get_contour(s->cl, s->current);
+        const vert * span = (const vert *)array_get(current->points, 0);
+        size_t spanCount = array_size(current->points);
+        const vert * a = span + first;
+        const vert * b = span + last % spanCount;
+        contour * c = get_contour(s->cl, other);
+        size_t count = array_size(c->points);
+        if (count == 0) return FALSE;
+        const vert * points = (const vert *)array_get(c->points, 0);
+        int own = other == s->current;
+        size_t start = 0;
+        while (own && s->kept[start] == FALSE) {
+                start++;
+        }
+        size_t i = start;
+        do {
+                size_t next = (i + 1) % count;
+                while (own && s->kept[next] == FALSE) {
+                        next = (next + 1) % count;
+                }
+                int inSpan = own && i >= first && i < last;
+                if (inSpan == FALSE && chord_crosses(a, b, points + i, points + next)) return TRUE;
+                const vert * p = points + i;
+                if (inSpan == FALSE && (own == FALSE || i != last % count) && p->x >= notch->minX &&
+                    p->x <= notch->maxX && p->y >= notch->minY && p->y <= notch->maxY &&
+                    point_ring_side(span, spanCount, first, last, p) == RING_INSIDE) return TRUE;
+                i = next;
+        } while (i != start);
+        return FALSE;
+}
+
+static float cross(const vert * a, const vert * b, const vert * p)
+{
+        return (b->x - a->x) * (p->y - a->y) - (b->y - a->y) * (p->x - a->x);
+}
+
+static int on_segment(const vert * a, const vert * b, const vert * p)
+{
+        return cross(a, b, p) == 0.0f && p->x >= fminf(a->x, b->x) && p->x <= fmaxf(a->x, b->x) &&
+               p->y >= fminf(a->y, b->y) && p->y <= fmaxf(a->y, b->y);
+}
+
+// Determine if segment cd crosses the chord from a to b.  Touching is allowed: visible and opaque borders often run
+// along each other, and a contour reaching into the region the chord adds has points inside it.
+int chord_crosses(const vert * a, const vert * b, const vert * c, const vert * d)
+{
+        float o1 = cross(a, b, c);
+        float o2 = cross(a, b, d);
+        float o3 = cross(c, d, a);
+        float o4 = cross(c, d, b);
+        return ((o1 > 0.0f && o2 < 0.0f) || (o1 < 0.0f && o2 > 0.0f)) &&
+               ((o3 > 0.0f && o4 < 0.0f) || (o3 < 0.0f && o4 > 0.0f));
+}
+
+// Locate p against the polygon of points first to last, closed back to first.  'last' may run past the final point
+// and wrap around.
+ring_side point_ring_side(const vert * points, size_t count, size_t first, size_t last, const vert * p)
+{
+        int inside = FALSE;
+        for (size_t i = first; i <= last; i++) {
+                const vert * a = points + i % count;
+                const vert * b = points + ((i == last) ? first : i + 1) % count;
+                if (on_segment(a, b, p)) return RING_BOUNDARY;
+                if ((a->y > p->y) != (b->y > p->y)) {
+                        float x = a->x + (p->y - a->y) * (b->x - a->x) / (b->y - a->y);
+                        if (p->x < x) inside = !inside;
+                }
+        }
+        return inside ? RING_INSIDE : RING_OUTSIDE;
+}
+
+void measure_contour_bounds(contour * c, contour_bounds * outBounds)
+{
+        outBounds->minX = outBounds->minY = INFINITY;
+        outBounds->maxX = outBounds->maxY = -INFINITY;
+        for (size_t i = 0; i < array_size(c->points); i++) {
+                const vert * p = (const vert *)array_get(c->points, i);
+                outBounds->minX = fminf(outBounds->minX, p->x);
+                outBounds->minY = fminf(outBounds->minY, p->y);
+                outBounds->maxX = fmaxf(outBounds->maxX, p->x);
+                outBounds->maxY = fmaxf(outBounds->maxY, p->y);
+        }
+}
+
+// Opaque contours simplified away to nothing are left out, leaving their pixels to the partial alpha mesh.
+int contour_is_meshed(contour * c)
+{
+        size_t count = array_size(c->points);
+        return count >= 3 && ring_signed_area((const vert *)array_get(c->points, 0), count) != 0.0;
+}
+
+int contour_in_mesh(const contour * c, alpha mesh)
+{
+        return mesh == ALPHA_PARTIAL || c->alphaType == ALPHA_FULL;
+}
+
+// Opaque outer borders are holes in the partial alpha mesh and opaque holes are outer borders of it.
+int contour_is_outer(const contour * c, alpha mesh)
+{
+        if (mesh == ALPHA_PARTIAL && c->alphaType == ALPHA_FULL) return c->hole;
+        return c->hole == FALSE;
+}
+
+// Determine if one contour lies within another.  Contours do not cross, so the first point off the outer border
+// decides; a contour lying along the border is taken as within it.
+int contour_contains(contour * outer, contour * inner)
+{
+        const vert * points = (const vert *)array_get(outer->points, 0);
+        size_t count = array_size(outer->points);
+        for (size_t i = 0; i < array_size(inner->points); i++) {
+                const vert * p = (const vert *)array_get(inner->points, i);
+                ring_side side = point_ring_side(points, count, 0, count - 1, p);
+                if (side != RING_BOUNDARY) return side == RING_INSIDE;
+        }
+        return TRUE;
+}
+
+void triangulate_contour_mesh(shrinkwrap * sw, contour_list * cl, alpha mesh)
+{
+        array * indices = (mesh == ALPHA_FULL) ? sw->indicesFullAlpha : sw->indicesPartialAlpha;
+        size_t count = array_size(cl->contours);
+        size_t * parents = (size_t *)malloc(sizeof(size_t) * count);
+        double * areas = (double *)malloc(sizeof(double) * count);
+        contour_bounds * bounds = (contour_bounds *)malloc(sizeof(contour_bounds) * count);
+        ear_ring * holes = (ear_ring *)malloc(sizeof(ear_ring) * count);
+        for (size_t i = 0; i < count; i++) {
+                contour * c = get_contour(cl, i);
+                parents[i] = count;
+                if (contour_is_meshed(c) == FALSE || contour_in_mesh(c, mesh) == FALSE) continue;
+                areas[i] = fabs(ring_signed_area((const vert *)array_get(c->points, 0), array_size(c->points)));
+                measure_contour_bounds(c, bounds + i);
+        }
+        for (size_t h = 0; h < count; h++) {
+                contour * hole = get_contour(cl, h);
+                if (contour_is_meshed(hole) == FALSE || contour_in_mesh(hole, mesh) == FALSE ||
+                    contour_is_outer(hole, mesh)) continue;
+                for (size_t o = 0; o < count; o++) {
+                        contour * outer = get_contour(cl, o);
+                        if (contour_is_meshed(outer) == FALSE || contour_in_mesh(outer, mesh) == FALSE ||
+                            contour_is_outer(outer, mesh) == FALSE) continue;
+                        if (parents[h] < count && areas[o] >= areas[parents[h]]) continue;
+                        if (bounds[h].minX < bounds[o].minX || bounds[h].maxX > bounds[o].maxX ||
+                            bounds[h].minY < bounds[o].minY || bounds[h].maxY > bounds[o].maxY) continue;
+                        if (contour_contains(outer, hole)) {
+                                parents[h] = o;
+                        }
+                }
+        }
+        for (size_t o = 0; o < count; o++) {
+                contour * outer = get_contour(cl, o);
+                if (contour_is_meshed(outer) == FALSE || contour_in_mesh(outer, mesh) == FALSE ||
+                    contour_is_outer(outer, mesh) == FALSE) continue;
+                size_t holeCount = 0;
+                for (size_t h = 0; h < count; h++) {
+                        if (parents[h] != o) continue;
+                        contour * hole = get_contour(cl, h);
+                        ear_ring * ring = holes + holeCount++;
+                        ring->points = (const vert *)array_get(hole->points, 0);
+                        ring->count = array_size(hole->points);
+                        ring->index = hole->index;
+                }
+                ear_ring ring = {(const vert *)array_get(outer->points, 0), array_size(outer->points), outer->index};
+                earclip(indices, &ring, holes, holeCount);
+        }
+        free(holes);
+        free(bounds);
+        free(areas);
+        free(parents);
+}
@@ -0,0 +1,223 @@
+//
+//  shrinkwrap_convex.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_convex_internal.h"
+#include "internal/shrinkwrap_compact_internal.h"
+
+// Convex merging
+///////////////////////////////////////////////////////////////////////////////
+// Hertel-Mehlhorn: the edge between two triangles of the same alpha type is dropped if the polygon either side of it
+// stays convex at both its ends, until no more can be dropped.  The polygons are at most four times as many as the
+// fewest convex polygons that could tile the region.  A polygon of n corners fans into n - 2 triangles, so the saving
+// comes from corners where the border runs straight on, as it does down the sides of scanline regions.  Such corners
+// are left out of the fans only where they are straight in every polygon that has them, so no edge ends part way
+// along another.
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+void merge_convex(shrinkwrap * sw)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && "Merge before building strips");
+        // Triangles must share vertices to be found side by side
+        compact_vertices(sw);
+        convex_merge m;
+        m.vertices = sw->vertices;
+        m.count = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        m.polygons = (array **)malloc(sizeof(array *) * (m.count + 1));
+        m.parent = (uint32_t *)malloc(sizeof(uint32_t) * (m.count + 1));
+        m.full = (uint8_t *)malloc(sizeof(uint8_t) * (m.count + 1));
+        convex_edge * edges = (convex_edge *)malloc(sizeof(convex_edge) * (m.count * 3 + 1));
+        size_t edgeCount = 0;
+        uint32_t t = 0;
+        for (int full = 0; full < 2; full++) {
+                array * indices = full ? sw->indicesFullAlpha : sw->indicesPartialAlpha;
+                for (size_t i = 0; i + 2 < array_size(indices); i += 3, t++) {
+                        uint32_t corners[3] = {get_index(indices, i), get_index(indices, i + 1),
+                                               get_index(indices, i + 2)};
+                        double turn = corner_turn(m.vertices, corners[0], corners[1], corners[2]);
+                        if (turn < 0.0) {
+                                uint32_t swap = corners[1];
+                                corners[1] = corners[2];
+                                corners[2] = swap;
+                        }
+                        m.polygons[t] = array_create(3, sizeof(uint32_t));
+                        m.parent[t] = t;
+                        m.full[t] = (uint8_t)full;
+                        // Degenerate triangles cover nothing and are dropped
+                        if (turn == 0.0) continue;
+                        for (int c = 0; c < 3; c++) {
+                                *(uint32_t *)array_push(m.polygons[t]) = corners[c];
+                                uint32_t a = corners[c];
+                                uint32_t b = corners[(c + 1) % 3];
+                                convex_edge edge = {a < b ? a : b, a < b ? b : a, t, a < b, (uint8_t)full};
+                                edges[edgeCount++] = edge;
+                        }
+                }
+        }
+        qsort(edges, edgeCount, sizeof(convex_edge), compare_convex_edges);
+        for (size_t i = 0; i + 1 < edgeCount; i++) {
+                const convex_edge * e = edges + i;
+                const convex_edge * f = edges + i + 1;
+                if (e->low != f->low || e->high != f->high || e->full != f->full || e->forward == f->forward) continue;
+                // 'e' runs from a to b and 'f' from b to a
+                uint32_t a = e->forward ? e->low : e->high;
+                uint32_t b = e->forward ? e->high : e->low;
+                merge_convex_pair(&m, e->triangle, f->triangle, a, b);
+        }
+        uint8_t * bent = (uint8_t *)calloc(array_size(m.vertices) + 1, sizeof(uint8_t));
+        mark_bent_corners(&m, bent);
+        array_clear(sw->indicesPartialAlpha);
+        array_clear(sw->indicesFullAlpha);
+        for (uint32_t p = 0; p < m.count; p++) {
+                if (m.parent[p] == p) {
+                        array * indices = m.full[p] ? sw->indicesFullAlpha : sw->indicesPartialAlpha;
+                        fan_convex_polygon(m.polygons[p], bent, indices);
+                }
+        }
+        for (uint32_t p = 0; p < m.count; p++) {
+                array_destroy(m.polygons[p]);
+        }
+        free(bent);
+        free(edges);
+        free(m.polygons);
+        free(m.parent);
+        free(m.full);
+        // Drop the corners left out of the fans
+        compact_vertices(sw);
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+int compare_convex_edges(const void * a, const void * b)
+{
+        const convex_edge * ea = (const convex_edge *)a;
+        const convex_edge * eb = (const convex_edge *)b;
+        if (ea->low != eb->low) return (ea->low < eb->low) ? -1 : 1;
+        if (ea->high != eb->high) return (ea->high < eb->high) ? -1 : 1;
+        if (ea->full != eb->full) return (ea->full < eb->full) ? -1 : 1;
+        return (ea->triangle < eb->triangle) ? -1 : (ea->triangle > eb->triangle);
+}
+
+uint32_t find_convex_polygon(convex_merge * m, uint32_t polygon)
+{
+        while (m->parent[polygon] != polygon) {
+                m->parent[polygon] = m->parent[m->parent[polygon]];
+                polygon = m->parent[polygon];
+        }
+        return polygon;
+}
+
+// Join the polygons holding two triangles across their edge from a to b if the result stays convex at a and b.
+int merge_convex_pair(convex_merge * m, uint32_t first, uint32_t second, uint32_t a, uint32_t b)
+{
+        first = find_convex_polygon(m, first);
+        second = find_convex_polygon(m, second);
+        if (first == second) return FALSE;
+        array * p = m->polygons[first];
+        array * q = m->polygons[second];
+        size_t pn = array_size(p);
+        size_t qn = array_size(q);
+        // p runs a, b, p1 .. pk and q runs b, a, q1 .. qm
+        size_t pa = find_polygon_corner(p, a);
+        size_t qb = find_polygon_corner(q, b);
+        if (pa == pn || qb == qn) return FALSE;
+        if (*(uint32_t *)array_get(p, (pa + 1) % pn) != b || *(uint32_t *)array_get(q, (qb + 1) % qn) != a) {
+                return FALSE;
+        }
+        uint32_t pk = *(uint32_t *)array_get(p, (pa + pn - 1) % pn);
+        uint32_t p1 = *(uint32_t *)array_get(p, (pa + 2) % pn);
+        uint32_t qm = *(uint32_t *)array_get(q, (qb + qn - 1) % qn);
+        uint32_t q1 = *(uint32_t *)array_get(q, (qb + 2) % qn);
+        if (corner_turn(m->vertices, pk, a, q1) < 0.0 || corner_turn(m->vertices, qm, b, p1) < 0.0) return FALSE;
+        // The joined polygon runs a, q1 .. qm, b, p1 .. pk
+        array * joined = array_create(pn + qn - 2, sizeof(uint32_t));
+        for (size_t i = 0; i < qn - 1; i++) {
+                *(uint32_t *)array_push(joined) = *(uint32_t *)array_get(q, (qb + 1 + i) % qn);
+        }
+        for (size_t i = 0; i < pn - 1; i++) {
+                *(uint32_t *)array_push(joined) = *(uint32_t *)array_get(p, (pa + 1 + i) % pn);
+        }
+        array_destroy(p);
+        array_clear(q);
+        m->polygons[first] = joined;
+        m->parent[second] = first;
+        return TRUE;
+}
+
+size_t find_polygon_corner(array * polygon, uint32_t vertex)
+{
+        size_t n = array_size(polygon);
+        for (size_t i = 0; i < n; i++) {
+                if (*(uint32_t *)array_get(polygon, i) == vertex) return i;
+        }
+        return n;
+}
+
+// Positive where the border turns clockwise on screen at a corner and zero where it runs straight on.  Exact for
+// float positions, as each product fits a double.
+double corner_turn(array * vertices, uint32_t prev, uint32_t corner, uint32_t next)
+{
+        const vert * o = get_vert(vertices, prev);
+        const vert * a = get_vert(vertices, corner);
+        const vert * b = get_vert(vertices, next);
+        return ((double)a->x - o->x) * ((double)b->y - o->y) - ((double)a->y - o->y) * ((double)b->x - o->x);
+}
+
+// Mark the vertices that are a true corner of some polygon.
+void mark_bent_corners(convex_merge * m, uint8_t * bent)
+{
+        for (uint32_t p = 0; p < m->count; p++) {
+                if (m->parent[p] != p) continue;
+                array * polygon = m->polygons[p];
+                size_t n = array_size(polygon);
+                for (size_t i = 0; i < n; i++) {
+                        uint32_t prev = *(uint32_t *)array_get(polygon, (i + n - 1) % n);
+                        uint32_t corner = *(uint32_t *)array_get(polygon, i);
+                        uint32_t next = *(uint32_t *)array_get(polygon, (i + 1) % n);
+                        if (corner_turn(m->vertices, prev, corner, next) != 0.0) bent[corner] = TRUE;
+                }
+        }
+}
+
+// Fan a convex polygon from its first true corner, leaving out corners that are straight everywhere.
+void fan_convex_polygon(array * polygon, const uint8_t * bent, array * indices)
+{
+        size_t n = array_size(polygon);
+        size_t first = 0;
+        while (first < n && bent[*(uint32_t *)array_get(polygon, first)] == FALSE) first++;
+        if (first == n) return;
+        uint32_t apex = *(uint32_t *)array_get(polygon, first);
+        uint32_t last = shrinkwrap_restart_index;
+        for (size_t i = 1; i < n; i++) {
+                uint32_t corner = *(uint32_t *)array_get(polygon, (first + i) % n);
+                if (bent[corner] == FALSE) continue;
+                if (last != shrinkwrap_restart_index) {
+                        push_index(indices, apex);
+                        push_index(indices, last);
+                        push_index(indices, corner);
+                }
+                last = corner;
+        }
+}
@@ -0,0 +1,235 @@
+//
+//  shrinkwrap_core.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_core_internal.h"
+#include "internal/shrinkwrap_triangle_internal.h"
+
+// Opaque cores
+///////////////////////////////////////////////////////////////////////////////
+// Curve points lie on pixel rows and no curve starts on the last row of a map, so a region of n rows is meshed from
+// its first row down to its second to last.  An opaque core of n rows is drawn as a quad from its first row down to
+// its last, and the region around it is cut into parts that each mesh up to where the next begins:
+//
+//   +-----------+   top:    rows above the core, down to the core's first row
+//   |    top    |   left:   columns left of the core, on the core's rows
+//   +--+-----+--+   right:  columns right of the core, on the core's rows
+//   |l | core| r|   bottom: rows from the core's last row down
+//   +--+-----+--+
+//   |  bottom   |   Each part is traced on its own, so no curve has to run around a hole.
+//   +-----------+
+//
+// Smoothing snaps curve endings within its bleed of a map's left or right edge onto the edge, which the left and right
+// parts would otherwise have where a shape narrows to meet the core.  So those parts reach 'overlap' columns into the
+// core, keeping at least that much full alpha against their inner edge, and the quad is drawn that much narrower.
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Find the full-alpha rectangle in a region of a type pixel map that covers the most area, at least minSide pixels
+// across and down, leaving out the region's last row as meshing does.  Keeps a histogram of the full-alpha run above
+// each pixel of the current row and walks it with a stack of rising bars, which visits every maximal rectangle once
+// for O(w*h).
+int find_opaque_rect(const tpxl * tpixels, pxl_size w, const pixel_rect * region, pxl_size minSide,
+                     pixel_rect * outRect)
+{
+        // One extra empty bar empties the stack at the end of each row
+        size_t * heights = (size_t *)calloc(region->w + 1, sizeof(size_t));
+        size_t * stack = (size_t *)malloc(sizeof(size_t) * (region->w + 1));
+        size_t bestArea = 0;
+        for (pxl_size y = 0; y + 1 < region->h; y++) {
+                const tpxl * row = tpixels + (size_t)(region->y + y) * w + region->x;
+                for (pxl_size x = 0; x < region->w; x++) {
+                        heights[x] = (row[x] == ALPHA_FULL) ? heights[x] + 1 : 0;
+                }
+                size_t top = 0;
+                for (size_t x = 0; x <= region->w; x++) {
+                        while (top > 0 && heights[stack[top - 1]] >= heights[x]) {
+                                size_t rows = heights[stack[--top]];
+                                size_t left = (top > 0) ? stack[top - 1] + 1 : 0;
+                                size_t width = x - left;
+                                if (rows == 0 || width < minSide || rows - 1 < minSide) continue;
+                                size_t area = width * (rows - 1);
+                                if (area > bestArea) {
+                                        bestArea = area;
+                                        outRect->x = region->x + (pxl_pos)left;
+                                        outRect->y = region->y + (pxl_pos)(y + 1 - rows);
+                                        outRect->w = (pxl_size)width;
+                                        outRect->h = (pxl_size)rows;
+                                }
+                        }
+                        stack[top++] = x;
+                }
+        }
+        free(heights);
+        free(stack);
+        return bestArea > 0;
+}
+
+// Carve up to maxCores opaque cores out of a frame, largest first within each region, and list the regions left to
+// trace, leaving out regions with no alpha.  outRegions must hold 3 * maxCores + 1 rectangles.
+size_t split_opaque_cores(const tpxl * tpixels, pxl_size w, pxl_size h, pxl_size minSide, pxl_size overlap,
+                          size_t maxCores, pixel_rect * outCores, size_t * outCoreCount, pixel_rect * outRegions)
+{
+        assert(minSide > overlap * 2 && "Cores must be wider than the parts beside them reach into them");
+        pixel_rect frame = {0, 0, w, h};
+        outRegions[0] = frame;
+        size_t count = 1;
+        size_t cores = 0;
+        size_t i = 0;
+        while (i < count) {
+                pixel_rect core;
+                if (region_has_alpha(tpixels, w, outRegions + i) == FALSE) {
+                        outRegions[i] = outRegions[--count];
+                        continue;
+                }
+                if (cores == maxCores || find_opaque_rect(tpixels, w, outRegions + i, minSide, &core) == FALSE) {
+                        i++;
+                        continue;
+                }
+                pixel_rect parts[4];
+                size_t partCount = split_region(outRegions + i, &core, overlap, parts);
+                outCores[cores++] = core;
+                // The region is replaced by its parts; look for another core in the first of them next
+                if (partCount == 0) {
+                        outRegions[i] = outRegions[--count];
+                        continue;
+                }
+                outRegions[i] = parts[0];
+                for (size_t p = 1; p < partCount; p++) {
+                        outRegions[count++] = parts[p];
+                }
+        }
+        *outCoreCount = cores;
+        return count;
+}
+
+// Copy a rectangle out of a type pixel map
+tpxl * crop_typemap(const tpxl * tpixels, pxl_size w, const pixel_rect * rect)
+{
+        tpxl * cropped = (tpxl *)malloc(sizeof(tpxl) * rect->w * rect->h);
+        for (pxl_size y = 0; y < rect->h; y++) {
+                const tpxl * src = tpixels + (size_t)(rect->y + y) * w + rect->x;
+                memcpy(cropped + (size_t)y * rect->w, src, sizeof(tpxl) * rect->w);
+        }
+        return cropped;
+}
+
+// Join the triangulated regions of a frame, each moved to its place, and add a full-alpha quad for each core.
+shrinkwrap * merge_shrinkwraps(shrinkwrap ** parts, const pixel_rect * regions, size_t count,
+                               const pixel_rect * cores, size_t coreCount)
+{
+        size_t vertexCount = coreCount * 4;
+        for (size_t i = 0; i < count; i++) {
+                assert(parts[i]->primitiveType == PRIMITIVE_TRIANGLES && parts[i]->meshType == MESH_SPLIT);
+                vertexCount += array_size(parts[i]->vertices);
+        }
+        shrinkwrap * sw = create_shrink_wrap((uint32_t)vertexCount);
+        for (size_t i = 0; i < count; i++) {
+                uint32_t base = (uint32_t)array_size(sw->vertices);
+                array * vertices = parts[i]->vertices;
+                for (size_t v = 0; v < array_size(vertices); v++) {
+                        vertp vertex = add_vert(sw->vertices);
+                        *vertex = *get_vert(vertices, v);
+                        vertex->x += (float)regions[i].x;
+                        vertex->y += (float)regions[i].y;
+                }
+                for (size_t j = 0; j < array_size(parts[i]->indicesFullAlpha); j++) {
+                        push_index(sw->indicesFullAlpha, base + get_index(parts[i]->indicesFullAlpha, j));
+                }
+                for (size_t j = 0; j < array_size(parts[i]->indicesPartialAlpha); j++) {
+                        push_index(sw->indicesPartialAlpha, base + get_index(parts[i]->indicesPartialAlpha, j));
+                }
+        }
+        const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+        for (size_t i = 0; i < coreCount; i++) {
+                const pixel_rect * core = cores + i;
+                float left = (float)core->x;
+                float right = (float)(core->x + (pxl_pos)core->w);
+                float top = (float)core->y;
+                float bottom = (float)(core->y + (pxl_pos)core->h - 1);
+                const float corners[4][2] = {{left, top}, {right, top}, {right, bottom}, {left, bottom}};
+                uint32_t base = (uint32_t)array_size(sw->vertices);
+                for (int v = 0; v < 4; v++) {
+                        vertp vertex = add_vert(sw->vertices);
+                        memset(vertex, 0, sizeof(vert));
+                        vertex->x = corners[v][0];
+                        vertex->y = corners[v][1];
+                }
+                for (int j = 0; j < 6; j++) {
+                        push_index(sw->indicesFullAlpha, base + quad[j]);
+                }
+        }
+        return sw;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Curves cannot start on the last row of a region, so alpha there alone draws nothing.
+int region_has_alpha(const tpxl * tpixels, pxl_size w, const pixel_rect * region)
+{
+        for (pxl_size y = 0; y + 1 < region->h; y++) {
+                const tpxl * row = tpixels + (size_t)(region->y + y) * w + region->x;
+                for (pxl_size x = 0; x < region->w; x++) {
+                        if (isAlpha(row[x])) return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Cut the parts of a region around a core out, narrowing the core by the columns the parts beside it overlap.  Each
+// part takes one row more than it meshes, see Opaque cores.
+size_t split_region(const pixel_rect * region, pixel_rect * inOutCore, pxl_size overlap, pixel_rect * outParts)
+{
+        const pixel_rect * core = inOutCore;
+        // Last rows meshed by the region and covered by the core
+        const pxl_pos regionLast = region->y + (pxl_pos)region->h - 2;
+        const pxl_pos coreLast = core->y + (pxl_pos)core->h - 1;
+        const pxl_pos regionRight = region->x + (pxl_pos)region->w;
+        const pxl_pos coreRight = core->x + (pxl_pos)core->w;
+        assert(core->y >= region->y && coreLast <= regionLast);
+        size_t count = 0;
+        if (core->y > region->y) {
+                pixel_rect top = {region->x, region->y, region->w, (pxl_size)(core->y - region->y + 2)};
+                outParts[count++] = top;
+        }
+        if (coreLast < regionLast) {
+                pixel_rect bottom = {region->x, coreLast, region->w, (pxl_size)(regionLast - coreLast + 2)};
+                outParts[count++] = bottom;
+        }
+        pxl_pos quadLeft = core->x;
+        pxl_pos quadRight = coreRight;
+        if (core->x > region->x) {
+                quadLeft += (pxl_pos)overlap;
+                pixel_rect left = {region->x, core->y, (pxl_size)(quadLeft - region->x), core->h + 1};
+                outParts[count++] = left;
+        }
+        if (coreRight < regionRight) {
+                quadRight -= (pxl_pos)overlap;
+                pixel_rect right = {quadRight, core->y, (pxl_size)(regionRight - quadRight), core->h + 1};
+                outParts[count++] = right;
+        }
+        inOutCore->x = quadLeft;
+        inOutCore->w = (pxl_size)(quadRight - quadLeft);
+        return count;
+}
@@ -0,0 +1,154 @@
+//
+//  shrinkwrap_cost.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_cost_internal.h"
+#include "internal/shrinkwrap_stats_internal.h"
+
+// Cost model
+///////////////////////////////////////////////////////////////////////////////
+// Costs are relative to filling one blended pixel.  Each mesh pays for the vertices its draws transform and the pixels
+// it fills; a split mesh transforms vertices shared by its two lists once per list.  Tiny frames with many vertices
+// come out cheaper as a quad, and frames with little opaque area as a hull.
+static const device_profile c_device_profiles[] = {
+        // Tile-based GPUs hide opaque overdraw but have little vertex throughput to spare
+        {"mobile", 24.0f, 1.0f, 0.25f},
+        {"desktop", 2.0f, 1.0f, 0.6f}
+};
+static const size_t c_device_profile_count = sizeof(c_device_profiles) / sizeof(c_device_profiles[0]);
+
+static const char * const c_mesh_choice_names[] = {"quad", "hull", "split"};
+static const size_t c_mesh_choice_count = sizeof(c_mesh_choice_names) / sizeof(c_mesh_choice_names[0]);
+
+static const float c_quad_vertices = 4.0f;
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Cost of drawing a triangulated frame of the given size one way.
+float mesh_cost(shrinkwrap * sw, const device_profile * device, mesh_choice choice, float width, float height)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && sw->meshType == MESH_SPLIT);
+        if (choice == MESH_QUAD) {
+                return c_quad_vertices * device->vertexCost + width * height * device->blendedPixelCost;
+        }
+        shrinkwrap_stats stats;
+        measure_shrinkwrap(sw, &stats);
+        size_t count = array_size(sw->vertices);
+        uch * marks = (uch *)calloc(count > 0 ? count : 1, sizeof(uch));
+        size_t full = referenced_vertices(sw->indicesFullAlpha, count, marks);
+        float cost = 0.0f;
+        if (choice == MESH_HULL) {
+                size_t all = full + referenced_vertices(sw->indicesPartialAlpha, count, marks);
+                cost = (float)all * device->vertexCost;
+                cost += (float)(stats.partialFill + stats.fullFill) * device->blendedPixelCost;
+        } else {
+                memset(marks, 0, count);
+                size_t partial = referenced_vertices(sw->indicesPartialAlpha, count, marks);
+                cost = (float)(full + partial) * device->vertexCost;
+                cost += (float)stats.partialFill * device->blendedPixelCost;
+                cost += (float)stats.fullFill * device->opaquePixelCost;
+        }
+        free(marks);
+        return cost;
+}
+
+// Pick the cheapest way to draw a triangulated frame, preferring the split mesh, then the hull, on ties.
+mesh_choice choose_mesh(shrinkwrap * sw, const device_profile * device, float width, float height)
+{
+        mesh_choice best = MESH_SPLIT;
+        float bestCost = mesh_cost(sw, device, MESH_SPLIT, width, height);
+        for (int choice = MESH_HULL; choice >= MESH_QUAD; choice--) {
+                float cost = mesh_cost(sw, device, (mesh_choice)choice, width, height);
+                if (cost < bestCost) {
+                        best = (mesh_choice)choice;
+                        bestCost = cost;
+                }
+        }
+        return best;
+}
+
+// Rebuild a triangulated frame as a quad or hull.  The quad covers the frame's pixels once the mesh is moved 'shiftY'
+// down: scanline curve points lie on pixel rows and are moved half a pixel, contours bound whole pixels and are not.
+void apply_mesh_choice(shrinkwrap * sw, mesh_choice choice, float width, float height, float shiftY)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && sw->meshType == MESH_SPLIT);
+        sw->meshType = choice;
+        if (choice == MESH_SPLIT) return;
+        if (choice == MESH_HULL) {
+                for (size_t i = 0; i < array_size(sw->indicesFullAlpha); i++) {
+                        push_index(sw->indicesPartialAlpha, get_index(sw->indicesFullAlpha, i));
+                }
+                array_clear(sw->indicesFullAlpha);
+                return;
+        }
+        const float top = -shiftY;
+        const float bottom = height - shiftY;
+        const float corners[4][2] = {{0.f, top}, {width, top}, {width, bottom}, {0.f, bottom}};
+        const uint32_t quad[6] = {0, 1, 2, 0, 2, 3};
+        array_clear(sw->vertices);
+        array_clear(sw->indicesFullAlpha);
+        array_clear(sw->indicesPartialAlpha);
+        for (int i = 0; i < 4; i++) {
+                vertp v = add_vert(sw->vertices);
+                v->x = corners[i][0];
+                v->y = corners[i][1];
+        }
+        for (int i = 0; i < 6; i++) {
+                push_index(sw->indicesPartialAlpha, quad[i]);
+        }
+}
+
+const char * mesh_choice_name(mesh_choice choice)
+{
+        assert((size_t)choice < c_mesh_choice_count);
+        return c_mesh_choice_names[choice];
+}
+
+const device_profile * device_profile_from_name(const char * name)
+{
+        for (size_t i = 0; i < c_device_profile_count; i++) {
+                if (strcmp(name, c_device_profiles[i].name) == 0) {
+                        return c_device_profiles + i;
+                }
+        }
+        return NULL;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Count the vertices an index list uses that are not yet marked, marking them.
+size_t referenced_vertices(array * indices, size_t vertexCount, uch * marks)
+{
+        size_t count = 0;
+        for (size_t i = 0; i < array_size(indices); i++) {
+                uint32_t index = get_index(indices, i);
+                if (index == shrinkwrap_restart_index) continue;
+                assert(index < vertexCount);
+                if (marks[index] == FALSE) {
+                        marks[index] = TRUE;
+                        count++;
+                }
+        }
+        return count;
+}
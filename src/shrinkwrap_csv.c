@@ -0,0 +1,162 @@
+//
+//  shrinkwrap_csv.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shrinkwrap_csv.h"
+#include "shrinkwrap.h"
+#include "textwriter.h"
+#include "internal/shrinkwrap_internal_t.h"
+
+static const size_t c_csvBufferSize = 1 << 16;
+
+// Quote a field if it holds a comma, quote or line break, doubling any quotes.
+void csvField(textwriter * writer, const char * text)
+{
+        if (strpbrk(text, ",\"\r\n") == NULL) {
+                textwriter_string(writer, text);
+                return;
+        }
+        textwriter_char(writer, '"');
+        for (const char * c = text; *c; c++) {
+                if (*c == '"') textwriter_char(writer, '"');
+                textwriter_char(writer, *c);
+        }
+        textwriter_char(writer, '"');
+}
+
+void csvFloats(textwriter * writer, const float * values, size_t count)
+{
+        for (size_t i = 0; i < count; i++) {
+                textwriter_char(writer, ',');
+                textwriter_float(writer, values[i]);
+        }
+}
+
+void csvIndices(textwriter * writer, array * indices, const char * list, size_t perRow)
+{
+        size_t count = array_size(indices);
+        for (size_t i = 0; i < count; i++) {
+                if (i % perRow == 0) {
+                        textwriter_string(writer, list);
+                }
+                textwriter_char(writer, ',');
+                textwriter_uint(writer, get_index(indices, i));
+                if (i % perRow == perRow - 1 || i == count - 1) {
+                        textwriter_char(writer, '\n');
+                }
+        }
+}
+
+int csvSinkBegin(mesh_sink * sink, uint32_t atlasWidth, uint32_t atlasHeight)
+{
+        textwriter * writer = (textwriter *)sink->context;
+        textwriter_string(writer, "atlas_width,atlas_height\n");
+        textwriter_uint(writer, atlasWidth);
+        textwriter_char(writer, ',');
+        textwriter_uint(writer, atlasHeight);
+        textwriter_string(writer, "\n\n");
+        return textwriter_ok(writer);
+}
+
+int csvSinkFrame(mesh_sink * sink, shrinkwrap * sw, const char * name)
+{
+        textwriter * writer = (textwriter *)sink->context;
+        int quantised = vertex_format_is_quantised(sw->vertexFormat);
+        int uvs = vertex_format_has_uvs(sw->vertexFormat);
+        array * vertices = quantised ? sw->quantisedVertices : sw->vertices;
+        textwriter_string(writer, "frame,mesh,primitive,index_width,vertex_format,orig_x,orig_y,vertices,"
+                          "partial_indices,full_indices,scale_x,scale_y,scale_u,scale_v,bias_x,bias_y,bias_u,bias_v,"
+                          "uv_scale_u,uv_scale_v,uv_bias_u,uv_bias_v\n");
+        csvField(writer, name ? name : "");
+        textwriter_char(writer, ',');
+        textwriter_string(writer, mesh_choice_name(sw->meshType));
+        textwriter_char(writer, ',');
+        textwriter_string(writer, primitive_name(sw->primitiveType));
+        textwriter_char(writer, ',');
+        textwriter_uint(writer, sw->indexWidth * 8);
+        textwriter_char(writer, ',');
+        textwriter_string(writer, vertex_format_name(sw->vertexFormat));
+        const float origin[] = {sw->origX, sw->origY};
+        csvFloats(writer, origin, 2);
+        const size_t counts[] = {array_size(vertices), array_size(sw->indicesPartialAlpha),
+                                 array_size(sw->indicesFullAlpha)};
+        for (size_t i = 0; i < 3; i++) {
+                textwriter_char(writer, ',');
+                textwriter_uint(writer, counts[i]);
+        }
+        const vert one = {1.0f, 1.0f, 1.0f, 1.0f};
+        const vert zero = {0.0f, 0.0f, 0.0f, 0.0f};
+        csvFloats(writer, quantised ? &sw->quantisation.scale.x : &one.x, 4);
+        csvFloats(writer, quantised ? &sw->quantisation.bias.x : &zero.x, 4);
+        const float uvTransform[] = {sw->uvTransform.scaleU, sw->uvTransform.scaleV, sw->uvTransform.biasU,
+                                     sw->uvTransform.biasV};
+        csvFloats(writer, uvTransform, 4);
+        textwriter_string(writer, uvs ? "\n\nvertex,x,y,u,v\n" : "\n\nvertex,x,y\n");
+        for (size_t i = 0; i < array_size(vertices); i++) {
+                textwriter_uint(writer, i);
+                if (quantised) {
+                        const quantised_vert * q = (const quantised_vert *)array_get(vertices, i);
+                        textwriter_char(writer, ',');
+                        textwriter_int(writer, q->x);
+                        textwriter_char(writer, ',');
+                        textwriter_int(writer, q->y);
+                        if (uvs) {
+                                textwriter_char(writer, ',');
+                                textwriter_uint(writer, q->u);
+                                textwriter_char(writer, ',');
+                                textwriter_uint(writer, q->v);
+                        }
+                } else {
+                        csvFloats(writer, &get_vert(vertices, i)->x, uvs ? 4 : 2);
+                }
+                textwriter_char(writer, '\n');
+        }
+        size_t perRow = (sw->primitiveType == PRIMITIVE_TRIANGLES) ? 3 : 1;
+        textwriter_string(writer, (perRow == 3) ? "\nlist,a,b,c\n" : "\nlist,index\n");
+        csvIndices(writer, sw->indicesPartialAlpha, "partial", perRow);
+        csvIndices(writer, sw->indicesFullAlpha, "full", perRow);
+        textwriter_char(writer, '\n');
+        return textwriter_ok(writer);
+}
+
+int csvSinkEnd(mesh_sink * sink)
+{
+        return textwriter_flush((textwriter *)sink->context);
+}
+
+void csvSinkDestroy(mesh_sink * sink)
+{
+        textwriter_destroy((textwriter *)sink->context);
+        free(sink);
+}
+
+mesh_sink * create_csv_sink(FILE * output)
+{
+        mesh_sink * sink = (mesh_sink *)malloc(sizeof(mesh_sink));
+        sink->begin = csvSinkBegin;
+        sink->frame = csvSinkFrame;
+        sink->end = csvSinkEnd;
+        sink->destroy = csvSinkDestroy;
+        sink->context = textwriter_create(output, c_csvBufferSize);
+        return sink;
+}
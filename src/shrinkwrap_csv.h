@@ -0,0 +1,38 @@
+//
+//  shrinkwrap_csv.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_shrinkwrap_csv_h
+#define shrinkwrap_shrinkwrap_csv_h
+
+#include <stdio.h>
+#include "shrinkwrap_t.h"
+#include "textwriter.h"
+
+// Text output as CSV tables, each a header row followed by its rows and a blank line.  The atlas table comes first,
+// then for each frame a frame table of one row, its vertex table and its index table.  Vertices are written as
+// stored: floats, or quantised integers with the frame's scale and bias.  Index tables have a row per triangle for
+// triangle lists and a row per index for strips.  Floats are written by format_float, so output is the same on every
+// platform.
+mesh_sink * create_csv_sink(FILE * output);
+// Write a field, quoted if it holds a comma, quote or line break
+void csvField(textwriter * writer, const char * text);
+
+#endif
@@ -24,7 +24,10 @@
 #include <stdbool.h>
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
+#include "taskpool.h"
 #include "internal/shrinkwrap_curve_internal.h"
+#include "internal/shrinkwrap_simplify_internal.h"
 
 
 // Exposed functions
@@ -97,8 +100,16 @@ size_t smoothCurve(C * c, float w, float maxBleed)
 }
 
 // Iteratively reduce vertices for all curves.
-void smooth_curves(curve_list * cl, float bleed, pxl_size w)
+void smooth_curves(curve_list * cl, float bleed, pxl_size w, pxl_size h)
 {
+        smooth_curves_ex(cl, bleed, w, h, NULL);
+}
+
+// Iteratively reduce vertices for all curves, optionally smoothing non-adjacent curves concurrently.
+void smooth_curves_ex(curve_list * cl, float bleed, pxl_size w, pxl_size h, const smooth_options * options)
+{
+        size_t threads = options ? options->threads : 1;
+        simplifier method = options ? options->method : SIMPLIFY_SHRINKWRAP;
         assert(validate_scanlines(cl));
         assert(validate_curves(cl));
         fix_curve_endings(cl, w, (pxl_size)cl->linecount, bleed);
@@ -110,19 +121,145 @@ void smooth_curves(curve_list * cl, float bleed, pxl_size w)
         protect_subdivision_points(cl, w);
         assert(validate_scanlines(cl));
         assert(validate_curves(cl));
-        CN * c = cl->head->next;
-        while(c) {
-                size_t remove = 0;
-                do {
-                        remove = smoothCurve(c->curve, (float)w, bleed);
-                } while (remove > 0);
-                remove_points(c->curve);
+        if (threads > 1) {
+                smooth_curves_parallel(cl, (float)w, bleed, method, threads);
                 assert(validate_scanlines(cl));
-                c = c->next;
+        } else {
+                CN * c = cl->head->next;
+                while(c) {
+                        simplify_curve(c->curve, (float)w, bleed, method);
+                        assert(validate_scanlines(cl));
+                        c = c->next;
+                }
         }
         smooth_fix_up(cl);
 }
 
+// Parallel smoothing
+///////////////////////////////////////////////////////////////////////////////
+// A curve only reads the curves either side of it on each scanline (limit_point/findx), so serial smoothing is a
+// chain of dependencies between neighbours in curve list order.  Each curve waits for its earlier neighbours to
+// finish and is then free to run alongside any other ready curve, which reproduces serial output exactly.
+typedef struct smooth_schedule_struct {
+        C ** curves;
+        // Later neighbours of curve i are later[first[i]] ... later[first[i+1]-1]
+        size_t * first;
+        size_t * later;
+        // Earlier neighbours still being smoothed
+        size_t * waiting;
+        float w;
+        float bleed;
+        simplifier method;
+        pthread_mutex_t lock;
+} smooth_schedule;
+
+typedef struct neighbour_pair_struct {
+        size_t earlier;
+        size_t later;
+} neighbour_pair;
+
+static int compare_neighbour_pairs(const void * a, const void * b)
+{
+        const neighbour_pair * pa = (const neighbour_pair *)a;
+        const neighbour_pair * pb = (const neighbour_pair *)b;
+        if (pa->earlier != pb->earlier) return (pa->earlier < pb->earlier) ? -1 : 1;
+        if (pa->later != pb->later) return (pa->later < pb->later) ? -1 : 1;
+        return 0;
+}
+
+static void smooth_curve_task(taskpool * pool, void * context, size_t i)
+{
+        smooth_schedule * schedule = (smooth_schedule *)context;
+        simplify_curve(schedule->curves[i], schedule->w, schedule->bleed, schedule->method);
+        for (size_t e = schedule->first[i]; e < schedule->first[i+1]; e++) {
+                size_t next = schedule->later[e];
+                pthread_mutex_lock(&schedule->lock);
+                size_t remaining = --schedule->waiting[next];
+                pthread_mutex_unlock(&schedule->lock);
+                if (remaining == 0) {
+                        taskpool_submit(pool, smooth_curve_task, schedule, next);
+                }
+        }
+}
+
+// Smooth all curves on a pool of threads, scheduling each curve once its earlier scanline neighbours are done.
+void smooth_curves_parallel(curve_list * cl, float w, float bleed, simplifier method, size_t threads)
+{
+        size_t count = 0;
+        CN * n = cl->head->next;
+        while (n) {
+                n->curve->order = count++;
+                n = n->next;
+        }
+        if (count == 0) return;
+        smooth_schedule schedule;
+        schedule.curves = (C **)malloc(sizeof(C *) * count);
+        schedule.first = (size_t *)calloc(count + 1, sizeof(size_t));
+        schedule.waiting = (size_t *)calloc(count, sizeof(size_t));
+        schedule.w = w;
+        schedule.bleed = bleed;
+        schedule.method = method;
+        pthread_mutex_init(&schedule.lock, NULL);
+        n = cl->head->next;
+        while (n) {
+                schedule.curves[n->curve->order] = n->curve;
+                n = n->next;
+        }
+        // Collect every pair of curves that sit side by side on a scanline.
+        array * pairs = array_create(count * 2, sizeof(neighbour_pair));
+        for (size_t line = 0; line < cl->linecount; line++) {
+                const CN * prev = cl->scanlines[line].next;
+                const CN * next = prev ? prev->next : NULL;
+                while (next) {
+                        size_t a = prev->curve->order;
+                        size_t b = next->curve->order;
+                        if (a != b) {
+                                neighbour_pair * pair = (neighbour_pair *)array_push(pairs);
+                                pair->earlier = (a < b) ? a : b;
+                                pair->later = (a < b) ? b : a;
+                        }
+                        prev = next;
+                        next = next->next;
+                }
+        }
+        size_t paircount = array_size(pairs);
+        neighbour_pair * sorted = paircount ? (neighbour_pair *)array_get(pairs, 0) : NULL;
+        if (paircount) {
+                qsort(sorted, paircount, sizeof(neighbour_pair), compare_neighbour_pairs);
+        }
+        schedule.later = (size_t *)malloc(sizeof(size_t) * (paircount + 1));
+        size_t edges = 0;
+        for (size_t i = 0; i < paircount; i++) {
+                if (i > 0 && compare_neighbour_pairs(sorted + i, sorted + i - 1) == 0) continue;
+                schedule.later[edges++] = sorted[i].later;
+                schedule.first[sorted[i].earlier + 1]++;
+                schedule.waiting[sorted[i].later]++;
+        }
+        for (size_t i = 0; i < count; i++) {
+                schedule.first[i+1] += schedule.first[i];
+        }
+        array_destroy(pairs);
+        // Find the curves with no earlier neighbours before any task can start counting down.
+        size_t readycount = 0;
+        size_t * ready = (size_t *)malloc(sizeof(size_t) * count);
+        for (size_t i = 0; i < count; i++) {
+                if (schedule.waiting[i] == 0) {
+                        ready[readycount++] = i;
+                }
+        }
+        taskpool * pool = taskpool_create(threads);
+        for (size_t i = 0; i < readycount; i++) {
+                taskpool_submit(pool, smooth_curve_task, &schedule, ready[i]);
+        }
+        taskpool_wait(pool);
+        free(ready);
+        taskpool_destroy(pool);
+        pthread_mutex_destroy(&schedule.lock);
+        free(schedule.curves);
+        free(schedule.first);
+        free(schedule.later);
+        free(schedule.waiting);
+}
 
 // Internal functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -149,6 +286,7 @@ CP * init_curve(C * c, float x, float y, const curve_list * cl, alpha a)
         CP * p = new_point(x, y, scanline);
         c->pointList = p;
         c->removed = NULL;
+        c->order = 0;
         return p;
 }
 
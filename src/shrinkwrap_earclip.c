@@ -0,0 +1,439 @@
+//
+//  shrinkwrap_earclip.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_earclip_internal.h"
+
+// Ear clipping
+///////////////////////////////////////////////////////////////////////////////
+// Polygons are held as circular lists of nodes, the outer ring clockwise on screen and holes anticlockwise, the same
+// orientation contours are traced in.  Holes are joined to the outer ring from left to right by a bridge to a vertex
+// the hole can see, so the polygon becomes one ring that touches itself along each bridge.  Ears are then cut off
+// while any remain.  Rings that do not clip cleanly, e.g. where they touch themselves, are retried without collinear
+// points, then with small self-intersections cut away and finally split in two along a valid diagonal.  This follows
+// the approach of the mapbox earcut library.
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Triangulate the outer ring less its holes, adding the triangles to an index list.
+void earclip(array * indices, const ear_ring * outer, const ear_ring * holes, size_t holeCount)
+{
+        ear_pool pool = {NULL, EAR_BLOCK_SIZE};
+        ear_node * outerNode = ear_ring_nodes(&pool, outer, TRUE);
+        if (outerNode == NULL || outerNode->next == outerNode->prev) {
+                destroy_ear_pool(&pool);
+                return;
+        }
+        if (holeCount > 0) {
+                ear_node ** queue = (ear_node **)malloc(sizeof(ear_node *) * holeCount);
+                size_t queued = 0;
+                for (size_t i = 0; i < holeCount; i++) {
+                        ear_node * list = ear_ring_nodes(&pool, holes + i, FALSE);
+                        if (list) {
+                                queue[queued++] = leftmost_ear_node(list);
+                        }
+                }
+                qsort(queue, queued, sizeof(ear_node *), compare_ear_node_x);
+                for (size_t i = 0; i < queued; i++) {
+                        outerNode = eliminate_hole(&pool, queue[i], outerNode);
+                }
+                free(queue);
+        }
+        clip_ears(&pool, indices, outerNode, 0);
+        destroy_ear_pool(&pool);
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Link a ring's vertices, reversing them if needed so outer rings run clockwise on screen and holes anticlockwise.
+// Returns the last node, or NULL for an empty ring.
+ear_node * ear_ring_nodes(ear_pool * pool, const ear_ring * ring, int outer)
+{
+        ear_node * last = NULL;
+        int clockwise = ring_signed_area(ring->points, ring->count) > 0.0;
+        if (clockwise == outer) {
+                for (size_t i = 0; i < ring->count; i++) {
+                        const vert * v = ring->points + i;
+                        last = create_ear_node(pool, v->x, v->y, ring->index + (uint32_t)i, last);
+                }
+        } else {
+                for (size_t i = ring->count; i > 0; i--) {
+                        const vert * v = ring->points + i - 1;
+                        last = create_ear_node(pool, v->x, v->y, ring->index + (uint32_t)(i - 1), last);
+                }
+        }
+        if (last && last->x == last->next->x && last->y == last->next->y) {
+                remove_ear_node(last);
+                last = last->next;
+        }
+        return last;
+}
+
+// Allocate a node and insert it after 'last', or start a new ring if 'last' is NULL.
+ear_node * create_ear_node(ear_pool * pool, float x, float y, uint32_t index, ear_node * last)
+{
+        if (pool->used == EAR_BLOCK_SIZE) {
+                ear_block * block = (ear_block *)malloc(sizeof(ear_block));
+                block->next = pool->blocks;
+                pool->blocks = block;
+                pool->used = 0;
+        }
+        ear_node * p = pool->blocks->nodes + pool->used++;
+        p->x = x;
+        p->y = y;
+        p->index = index;
+        if (last == NULL) {
+                p->prev = p;
+                p->next = p;
+        } else {
+                p->next = last->next;
+                p->prev = last;
+                last->next->prev = p;
+                last->next = p;
+        }
+        return p;
+}
+
+void remove_ear_node(ear_node * p)
+{
+        p->next->prev = p->prev;
+        p->prev->next = p->next;
+}
+
+void destroy_ear_pool(ear_pool * pool)
+{
+        while (pool->blocks) {
+                ear_block * next = pool->blocks->next;
+                free(pool->blocks);
+                pool->blocks = next;
+        }
+        pool->used = EAR_BLOCK_SIZE;
+}
+
+ear_node * leftmost_ear_node(ear_node * start)
+{
+        ear_node * p = start;
+        ear_node * leftmost = start;
+        do {
+                if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y)) {
+                        leftmost = p;
+                }
+                p = p->next;
+        } while (p != start);
+        return leftmost;
+}
+
+int compare_ear_node_x(const void * a, const void * b)
+{
+        float ax = (*(const ear_node * const *)a)->x;
+        float bx = (*(const ear_node * const *)b)->x;
+        return (ax > bx) - (ax < bx);
+}
+
+// Join a hole to the outer ring through a bridge from its leftmost vertex.
+ear_node * eliminate_hole(ear_pool * pool, ear_node * hole, ear_node * outer)
+{
+        ear_node * bridge = find_hole_bridge(hole, outer);
+        if (bridge == NULL) return outer;
+        ear_node * bridgeReverse = split_ear_polygon(pool, bridge, hole);
+        // Drop collinear points around the cut.  This may unlink the node passed in as the outer ring, so carry on
+        // from the node the last filter stopped at, which is always still linked.
+        filter_ear_nodes(bridge, bridge->next);
+        return filter_ear_nodes(bridgeReverse, bridgeReverse->next);
+}
+
+// Find the outer vertex to bridge a hole's leftmost vertex to.  A ray cast left from the hole meets the closest edge
+// of the outer ring; the edge's left end is visible unless reflex vertices lie in the triangle between them, in which
+// case the one closest in angle to the ray is.
+ear_node * find_hole_bridge(const ear_node * hole, ear_node * outer)
+{
+        ear_node * p = outer;
+        float hx = hole->x;
+        float hy = hole->y;
+        float qx = -INFINITY;
+        ear_node * m = NULL;
+        do {
+                if (hy <= p->y && hy >= p->next->y && p->next->y != p->y) {
+                        float x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+                        if (x <= hx && x > qx) {
+                                qx = x;
+                                m = (p->x < p->next->x) ? p : p->next;
+                                // The hole touches the edge
+                                if (x == hx) return m;
+                        }
+                }
+                p = p->next;
+        } while (p != outer);
+        if (m == NULL) return NULL;
+        const ear_node * stop = m;
+        float mx = m->x;
+        float my = m->y;
+        float tanMin = INFINITY;
+        p = m;
+        do {
+                if (hx >= p->x && p->x >= mx && hx != p->x &&
+                    ear_point_in_triangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y)) {
+                        float tan = fabsf(hy - p->y) / (hx - p->x);
+                        if (ear_locally_inside(p, hole) &&
+                            (tan < tanMin || (tan == tanMin && (p->x > m->x ||
+                                                                 (p->x == m->x && sector_contains_sector(m, p)))))) {
+                                m = p;
+                                tanMin = tan;
+                        }
+                }
+                p = p->next;
+        } while (p != stop);
+        return m;
+}
+
+// Determine if the wedge of ring at m contains the wedge at p.
+int sector_contains_sector(const ear_node * m, const ear_node * p)
+{
+        return ear_area(m->prev, m, p->prev) < 0.0f && ear_area(p->next, m, m->next) < 0.0f;
+}
+
+// Remove repeated and collinear points from start up to end.  Returns a node still on the ring.
+ear_node * filter_ear_nodes(ear_node * start, ear_node * end)
+{
+        if (start == NULL) return start;
+        if (end == NULL) end = start;
+        ear_node * p = start;
+        int again;
+        do {
+                again = FALSE;
+                if ((p->x == p->next->x && p->y == p->next->y) || ear_area(p->prev, p, p->next) == 0.0f) {
+                        remove_ear_node(p);
+                        p = end = p->prev;
+                        if (p == p->next) break;
+                        again = TRUE;
+                } else {
+                        p = p->next;
+                }
+        } while (again || p != end);
+        return end;
+}
+
+// Cut off ears until the ring is a triangle, escalating through the fallbacks when none can be found.
+void clip_ears(ear_pool * pool, array * indices, ear_node * ear, int pass)
+{
+        if (ear == NULL) return;
+        ear_node * stop = ear;
+        while (ear->prev != ear->next) {
+                ear_node * prev = ear->prev;
+                ear_node * next = ear->next;
+                if (is_ear(ear)) {
+                        push_index(indices, prev->index);
+                        push_index(indices, ear->index);
+                        push_index(indices, next->index);
+                        remove_ear_node(ear);
+                        // Skipping a vertex gives fewer slivers
+                        ear = next->next;
+                        stop = next->next;
+                        continue;
+                }
+                ear = next;
+                if (ear == stop) {
+                        if (pass == 0) {
+                                clip_ears(pool, indices, filter_ear_nodes(ear, NULL), 1);
+                        } else if (pass == 1) {
+                                ear = cure_local_intersections(filter_ear_nodes(ear, NULL), indices);
+                                clip_ears(pool, indices, ear, 2);
+                        } else {
+                                split_clip_ears(pool, indices, ear);
+                        }
+                        break;
+                }
+        }
+}
+
+// An ear is a convex vertex whose triangle holds no reflex vertex of the ring.
+int is_ear(const ear_node * ear)
+{
+        const ear_node * a = ear->prev;
+        const ear_node * b = ear;
+        const ear_node * c = ear->next;
+        if (ear_area(a, b, c) >= 0.0f) return FALSE;
+        const ear_node * p = c->next;
+        while (p != a) {
+                if (ear_point_in_triangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+                    ear_area(p->prev, p, p->next) >= 0.0f) return FALSE;
+                p = p->next;
+        }
+        return TRUE;
+}
+
+// Cut off triangles where two edges a step apart cross, leaving a simpler ring.
+ear_node * cure_local_intersections(ear_node * start, array * indices)
+{
+        ear_node * p = start;
+        do {
+                ear_node * a = p->prev;
+                ear_node * b = p->next->next;
+                if ((a->x != b->x || a->y != b->y) && ear_nodes_intersect(a, p, p->next, b) &&
+                    ear_locally_inside(a, b) && ear_locally_inside(b, a)) {
+                        push_index(indices, a->index);
+                        push_index(indices, p->index);
+                        push_index(indices, b->index);
+                        remove_ear_node(p);
+                        remove_ear_node(p->next);
+                        p = start = b;
+                }
+                p = p->next;
+        } while (p != start);
+        return filter_ear_nodes(p, NULL);
+}
+
+// Split the ring in two along the first valid diagonal and clip each half.
+void split_clip_ears(ear_pool * pool, array * indices, ear_node * start)
+{
+        ear_node * a = start;
+        do {
+                ear_node * b = a->next->next;
+                while (b != a->prev) {
+                        if (a->index != b->index && is_valid_diagonal(a, b)) {
+                                ear_node * c = split_ear_polygon(pool, a, b);
+                                a = filter_ear_nodes(a, a->next);
+                                c = filter_ear_nodes(c, c->next);
+                                clip_ears(pool, indices, a, 0);
+                                clip_ears(pool, indices, c, 0);
+                                return;
+                        }
+                        b = b->next;
+                }
+                a = a->next;
+        } while (a != start);
+}
+
+// Link a to b, duplicating both so the ring splits in two, or joins two rings into one.  Returns the copy of b.
+ear_node * split_ear_polygon(ear_pool * pool, ear_node * a, ear_node * b)
+{
+        ear_node * a2 = create_ear_node(pool, a->x, a->y, a->index, NULL);
+        ear_node * b2 = create_ear_node(pool, b->x, b->y, b->index, NULL);
+        ear_node * an = a->next;
+        ear_node * bp = b->prev;
+        a->next = b;
+        b->prev = a;
+        a2->next = an;
+        an->prev = a2;
+        b2->next = a2;
+        a2->prev = b2;
+        bp->next = b2;
+        b2->prev = bp;
+        return b2;
+}
+
+// A diagonal is valid if it crosses no edge, runs inside the ring and does not leave opposite-facing wedges.
+int is_valid_diagonal(const ear_node * a, const ear_node * b)
+{
+        if (a->next->index == b->index || a->prev->index == b->index) return FALSE;
+        const ear_node * p = a;
+        do {
+                if (p->index != a->index && p->next->index != a->index && p->index != b->index &&
+                    p->next->index != b->index && ear_nodes_intersect(p, p->next, a, b)) return FALSE;
+                p = p->next;
+        } while (p != a);
+        if (ear_locally_inside(a, b) && ear_locally_inside(b, a) && ear_middle_inside(a, b) &&
+            (ear_area(a->prev, a, b->prev) != 0.0f || ear_area(a, b->prev, b) != 0.0f)) return TRUE;
+        // Zero-length diagonal between touching vertices
+        return a->x == b->x && a->y == b->y && ear_area(a->prev, a, a->next) > 0.0f &&
+               ear_area(b->prev, b, b->next) > 0.0f;
+}
+
+// Twice the signed area of pqr; negative where the ring turns clockwise on screen.
+float ear_area(const ear_node * p, const ear_node * q, const ear_node * r)
+{
+        return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+}
+
+int ear_point_in_triangle(float ax, float ay, float bx, float by, float cx, float cy, float px, float py)
+{
+        return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+               (ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+               (bx - px) * (cy - py) >= (cx - px) * (by - py);
+}
+
+static int ear_sign(float value)
+{
+        return (value > 0.0f) - (value < 0.0f);
+}
+
+// Determine if q lies within the bounding box of segment pr, given the three are collinear.
+static int ear_on_segment(const ear_node * p, const ear_node * q, const ear_node * r)
+{
+        return q->x <= fmaxf(p->x, r->x) && q->x >= fminf(p->x, r->x) &&
+               q->y <= fmaxf(p->y, r->y) && q->y >= fminf(p->y, r->y);
+}
+
+// Determine if segments p1q1 and p2q2 meet, including at their ends.
+int ear_nodes_intersect(const ear_node * p1, const ear_node * q1, const ear_node * p2, const ear_node * q2)
+{
+        int o1 = ear_sign(ear_area(p1, q1, p2));
+        int o2 = ear_sign(ear_area(p1, q1, q2));
+        int o3 = ear_sign(ear_area(p2, q2, p1));
+        int o4 = ear_sign(ear_area(p2, q2, q1));
+        if (o1 != o2 && o3 != o4) return TRUE;
+        if (o1 == 0 && ear_on_segment(p1, p2, q1)) return TRUE;
+        if (o2 == 0 && ear_on_segment(p1, q2, q1)) return TRUE;
+        if (o3 == 0 && ear_on_segment(p2, p1, q2)) return TRUE;
+        if (o4 == 0 && ear_on_segment(p2, q1, q2)) return TRUE;
+        return FALSE;
+}
+
+// Determine if the diagonal from a towards b starts inside the ring.
+int ear_locally_inside(const ear_node * a, const ear_node * b)
+{
+        if (ear_area(a->prev, a, a->next) < 0.0f) {
+                return ear_area(a, b, a->next) >= 0.0f && ear_area(a, a->prev, b) >= 0.0f;
+        }
+        return ear_area(a, b, a->prev) < 0.0f || ear_area(a, a->next, b) < 0.0f;
+}
+
+// Determine if the middle of the diagonal from a to b is inside the ring.
+int ear_middle_inside(const ear_node * a, const ear_node * b)
+{
+        const ear_node * p = a;
+        int inside = FALSE;
+        float px = (a->x + b->x) / 2.0f;
+        float py = (a->y + b->y) / 2.0f;
+        do {
+                if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+                    (px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x)) {
+                        inside = !inside;
+                }
+                p = p->next;
+        } while (p != a);
+        return inside;
+}
+
+// Area of a ring by the shoelace formula; positive when it runs clockwise on screen.
+double ring_signed_area(const vert * points, size_t count)
+{
+        double area = 0.0;
+        for (size_t i = 0; i < count; i++) {
+                const vert * a = points + i;
+                const vert * b = points + (i + 1) % count;
+                area += (double)a->x * b->y - (double)b->x * a->y;
+        }
+        return area * 0.5;
+}
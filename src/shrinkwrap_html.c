@@ -19,99 +19,101 @@
 //  You should have received a copy of the GNU Affero General Public License
 //  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
 //
+#include <stdlib.h>
 #include <assert.h>
 #include "shrinkwrap_html.h"
 #include "internal/shrinkwrap_internal_t.h"
+#include "internal/shrinkwrap_quantise_internal.h"
+#include "internal/shrinkwrap_strip_internal.h"
 
-void html_prologue(FILE * output, pxl_size width, pxl_size height)
+void html_prologue(textwriter * output, pxl_size width, pxl_size height)
 {
-        fprintf(output, "<!DOCTYPE HTML>\n");
-        fprintf(output, "<html>\n");
-        fprintf(output, "\t<head>\n");
-        fprintf(output, "\t\t<style>\n");
-        fprintf(output, "\t\t\tbody {\n");
-        fprintf(output, "\t\t\t\tmargin: 0px;\n");
-        fprintf(output, "\t\t\t\tpadding: 0px;\n");
-        fprintf(output, "\t\t\t}\n");
-        fprintf(output, "\t\t</style>\n");
-        fprintf(output, "\t</head>\n");
-        fprintf(output, "\t<body>\n");
-        fprintf(output, "\t\t<img id=\"bg\" src=\"test.png\" width=\"4096\" height=\"2048\">\n");
-        fprintf(output, "\t\t<div id='d1' style=\"position:absolute; top:0; left:0; z-index:1\">\n");
-        fprintf(output, "\t\t\t<canvas id=\"myCanvas\" width=\"%ud\" height=\"%ud\"></canvas>\n", width * 4, height * 4);
-        fprintf(output, "\t\t</div>\n");
-        fprintf(output, "\t\t<script>\n");
-        fprintf(output, "\t\t\tvar canvas = document.getElementById('myCanvas');\n");
-        fprintf(output, "\t\t\tvar context = canvas.getContext('2d');\n");
-//        fprintf(output, "\t\t\tvar img=document.getElementById(\"bg\");\n");
-//        fprintf(output, "\t\t\tctx.drawImage(img,0,0);\n");
+        textwriter_printf(output, "<!DOCTYPE HTML>\n");
+        textwriter_printf(output, "<html>\n");
+        textwriter_printf(output, "\t<head>\n");
+        textwriter_printf(output, "\t\t<style>\n");
+        textwriter_printf(output, "\t\t\tbody {\n");
+        textwriter_printf(output, "\t\t\t\tmargin: 0px;\n");
+        textwriter_printf(output, "\t\t\t\tpadding: 0px;\n");
+        textwriter_printf(output, "\t\t\t}\n");
+        textwriter_printf(output, "\t\t</style>\n");
+        textwriter_printf(output, "\t</head>\n");
+        textwriter_printf(output, "\t<body>\n");
+        textwriter_printf(output, "\t\t<img id=\"bg\" src=\"test.png\" width=\"4096\" height=\"2048\">\n");
+        textwriter_printf(output, "\t\t<div id='d1' style=\"position:absolute; top:0; left:0; z-index:1\">\n");
+        textwriter_printf(output, "\t\t\t<canvas id=\"myCanvas\" width=\"%u\" height=\"%u\"></canvas>\n",
+                          (unsigned)(width * 4), (unsigned)(height * 4));
+        textwriter_printf(output, "\t\t</div>\n");
+        textwriter_printf(output, "\t\t<script>\n");
+        textwriter_printf(output, "\t\t\tvar canvas = document.getElementById('myCanvas');\n");
+        textwriter_printf(output, "\t\t\tvar context = canvas.getContext('2d');\n");
+//        textwriter_printf(output, "\t\t\tvar img=document.getElementById(\"bg\");\n");
+//        textwriter_printf(output, "\t\t\tctx.drawImage(img,0,0);\n");
 }
 
-void html_epilogue(FILE * output)
+void html_epilogue(textwriter * output)
 {
-        fprintf(output, "\t\t</script>\n");
-        fprintf(output, "\t</body>\n");
-        fprintf(output, "</html>\n");
+        textwriter_printf(output, "\t\t</script>\n");
+        textwriter_printf(output, "\t</body>\n");
+        textwriter_printf(output, "</html>\n");
 }
 
-void move(FILE * output, float x, float y)
+void move(textwriter * output, float x, float y)
 {
-        fprintf(output, "\t\t\tcontext.moveTo(%f, %f);\n", x * 4, y * 4);
+        textwriter_printf(output, "\t\t\tcontext.moveTo(%f, %f);\n", x * 4, y * 4);
 }
 
-void line(FILE * output, float x, float y)
+void line(textwriter * output, float x, float y)
 {
-        fprintf(output, "\t\t\tcontext.lineTo(%f, %f);\n", x * 4, y * 4);
+        textwriter_printf(output, "\t\t\tcontext.lineTo(%f, %f);\n", x * 4, y * 4);
 }
 
-void html_draw_triangles(FILE * output, array * vertArray, array * indexArray, const char * colour, float x,
-                       float y)
+void htmlDrawTriangle(textwriter * output, array * vertArray, const uint32_t * indices, const char * colour, float x,
+                      float y)
+{
+        vertp verts[3];
+        textwriter_printf(output, "\t\t\tcontext.fillStyle=\"rgba(%s, .5)\"\n", colour);
+        textwriter_printf(output, "\t\t\tcontext.strokeStyle=\"rgba(%s, 1)\"\n", colour);
+        textwriter_printf(output, "\t\t\tcontext.beginPath();\n");
+        verts[0] = get_vert(vertArray, indices[0]);
+        verts[1] = get_vert(vertArray, indices[1]);
+        verts[2] = get_vert(vertArray, indices[2]);
+        move(output, verts[0]->x + x, verts[0]->y + y);
+        line(output, verts[1]->x + x, verts[1]->y + y);
+        line(output, verts[2]->x + x, verts[2]->y + y);
+        line(output, verts[0]->x + x, verts[0]->y + y);
+        textwriter_printf(output, "\t\t\tcontext.closePath();\n");
+        textwriter_printf(output, "\t\t\tcontext.fill();\n");
+        textwriter_printf(output, "\t\t\tcontext.stroke();\n");
+}
+
+void html_draw_triangles(textwriter * output, array * vertArray, array * indexArray, primitive mode,
+                         const char * colour, float x, float y)
 {
         size_t index = 0;
-        size_t numIndices = array_size(indexArray);
-        if (numIndices == 0) return;
-        assert((numIndices % 3) == 0 && "Indices not divisible by 3!");
-        
         uint32_t indices[3];
-        vertp verts[3];
-        while (index <= numIndices-3) {
-                fprintf(output, "\t\t\tcontext.fillStyle=\"rgba(%s, .5)\"\n", colour);
-                fprintf(output, "\t\t\tcontext.strokeStyle=\"rgba(%s, 1)\"\n", colour);
-                fprintf(output, "\t\t\tcontext.beginPath();\n");
-                indices[0] = get_index(indexArray, index);
-                indices[1] = get_index(indexArray, index+1);
-                indices[2] = get_index(indexArray, index+2);
-                verts[0] = get_vert(vertArray, indices[0]);
-                verts[1] = get_vert(vertArray, indices[1]);
-                verts[2] = get_vert(vertArray, indices[2]);
-                move(output, verts[0]->x + x, verts[0]->y + y);
-                line(output, verts[1]->x + x, verts[1]->y + y);
-                line(output, verts[2]->x + x, verts[2]->y + y);
-                line(output, verts[0]->x + x, verts[0]->y + y);
-                index += 3;
-                fprintf(output, "\t\t\tcontext.closePath();\n");
-                fprintf(output, "\t\t\tcontext.fill();\n");
-                fprintf(output, "\t\t\tcontext.stroke();\n");
+        while (next_triangle(indexArray, mode, &index, indices)) {
+                htmlDrawTriangle(output, vertArray, indices, colour, x, y);
         }
 }
 
-void htmlDrawCurve(FILE * out, C * c, float x, float y)
+void htmlDrawCurve(textwriter * out, C * c, float x, float y)
 {
         static const char * const c_colours[] = {"0, 255, 255", "0, 255, 0", "0, 0, 255",
                 "255, 0, 0"};
         CP * p = c->pointList;
         const char * const colour = c_colours[c->alphaType];
-        fprintf(out, "\t\t\tcontext.fillStyle=\"rgba(%s, 1)\"\n", colour);
-        fprintf(out, "\t\t\tcontext.beginPath();\n");
+        textwriter_printf(out, "\t\t\tcontext.fillStyle=\"rgba(%s, 1)\"\n", colour);
+        textwriter_printf(out, "\t\t\tcontext.beginPath();\n");
         float sx = p->vertex.x + x;
         float sy = p->vertex.y + y;
         move(out, sx - 2, sy - 2);
         line(out, sx + 2, sy - 2);
         line(out, sx - 2, sy + 2);
-        fprintf(out, "\t\t\tcontext.closePath();\n");
-        fprintf(out, "\t\t\tcontext.fill();\n");
-        fprintf(out, "\t\t\tcontext.strokeStyle=\"rgba(%s, 1)\"\n", colour);
-        fprintf(out, "\t\t\tcontext.beginPath();\n");
+        textwriter_printf(out, "\t\t\tcontext.closePath();\n");
+        textwriter_printf(out, "\t\t\tcontext.fill();\n");
+        textwriter_printf(out, "\t\t\tcontext.strokeStyle=\"rgba(%s, 1)\"\n", colour);
+        textwriter_printf(out, "\t\t\tcontext.beginPath();\n");
         int first = TRUE;
         vertp vert = NULL;
         assert(p);
@@ -127,19 +129,19 @@ void htmlDrawCurve(FILE * out, C * c, float x, float y)
                 }
                 p = p->next;
         }
-        fprintf(out, "\t\t\tcontext.stroke();\n");
-        fprintf(out, "\t\t\tcontext.fillStyle=\"rgba(%s, 1)\"\n", colour);
-        fprintf(out, "\t\t\tcontext.beginPath();\n");
+        textwriter_printf(out, "\t\t\tcontext.stroke();\n");
+        textwriter_printf(out, "\t\t\tcontext.fillStyle=\"rgba(%s, 1)\"\n", colour);
+        textwriter_printf(out, "\t\t\tcontext.beginPath();\n");
         sx = vert->x + x;
         sy = vert->y + y;
         line(out, sx + 2, sy - 2);
         line(out, sx + 2, sy + 2);
         line(out, sx - 2, sy + 2);
-        fprintf(out, "\t\t\tcontext.closePath();\n");
-        fprintf(out, "\t\t\tcontext.fill();\n");
+        textwriter_printf(out, "\t\t\tcontext.closePath();\n");
+        textwriter_printf(out, "\t\t\tcontext.fill();\n");
 }
 
-void html_draw_curves(FILE * output, curve_list * curves, float x, float y)
+void html_draw_curves(textwriter * output, curve_list * curves, float x, float y)
 {
         CN * n = curves->head->next;
         while (n) {
@@ -149,17 +151,109 @@ void html_draw_curves(FILE * output, curve_list * curves, float x, float y)
         }
 }
 
-void save_diagnostic_html(FILE * out, shrinkwrap ** shrinkwraps, size_t count, pxl_size w, pxl_size h)
+void htmlDrawContour(textwriter * out, contour * c, float x, float y)
+{
+        const char * const colour = (c->alphaType == ALPHA_FULL) ? "0, 0, 255" : "255, 0, 0";
+        size_t count = array_size(c->points);
+        if (count == 0) return;
+        textwriter_printf(out, "\t\t\tcontext.strokeStyle=\"rgba(%s, 1)\"\n", colour);
+        textwriter_printf(out, "\t\t\tcontext.beginPath();\n");
+        for (size_t i = 0; i < count; i++) {
+                vertp vert = get_vert(c->points, i);
+                if (i == 0) {
+                        move(out, vert->x + x, vert->y + y);
+                } else {
+                        line(out, vert->x + x, vert->y + y);
+                }
+        }
+        textwriter_printf(out, "\t\t\tcontext.closePath();\n");
+        textwriter_printf(out, "\t\t\tcontext.stroke();\n");
+}
+
+// Visible borders are drawn in red and opaque borders in blue.
+void html_draw_contours(textwriter * output, contour_list * contours, float x, float y)
+{
+        for (size_t i = 0; i < array_size(contours->contours); i++) {
+                htmlDrawContour(output, (contour *)array_get(contours->contours, i), x, y);
+        }
+}
+
+// Expand quantised vertices back to floats so the page shows what the runtime will draw.
+array * htmlDequantise(const shrinkwrap * sw)
+{
+        size_t count = array_size(sw->quantisedVertices);
+        array * verts = array_create(count > 0 ? count : 1, sizeof(vert));
+        for (size_t i = 0; i < count; i++) {
+                const quantised_vert * q = (const quantised_vert *)array_get(sw->quantisedVertices, i);
+                *add_vert(verts) = dequantise_vertex(&sw->quantisation, q);
+        }
+        return verts;
+}
+
+void htmlDrawShrinkwrap(textwriter * out, shrinkwrap * sw)
+{
+        float x = sw->origX;
+        float y = sw->origY;
+        int quantised = vertex_format_is_quantised(sw->vertexFormat);
+        array * verts = quantised ? htmlDequantise(sw) : sw->vertices;
+        html_draw_triangles(out, verts, sw->indicesPartialAlpha, sw->primitiveType, "0, 255, 255", x, y);
+        html_draw_triangles(out, verts, sw->indicesFullAlpha, sw->primitiveType, "255, 255, 0", x, y);
+        if (quantised) {
+                array_destroy(verts);
+        }
+}
+
+static const size_t c_htmlBufferSize = 1 << 20;
+
+void save_diagnostic_html(FILE * output, shrinkwrap ** shrinkwraps, size_t count, pxl_size w, pxl_size h)
 {
+        textwriter * out = textwriter_create(output, c_htmlBufferSize);
         html_prologue(out, w, h);
         while (count) {
-                shrinkwrap * sw = *shrinkwraps;
-                float x = sw->origX;
-                float y = sw->origY;
-                html_draw_triangles(out, sw->vertices, sw->indicesPartialAlpha, "0, 255, 255", x, y);
-                html_draw_triangles(out, sw->vertices, sw->indicesFullAlpha, "255, 255, 0", x, y);
+                htmlDrawShrinkwrap(out, *shrinkwraps);
                 shrinkwraps++;
                 count--;
         }
         html_epilogue(out);
+        textwriter_destroy(out);
+}
+
+// HTML sink
+///////////////////////////////////////////////////////////////////////////////
+int htmlSinkBegin(mesh_sink * sink, uint32_t atlasWidth, uint32_t atlasHeight)
+{
+        textwriter * out = (textwriter *)sink->context;
+        html_prologue(out, atlasWidth, atlasHeight);
+        return textwriter_ok(out);
+}
+
+int htmlSinkFrame(mesh_sink * sink, shrinkwrap * sw, const char * name)
+{
+        textwriter * out = (textwriter *)sink->context;
+        htmlDrawShrinkwrap(out, sw);
+        return textwriter_ok(out);
+}
+
+int htmlSinkEnd(mesh_sink * sink)
+{
+        textwriter * out = (textwriter *)sink->context;
+        html_epilogue(out);
+        return textwriter_flush(out);
+}
+
+void htmlSinkDestroy(mesh_sink * sink)
+{
+        textwriter_destroy((textwriter *)sink->context);
+        free(sink);
+}
+
+mesh_sink * create_html_sink(FILE * output)
+{
+        mesh_sink * sink = (mesh_sink *)malloc(sizeof(mesh_sink));
+        sink->begin = htmlSinkBegin;
+        sink->frame = htmlSinkFrame;
+        sink->end = htmlSinkEnd;
+        sink->destroy = htmlSinkDestroy;
+        sink->context = textwriter_create(output, c_htmlBufferSize);
+        return sink;
 }
@@ -25,16 +25,20 @@
 #include <stdio.h>
 #include "shrinkwrap_t.h"
 #include "pixel_t.h"
+#include "textwriter.h"
 
-void html_prologue(FILE * output, pxl_size width, pxl_size height);
-void html_epilogue(FILE * output);
-void html_draw_triangles(FILE * output, array * vertArray, array * indexArray, const char * colour, float x,
-                       float y);
+void html_prologue(textwriter * output, pxl_size width, pxl_size height);
+void html_epilogue(textwriter * output);
+void html_draw_triangles(textwriter * output, array * vertArray, array * indexArray, primitive mode,
+                         const char * colour, float x, float y);
 
-void html_draw_curves(FILE * output, curve_list * curves, float x, float y);
+void html_draw_curves(textwriter * output, curve_list * curves, float x, float y);
+void html_draw_contours(textwriter * output, contour_list * contours, float x, float y);
 
 void save_diagnostic_html(FILE * output, shrinkwrap ** geometry_list, size_t count, pxl_size width,
                         pxl_size height);
+// Draws each frame's mesh as it arrives, as save_diagnostic_html does
+mesh_sink * create_html_sink(FILE * output);
 
 
 #endif
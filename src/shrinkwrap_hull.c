@@ -0,0 +1,296 @@
+//
+//  shrinkwrap_hull.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_hull_internal.h"
+#include "internal/shrinkwrap_earclip_internal.h"
+#include "internal/shrinkwrap_triangle_internal.h"
+
+// Convex hull decomposition
+///////////////////////////////////////////////////////////////////////////////
+// A frame starts as the quad bounding its visible pixels.  A rectangle that is all opaque is drawn as a full alpha
+// quad; otherwise the convex hull of its visible pixels is drawn as partial alpha, unless the hull would blend more
+// than maxWaste pixels that are transparent or opaque.  Such rectangles are cut in two, across whichever row or column
+// leaves the least waste in the bounding rectangles of the two halves, and each half is shrunk to its visible pixels
+// and divided again.  Summed-area tables count the pixels of any rectangle in constant time, so choosing a cut costs
+// O((w + h) log(w + h)) however many pixels the rectangle holds.  Hulls lie within their rectangles, so they never
+// overlap.
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+shrinkwrap * decompose_hulls(const tpxl * tpixels, pxl_size w, pxl_size h, float maxWaste)
+{
+        alpha_sums * sums = create_alpha_sums(tpixels, w, h);
+        hull_decompose d;
+        d.sums = sums;
+        d.vertices = array_create(64, sizeof(vert));
+        d.indicesFullAlpha = array_create(64, sizeof(uint32_t));
+        d.indicesPartialAlpha = array_create(64, sizeof(uint32_t));
+        d.maxWaste = maxWaste;
+        d.points = (vert *)malloc(sizeof(vert) * ((size_t)h * 4 + 1));
+        d.hull = (vert *)malloc(sizeof(vert) * ((size_t)h * 4 + 1));
+        pixel_rect frame = {0, 0, w, h};
+        decompose_rect(&d, &frame);
+        size_t vertexCount = array_size(d.vertices);
+        shrinkwrap * sw = create_shrink_wrap(vertexCount > 0 ? (uint32_t)vertexCount : 1);
+        for (size_t v = 0; v < vertexCount; v++) {
+                *add_vert(sw->vertices) = *get_vert(d.vertices, v);
+        }
+        for (size_t i = 0; i < array_size(d.indicesFullAlpha); i++) {
+                push_index(sw->indicesFullAlpha, *(uint32_t *)array_get(d.indicesFullAlpha, i));
+        }
+        for (size_t i = 0; i < array_size(d.indicesPartialAlpha); i++) {
+                push_index(sw->indicesPartialAlpha, *(uint32_t *)array_get(d.indicesPartialAlpha, i));
+        }
+        array_destroy(d.vertices);
+        array_destroy(d.indicesFullAlpha);
+        array_destroy(d.indicesPartialAlpha);
+        free(d.points);
+        free(d.hull);
+        destroy_alpha_sums(sums);
+        return sw;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+alpha_sums * create_alpha_sums(const tpxl * tpixels, pxl_size w, pxl_size h)
+{
+        alpha_sums * sums = (alpha_sums *)malloc(sizeof(alpha_sums));
+        size_t stride = (size_t)w + 1;
+        sums->visible = (uint32_t *)calloc(stride * (h + 1), sizeof(uint32_t));
+        sums->full = (uint32_t *)calloc(stride * (h + 1), sizeof(uint32_t));
+        sums->width = w;
+        sums->height = h;
+        for (pxl_size y = 0; y < h; y++) {
+                uint32_t visibleRow = 0;
+                uint32_t fullRow = 0;
+                for (pxl_size x = 0; x < w; x++) {
+                        alpha a = (alpha)(tpixels[(size_t)y * w + x] & ALPHA_ANYALPHA);
+                        visibleRow += isAlpha(a) ? 1 : 0;
+                        fullRow += (a == ALPHA_FULL) ? 1 : 0;
+                        size_t i = (size_t)(y + 1) * stride + x + 1;
+                        sums->visible[i] = sums->visible[i - stride] + visibleRow;
+                        sums->full[i] = sums->full[i - stride] + fullRow;
+                }
+        }
+        return sums;
+}
+
+void destroy_alpha_sums(alpha_sums * sums)
+{
+        free(sums->visible);
+        free(sums->full);
+        free(sums);
+}
+
+// Count the pixels of a rectangle in a summed-area table for a map w pixels wide.
+uint32_t sum_rect(const uint32_t * table, pxl_size w, const pixel_rect * rect)
+{
+        size_t stride = (size_t)w + 1;
+        size_t top = (size_t)rect->y * stride;
+        size_t bottom = (size_t)(rect->y + (pxl_pos)rect->h) * stride;
+        size_t left = (size_t)rect->x;
+        size_t right = (size_t)(rect->x + (pxl_pos)rect->w);
+        return table[bottom + right] - table[bottom + left] - table[top + right] + table[top + left];
+}
+
+// Find the fewest leading rows, or columns, of a rectangle that hold 'count' of its visible pixels.
+pxl_size visible_prefix(const alpha_sums * sums, const pixel_rect * rect, int columns, uint32_t count)
+{
+        pxl_size low = 1;
+        pxl_size high = columns ? rect->w : rect->h;
+        while (low < high) {
+                pxl_size mid = low + (high - low) / 2;
+                pixel_rect prefix = *rect;
+                if (columns) {
+                        prefix.w = mid;
+                } else {
+                        prefix.h = mid;
+                }
+                if (sum_rect(sums->visible, sums->width, &prefix) >= count) {
+                        high = mid;
+                } else {
+                        low = mid + 1;
+                }
+        }
+        return low;
+}
+
+// Shrink a rectangle to the bounds of its visible pixels.  Returns FALSE if it has none.
+int fit_visible_rect(const alpha_sums * sums, const pixel_rect * rect, pixel_rect * outRect)
+{
+        uint32_t total = sum_rect(sums->visible, sums->width, rect);
+        if (total == 0) return FALSE;
+        pixel_rect fit = *rect;
+        pxl_size skip = visible_prefix(sums, &fit, FALSE, 1) - 1;
+        fit.y += (pxl_pos)skip;
+        fit.h -= skip;
+        fit.h = visible_prefix(sums, &fit, FALSE, total);
+        skip = visible_prefix(sums, &fit, TRUE, 1) - 1;
+        fit.x += (pxl_pos)skip;
+        fit.w -= skip;
+        fit.w = visible_prefix(sums, &fit, TRUE, total);
+        *outRect = fit;
+        return TRUE;
+}
+
+// Pixels that drawing the bounds of a rectangle's visible pixels would blend needlessly: transparent ones, and opaque
+// ones unless the bounds are all opaque.
+float rect_waste(const alpha_sums * sums, const pixel_rect * rect)
+{
+        pixel_rect fit;
+        if (fit_visible_rect(sums, rect, &fit) == FALSE) return 0.0f;
+        uint32_t area = fit.w * fit.h;
+        uint32_t full = sum_rect(sums->full, sums->width, &fit);
+        if (full == area) return 0.0f;
+        uint32_t partial = sum_rect(sums->visible, sums->width, &fit) - full;
+        return (float)(area - partial);
+}
+
+// Draw a rectangle as an opaque quad or a blended hull, or cut it in two and divide the halves.
+void decompose_rect(hull_decompose * d, const pixel_rect * rect)
+{
+        pixel_rect fit;
+        if (fit_visible_rect(d->sums, rect, &fit) == FALSE) return;
+        uint32_t area = fit.w * fit.h;
+        uint32_t full = sum_rect(d->sums->full, d->sums->width, &fit);
+        if (full == area) {
+                float left = (float)fit.x;
+                float right = (float)(fit.x + (pxl_pos)fit.w);
+                float top = (float)fit.y;
+                float bottom = (float)(fit.y + (pxl_pos)fit.h);
+                const vert quad[4] = {{left, top, 0, 0}, {right, top, 0, 0}, {right, bottom, 0, 0},
+                                      {left, bottom, 0, 0}};
+                add_hull_fan(d, quad, 4, d->indicesFullAlpha);
+                return;
+        }
+        size_t count = visible_hull(d->sums, &fit, d->points, d->hull);
+        uint32_t partial = sum_rect(d->sums->visible, d->sums->width, &fit) - full;
+        float waste = (float)ring_signed_area(d->hull, count) - (float)partial;
+        pixel_rect first;
+        pixel_rect second;
+        if (waste <= d->maxWaste || choose_hull_cut(d->sums, &fit, &first, &second) == FALSE) {
+                add_hull_fan(d, d->hull, count, d->indicesPartialAlpha);
+                return;
+        }
+        decompose_rect(d, &first);
+        decompose_rect(d, &second);
+}
+
+// Cut a rectangle across the row or column that leaves the least waste in its halves, favouring the most even cut.
+// Returns FALSE for a single pixel.
+int choose_hull_cut(const alpha_sums * sums, const pixel_rect * rect, pixel_rect * outFirst, pixel_rect * outSecond)
+{
+        float best = INFINITY;
+        pxl_size bestSkew = 0;
+        for (int columns = 0; columns < 2; columns++) {
+                pxl_size length = columns ? rect->w : rect->h;
+                for (pxl_size at = 1; at < length; at++) {
+                        pixel_rect first = *rect;
+                        pixel_rect second = *rect;
+                        if (columns) {
+                                first.w = at;
+                                second.x += (pxl_pos)at;
+                                second.w -= at;
+                        } else {
+                                first.h = at;
+                                second.y += (pxl_pos)at;
+                                second.h -= at;
+                        }
+                        float waste = rect_waste(sums, &first) + rect_waste(sums, &second);
+                        pxl_size skew = (at * 2 > length) ? at * 2 - length : length - at * 2;
+                        if (waste < best || (waste == best && skew < bestSkew)) {
+                                best = waste;
+                                bestSkew = skew;
+                                *outFirst = first;
+                                *outSecond = second;
+                        }
+                }
+        }
+        return best != INFINITY;
+}
+
+// Find the convex hull of the visible pixels of a rectangle from the outer corners of each row, clockwise on screen.
+// 'points' and 'outHull' must hold four points per row.
+size_t visible_hull(const alpha_sums * sums, const pixel_rect * rect, vert * points, vert * outHull)
+{
+        size_t count = 0;
+        for (pxl_size y = 0; y < rect->h; y++) {
+                pixel_rect row = {rect->x, rect->y + (pxl_pos)y, rect->w, 1};
+                uint32_t visible = sum_rect(sums->visible, sums->width, &row);
+                if (visible == 0) continue;
+                float left = (float)(row.x + (pxl_pos)visible_prefix(sums, &row, TRUE, 1) - 1);
+                float right = (float)(row.x + (pxl_pos)visible_prefix(sums, &row, TRUE, visible));
+                float top = (float)row.y;
+                const vert corners[4] = {{left, top, 0, 0}, {left, top + 1.0f, 0, 0}, {right, top, 0, 0},
+                                         {right, top + 1.0f, 0, 0}};
+                memcpy(points + count, corners, sizeof(corners));
+                count += 4;
+        }
+        // Andrew's monotone chain, dropping collinear points
+        qsort(points, count, sizeof(vert), compare_hull_points);
+        size_t size = 0;
+        for (size_t i = 0; i < count; i++) {
+                while (size >= 2 && hull_turn(outHull + size - 2, outHull + size - 1, points + i) <= 0.0f) size--;
+                outHull[size++] = points[i];
+        }
+        size_t lower = size + 1;
+        for (size_t i = count - 1; i-- > 0;) {
+                while (size >= lower && hull_turn(outHull + size - 2, outHull + size - 1, points + i) <= 0.0f) size--;
+                outHull[size++] = points[i];
+        }
+        // The last point repeats the first
+        return size - 1;
+}
+
+int compare_hull_points(const void * a, const void * b)
+{
+        const vert * pa = (const vert *)a;
+        const vert * pb = (const vert *)b;
+        if (pa->x != pb->x) return (pa->x < pb->x) ? -1 : 1;
+        if (pa->y != pb->y) return (pa->y < pb->y) ? -1 : 1;
+        return 0;
+}
+
+// Positive where o, a and b turn clockwise on screen
+float hull_turn(const vert * o, const vert * a, const vert * b)
+{
+        return (a->x - o->x) * (b->y - o->y) - (a->y - o->y) * (b->x - o->x);
+}
+
+// Add a convex polygon as a triangle fan.
+void add_hull_fan(hull_decompose * d, const vert * hull, size_t count, array * indices)
+{
+        uint32_t base = (uint32_t)array_size(d->vertices);
+        for (size_t v = 0; v < count; v++) {
+                *add_vert(d->vertices) = hull[v];
+        }
+        for (uint32_t v = 2; v < count; v++) {
+                uint32_t triangle[3] = {base, base + v - 1, base + v};
+                for (int j = 0; j < 3; j++) {
+                        *(uint32_t *)array_push(indices) = triangle[j];
+                }
+        }
+}
@@ -0,0 +1,202 @@
+//
+//  shrinkwrap_monotone.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "internal/shrinkwrap_triangle_internal.h"
+#include "internal/shrinkwrap_monotone_internal.h"
+
+// Monotone polygon triangulation
+///////////////////////////////////////////////////////////////////////////////
+// Each curve of partial or full alpha is the left edge of a region.  The right-hand boundary is the chain of points the
+// zipper in triangulate follows with get_next_right.  Both chains descend the y-axis, so the region is a y-monotone
+// polygon and can be triangulated in linear time by sweeping down the merged chains and keeping a stack of vertices
+// that still need triangles.
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+shrinkwrap * triangulate_monotone(curve_list * cl)
+{
+        uint32_t numVerts = assign_indices(cl);
+        shrinkwrap * sw = create_shrink_wrap(numVerts);
+        add_vertices(sw, cl);
+        monotone_buffer buffer;
+        buffer.left = array_create(64, sizeof(const CP *));
+        buffer.right = array_create(64, sizeof(const CP *));
+        buffer.capacity = 0;
+        buffer.merged = NULL;
+        buffer.stack = NULL;
+        CN * left = cl->head->next;
+        while (left) {
+                if (left->curve->alphaType != ALPHA_ZERO) {
+                        collect_monotone_chains(left, &buffer);
+                        size_t count = merge_monotone_chains(&buffer);
+                        triangulate_monotone_polygon(sw, left->curve->alphaType, buffer.merged, count,
+                                                     buffer.stack);
+                }
+                left = left->next;
+        }
+        free(buffer.merged);
+        free(buffer.stack);
+        array_destroy(buffer.left);
+        array_destroy(buffer.right);
+        return sw;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Gather the left curve and the right-hand chain followed by the zipper into the buffer.  Where the right-hand chain
+// steps between curves that meet at a point, or meets the left curve at either end, the coincident point is dropped:
+// a repeated point hides the turn the sweep relies on to keep its triangles inside the polygon.
+void collect_monotone_chains(const CN * left, monotone_buffer * buffer)
+{
+        array_clear(buffer->left);
+        array_clear(buffer->right);
+        const CP * last = NULL;
+        for (const CP * p = left->point; p; p = p->next) {
+                *(const CP **)array_push(buffer->left) = p;
+                last = p;
+        }
+        const CN * right = find_next_curve(left->point, left->curve, TRUE);
+        CP * pr = right->point;
+        const CP * prev = left->point;
+        while (pr) {
+                if (point_is_same(pr, prev) == FALSE) {
+                        *(const CP **)array_push(buffer->right) = pr;
+                        prev = pr;
+                }
+                pr = get_next_right(pr, NULL, left->curve, &right);
+        }
+        size_t count = array_size(buffer->right);
+        if (count > 0 && point_is_same(*(const CP **)array_get(buffer->right, count - 1), last)) {
+                array_pop(buffer->right);
+        }
+}
+
+// Merge both chains from top to bottom, ordering points on the same scanline from left to right.  Returns the vertex
+// count.
+size_t merge_monotone_chains(monotone_buffer * buffer)
+{
+        size_t leftcount = array_size(buffer->left);
+        size_t rightcount = array_size(buffer->right);
+        size_t count = leftcount + rightcount;
+        if (leftcount == 0 || rightcount == 0 || count < 3) return 0;
+        if (count > buffer->capacity) {
+                free(buffer->merged);
+                free(buffer->stack);
+                buffer->merged = (monotone_vertex *)malloc(sizeof(monotone_vertex) * count);
+                buffer->stack = (monotone_vertex *)malloc(sizeof(monotone_vertex) * count);
+                buffer->capacity = count;
+        }
+        const CP ** left = (const CP **)array_get(buffer->left, 0);
+        const CP ** right = (const CP **)array_get(buffer->right, 0);
+        size_t l = 0;
+        size_t r = 0;
+        for (size_t i = 0; i < count; i++) {
+                monotone_vertex * v = buffer->merged + i;
+                if (r == rightcount || (l < leftcount && vertex_above(&left[l]->vertex, &right[r]->vertex))) {
+                        v->point = left[l++];
+                        v->side = CHAIN_LEFT;
+                } else {
+                        v->point = right[r++];
+                        v->side = CHAIN_RIGHT;
+                }
+        }
+        return count;
+}
+
+// Triangulate one monotone polygon given its merged vertices.  'stack' must hold at least 'count' vertices.
+void triangulate_monotone_polygon(shrinkwrap * sw, alpha a, const monotone_vertex * vertices, size_t count,
+                                  monotone_vertex * stack)
+{
+        if (count < 3) return;
+        size_t top = 0;
+        stack[top++] = vertices[0];
+        stack[top++] = vertices[1];
+        for (size_t j = 2; j < count - 1; j++) {
+                const monotone_vertex * u = vertices + j;
+                if (u->side != stack[top - 1].side) {
+                        // Opposite chain: everything on the stack is visible from u
+                        for (size_t k = top - 1; k > 0; k--) {
+                                add_oriented_triangle(sw, a, u->point, stack[k].point, stack[k - 1].point);
+                        }
+                        top = 0;
+                        stack[top++] = vertices[j - 1];
+                        stack[top++] = *u;
+                } else {
+                        // Same chain: cut off vertices while the diagonal stays inside the polygon
+                        monotone_vertex last = stack[--top];
+                        while (top > 0) {
+                                const CP * w = stack[top - 1].point;
+                                float t = turn(w, last.point, u->point);
+                                int inside = (u->side == CHAIN_LEFT) ? t < 0.0f : t > 0.0f;
+                                // The right-hand chain can double back along a scanline when it steps between curves
+                                if (t == 0.0f && doubles_back(w, last.point, u->point)) inside = TRUE;
+                                if (inside == FALSE) break;
+                                add_oriented_triangle(sw, a, u->point, last.point, stack[top - 1].point);
+                                last = stack[--top];
+                        }
+                        stack[top++] = last;
+                        stack[top++] = *u;
+                }
+        }
+        const CP * bottom = vertices[count - 1].point;
+        for (size_t k = top - 1; k > 0; k--) {
+                add_oriented_triangle(sw, a, bottom, stack[k].point, stack[k - 1].point);
+        }
+}
+
+// Sweep order: down the y-axis, then left to right along a scanline.
+int vertex_above(const vert * a, const vert * b)
+{
+        return a->y < b->y || (a->y == b->y && a->x <= b->x);
+}
+
+// Determine if the path from a through b to c reverses direction, given the three points are collinear.
+int doubles_back(const CP * a, const CP * b, const CP * c)
+{
+        const vert * va = &a->vertex;
+        const vert * vb = &b->vertex;
+        const vert * vc = &c->vertex;
+        return (vb->x - va->x) * (vc->x - vb->x) + (vb->y - va->y) * (vc->y - vb->y) < 0.0f;
+}
+
+// Add a triangle with the same winding as the zipper, skipping triangles without area.
+void add_oriented_triangle(shrinkwrap * sw, alpha a, const CP * p1, const CP * p2, const CP * p3)
+{
+        float t = turn(p1, p2, p3);
+        if (t == 0.0f) return;
+        if (t > 0.0f) {
+                add_triangle(sw, a, p1, p2, p3);
+        } else {
+                add_triangle(sw, a, p1, p3, p2);
+        }
+}
+
+// Twice the signed area of triangle abc; positive when c lies clockwise of ab with y pointing down.
+float turn(const CP * a, const CP * b, const CP * c)
+{
+        const vert * va = &a->vertex;
+        const vert * vb = &b->vertex;
+        const vert * vc = &c->vertex;
+        return (vb->x - va->x) * (vc->y - va->y) - (vb->y - va->y) * (vc->x - va->x);
+}
@@ -27,6 +27,9 @@
 
 // Inline functions
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+static inline pxl_pos find_partial_before(pxl_pos x, const tpxl * otherline);
+static inline pxl_pos find_partial_after(pxl_pos x, const tpxl * otherline, pxl_size w);
+
 static inline alpha alpha_type(const uch alpha, const uch threshold)
 {
         return (alpha == 0) ? ALPHA_ZERO : ((alpha >= threshold) ? ALPHA_FULL : ALPHA_PARTIAL);
@@ -90,8 +93,9 @@ tpxl * dilate_alpha(const tpxl * tpixels, pxl_size w, pxl_size h, pxl_size bleed
         tpxl * newtpixels = (tpxl *)malloc(sizeof(tpxl) * w * h);
         const tpxl * src = tpixels;
         tpxl * dest = newtpixels;
+        // The rows above and below the current one, if any
         const tpxl * prev = NULL;
-        const tpxl * next = src + w;
+        const tpxl * next = (h > 1) ? src + w : NULL;
         // for each line
         for (size_t line = 0; line < h; line++) {
                 tpxl * pix = dest;
@@ -137,11 +141,7 @@ tpxl * dilate_alpha(const tpxl * tpixels, pxl_size w, pxl_size h, pxl_size bleed
                 prev = src;
                 dest += w;
                 src += w;
-                if (line < h - 1) {
-                        next += w;
-                } else {
-                        next = NULL;
-                }
+                next = (line + 2 < h) ? src + w : NULL;
         }
         return newtpixels;
 }
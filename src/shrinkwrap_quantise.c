@@ -0,0 +1,152 @@
+//
+//  shrinkwrap_quantise.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_quantise_internal.h"
+
+static const char * const c_vertex_format_names[] = {"float", "quantised", "position", "quantised-position"};
+static const size_t c_vertex_format_count = sizeof(c_vertex_format_names) / sizeof(c_vertex_format_names[0]);
+
+static const float c_int16_max = 32767.0f;
+static const float c_unorm16_max = 65535.0f;
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Build the 8-byte vertices of a frame.  Positions are fixed point on a half pixel grid, which the traced curves lie
+// on, so they normally come back exactly; UVs span the frame's UV bounds in unorm16.
+// Note: Call after set_texture_coordinates
+void quantise_vertices(shrinkwrap * sw)
+{
+        array * verts = sw->vertices;
+        size_t count = array_size(verts);
+        vert min = {0.f, 0.f, 0.f, 0.f};
+        vert max = {0.f, 0.f, 0.f, 0.f};
+        float magnitude = 0.f;
+        for (size_t i = 0; i < count; i++) {
+                vertp v = get_vert(verts, i);
+                if (i == 0 || v->u < min.u) min.u = v->u;
+                if (i == 0 || v->v < min.v) min.v = v->v;
+                if (i == 0 || v->u > max.u) max.u = v->u;
+                if (i == 0 || v->v > max.v) max.v = v->v;
+                magnitude = fmaxf(magnitude, fmaxf(fabsf(v->x), fabsf(v->y)));
+        }
+        vertex_quantisation * q = &sw->quantisation;
+        q->scale.x = q->scale.y = position_scale(magnitude);
+        q->bias.x = q->bias.y = 0.f;
+        q->scale.u = (max.u - min.u) / c_unorm16_max;
+        q->scale.v = (max.v - min.v) / c_unorm16_max;
+        q->bias.u = min.u;
+        q->bias.v = min.v;
+        memset(&q->maxError, 0, sizeof(vert));
+        if (sw->quantisedVertices) {
+                array_destroy(sw->quantisedVertices);
+        }
+        sw->quantisedVertices = array_create(count > 0 ? count : 1, sizeof(quantised_vert));
+        for (size_t i = 0; i < count; i++) {
+                vertp v = get_vert(verts, i);
+                quantised_vert * out = (quantised_vert *)array_push(sw->quantisedVertices);
+                out->x = (int16_t)lrintf(v->x / q->scale.x);
+                out->y = (int16_t)lrintf(v->y / q->scale.y);
+                out->u = (q->scale.u > 0.f) ? (uint16_t)lrintf((v->u - q->bias.u) / q->scale.u) : 0;
+                out->v = (q->scale.v > 0.f) ? (uint16_t)lrintf((v->v - q->bias.v) / q->scale.v) : 0;
+                vert back = dequantise_vertex(q, out);
+                q->maxError.x = fmaxf(q->maxError.x, fabsf(back.x - v->x));
+                q->maxError.y = fmaxf(q->maxError.y, fabsf(back.y - v->y));
+                q->maxError.u = fmaxf(q->maxError.u, fabsf(back.u - v->u));
+                q->maxError.v = fmaxf(q->maxError.v, fabsf(back.v - v->v));
+        }
+        sw->vertexFormat = VERTEX_FORMAT_QUANTISED;
+}
+
+vert dequantise_vertex(const vertex_quantisation * quantisation, const quantised_vert * q)
+{
+        vert v;
+        v.x = (float)q->x * quantisation->scale.x + quantisation->bias.x;
+        v.y = (float)q->y * quantisation->scale.y + quantisation->bias.y;
+        v.u = (float)q->u * quantisation->scale.u + quantisation->bias.u;
+        v.v = (float)q->v * quantisation->scale.v + quantisation->bias.v;
+        return v;
+}
+
+// The positions stay as they are, and writers leave out the UVs and store the uv_transform instead.
+void drop_texture_coordinates(shrinkwrap * sw)
+{
+        if (sw->vertexFormat == VERTEX_FORMAT_FLOAT) {
+                sw->vertexFormat = VERTEX_FORMAT_POSITION;
+        } else if (sw->vertexFormat == VERTEX_FORMAT_QUANTISED) {
+                sw->vertexFormat = VERTEX_FORMAT_QUANTISED_POSITION;
+        }
+}
+
+vert apply_uv_transform(const uv_transform * transform, float x, float y)
+{
+        vert v = {x, y, x * transform->scaleU + transform->biasU, y * transform->scaleV + transform->biasV};
+        return v;
+}
+
+int vertex_format_is_quantised(vertex_format format)
+{
+        return format == VERTEX_FORMAT_QUANTISED || format == VERTEX_FORMAT_QUANTISED_POSITION;
+}
+
+int vertex_format_has_uvs(vertex_format format)
+{
+        return format == VERTEX_FORMAT_FLOAT || format == VERTEX_FORMAT_QUANTISED;
+}
+
+size_t vertex_format_size(vertex_format format)
+{
+        size_t component = vertex_format_is_quantised(format) ? sizeof(uint16_t) : sizeof(float);
+        return component * (vertex_format_has_uvs(format) ? 4 : 2);
+}
+
+const char * vertex_format_name(vertex_format format)
+{
+        assert((size_t)format < c_vertex_format_count);
+        return c_vertex_format_names[format];
+}
+
+int vertex_format_from_name(const char * name, vertex_format * outFormat)
+{
+        for (size_t i = 0; i < c_vertex_format_count; i++) {
+                if (strcmp(name, c_vertex_format_names[i]) == 0) {
+                        *outFormat = (vertex_format)i;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Smallest power-of-two multiple of the half pixel step that keeps every position within int16.
+float position_scale(float maxMagnitude)
+{
+        float scale = c_position_step;
+        while (maxMagnitude / scale > c_int16_max) {
+                scale *= 2.0f;
+        }
+        return scale;
+}
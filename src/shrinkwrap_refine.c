@@ -0,0 +1,485 @@
+//
+//  shrinkwrap_refine.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include <time.h>
+#include "taskpool.h"
+#include "internal/shrinkwrap_refine_internal.h"
+#include "internal/shrinkwrap_compact_internal.h"
+
+// Evolutionary refinement
+///////////////////////////////////////////////////////////////////////////////
+// Each island runs a (1+1) evolution strategy on its own copy of the mesh: a vertex is moved by a normally
+// distributed step or merged into a neighbour, and the change is kept unless it makes the mesh less fit.  Fitness is
+// the cost of every pixel, by what covers its centre, plus triangleCost for each triangle.  A mutation only redraws
+// the triangles around one vertex, so only the pixels under them are costed again.  Islands run on their own threads
+// for an epoch, then the fittest replaces the others.  Budgets are checked between mutations, so runs limited only by
+// iterations are repeatable.
+
+// Costs in pixels: a visible pixel left out or an opaque triangle over a pixel that is not opaque shows, as does a
+// pixel drawn twice, while blending a pixel that did not need it only costs fill.
+static const float c_missingCost = 16.0f;
+static const float c_opaqueErrorCost = 16.0f;
+static const float c_overlapCost = 16.0f;
+static const float c_blendedZeroCost = 1.0f;
+static const float c_blendedFullCost = 0.5f;
+
+static const size_t c_epochIterations = 512;
+static const float c_collapseRate = 0.25f;
+static const float c_startSigma = 1.0f;
+static const float c_minSigma = 0.05f;
+static const float c_maxSigma = 8.0f;
+// Moves between step size adjustments
+static const size_t c_sigmaWindow = 50;
+static const float c_sigmaScale = 1.22f;
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+static void evolve_refine_island(taskpool * pool, void * context, size_t i);
+
+void refine_shrinkwrap(shrinkwrap * sw, const tpxl * tpixels, pxl_size w, pxl_size h, float shiftY,
+                       const refine_options * options, refine_report * outReport)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && "Refine before building strips");
+        memset(outReport, 0, sizeof(refine_report));
+        // Vertices at the same place must move together
+        compact_vertices(sw);
+        refine_state s;
+        s.tpixels = tpixels;
+        s.width = w;
+        s.height = h;
+        s.shiftY = shiftY;
+        s.triangleCost = options->triangleCost;
+        s.vertexCount = array_size(sw->vertices);
+        s.triangleCount = (array_size(sw->indicesPartialAlpha) + array_size(sw->indicesFullAlpha)) / 3;
+        s.islandCount = (options->threads > 1) ? options->threads : 1;
+        s.islands = (refine_island *)malloc(sizeof(refine_island) * s.islandCount);
+        double start = refine_now_milliseconds();
+        s.deadline = (options->milliseconds > 0.0) ? start + options->milliseconds : 0.0;
+        for (size_t i = 0; i < s.islandCount; i++) {
+                init_refine_island(&s, s.islands + i, sw, options->seed + (uint32_t)i);
+        }
+        outReport->startFitness = s.islands[0].fitness;
+        taskpool * pool = taskpool_create(s.islandCount);
+        size_t done = 0;
+        size_t best = 0;
+        while (s.triangleCount > 0) {
+                if (options->iterations > 0 && done >= options->iterations) break;
+                if (s.deadline > 0.0 && refine_now_milliseconds() >= s.deadline) break;
+                s.epochIterations = c_epochIterations;
+                if (options->iterations > 0 && options->iterations - done < s.epochIterations) {
+                        s.epochIterations = options->iterations - done;
+                }
+                for (size_t i = 0; i < s.islandCount; i++) {
+                        taskpool_submit(pool, evolve_refine_island, &s, i);
+                }
+                taskpool_wait(pool);
+                done += s.epochIterations;
+                // Migrate the fittest island to the rest
+                best = 0;
+                for (size_t i = 1; i < s.islandCount; i++) {
+                        if (s.islands[i].fitness < s.islands[best].fitness) best = i;
+                }
+                for (size_t i = 0; i < s.islandCount; i++) {
+                        if (i != best) copy_refine_island(&s, s.islands + i, s.islands + best);
+                }
+        }
+        taskpool_destroy(pool);
+        const refine_island * island = s.islands + best;
+        outReport->fitness = refine_fitness(&s, island);
+        assert(fabs(outReport->fitness - island->fitness) < 0.01 * (1.0 + fabs(outReport->fitness)) &&
+               "Fitness drifted from the mesh");
+        for (size_t i = 0; i < s.islandCount; i++) {
+                outReport->mutations += s.islands[i].mutations;
+                outReport->accepted += s.islands[i].accepted;
+        }
+        for (size_t v = 0; v < s.vertexCount; v++) {
+                vertp vertex = get_vert(sw->vertices, v);
+                vertex->x = island->positions[v].x;
+                vertex->y = island->positions[v].y;
+        }
+        array_clear(sw->indicesPartialAlpha);
+        array_clear(sw->indicesFullAlpha);
+        for (size_t t = 0; t < s.triangleCount; t++) {
+                const refine_triangle * triangle = island->triangles + t;
+                if (triangle->alive == FALSE) continue;
+                array * indices = triangle->full ? sw->indicesFullAlpha : sw->indicesPartialAlpha;
+                for (int c = 0; c < 3; c++) {
+                        push_index(indices, triangle->corner[c]);
+                }
+        }
+        for (size_t i = 0; i < s.islandCount; i++) {
+                destroy_refine_island(s.islands + i);
+        }
+        free(s.islands);
+        // Drop the vertices merged away
+        compact_vertices(sw);
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+void init_refine_island(refine_state * s, refine_island * island, const shrinkwrap * sw, uint32_t seed)
+{
+        size_t pixels = (size_t)s->width * s->height;
+        island->positions = (vert *)malloc(sizeof(vert) * (s->vertexCount > 0 ? s->vertexCount : 1));
+        island->triangles = (refine_triangle *)malloc(sizeof(refine_triangle) * (s->triangleCount + 1));
+        island->partialCover = (uint16_t *)calloc(pixels + 1, sizeof(uint16_t));
+        island->fullCover = (uint16_t *)calloc(pixels + 1, sizeof(uint16_t));
+        island->affected = (size_t *)malloc(sizeof(size_t) * (s->triangleCount + 1));
+        island->saved = (refine_triangle *)malloc(sizeof(refine_triangle) * (s->triangleCount + 1));
+        for (size_t v = 0; v < s->vertexCount; v++) {
+                island->positions[v] = *get_vert(sw->vertices, v);
+        }
+        size_t t = 0;
+        for (int full = 0; full < 2; full++) {
+                array * indices = full ? sw->indicesFullAlpha : sw->indicesPartialAlpha;
+                for (size_t i = 0; i + 2 < array_size(indices); i += 3) {
+                        refine_triangle * triangle = island->triangles + t++;
+                        for (int c = 0; c < 3; c++) {
+                                triangle->corner[c] = get_index(indices, i + c);
+                        }
+                        float area = refine_triangle_area(island, triangle);
+                        triangle->orientation = (area > 0.0f) ? 1 : -1;
+                        triangle->full = (uint8_t)full;
+                        // Degenerate triangles draw nothing and are dropped
+                        triangle->alive = area != 0.0f;
+                        if (triangle->alive) {
+                                raster_refine_triangle(s, island, triangle, 1);
+                        }
+                }
+        }
+        // xorshift needs a non-zero state
+        island->random = seed * 2654435761u + 1u;
+        if (island->random == 0) island->random = 1;
+        island->sigma = c_startSigma;
+        island->moves = 0;
+        island->movesAccepted = 0;
+        island->mutations = 0;
+        island->accepted = 0;
+        island->fitness = refine_fitness(s, island);
+}
+
+void destroy_refine_island(refine_island * island)
+{
+        free(island->positions);
+        free(island->triangles);
+        free(island->partialCover);
+        free(island->fullCover);
+        free(island->affected);
+        free(island->saved);
+}
+
+// Copy the mesh, coverage and fitness of one island over another, keeping its random state and step size.
+void copy_refine_island(const refine_state * s, refine_island * to, const refine_island * from)
+{
+        size_t pixels = (size_t)s->width * s->height;
+        memcpy(to->positions, from->positions, sizeof(vert) * s->vertexCount);
+        memcpy(to->triangles, from->triangles, sizeof(refine_triangle) * s->triangleCount);
+        memcpy(to->partialCover, from->partialCover, sizeof(uint16_t) * pixels);
+        memcpy(to->fullCover, from->fullCover, sizeof(uint16_t) * pixels);
+        to->fitness = from->fitness;
+}
+
+// Run one island for an epoch, or until the deadline passes.
+static void evolve_refine_island(taskpool * pool, void * context, size_t i)
+{
+        const refine_state * s = (const refine_state *)context;
+        refine_island * island = s->islands + i;
+        for (size_t n = 0; n < s->epochIterations; n++) {
+                if (s->deadline > 0.0 && (n & 31) == 0 && refine_now_milliseconds() >= s->deadline) break;
+                island->mutations++;
+                if (mutate_refine_island(s, island)) {
+                        island->accepted++;
+                }
+        }
+}
+
+// Mutate a corner of a random triangle.  Returns TRUE if the mutation was kept.
+int mutate_refine_island(const refine_state * s, refine_island * island)
+{
+        refine_triangle * triangle = island->triangles + refine_random(island) % s->triangleCount;
+        if (triangle->alive == FALSE) return FALSE;
+        uint32_t pick = refine_random(island);
+        uint32_t v = triangle->corner[pick % 3];
+        // Gather the triangles around the vertex
+        size_t count = 0;
+        for (size_t t = 0; t < s->triangleCount; t++) {
+                const refine_triangle * other = island->triangles + t;
+                if (other->alive && (other->corner[0] == v || other->corner[1] == v || other->corner[2] == v)) {
+                        island->affected[count] = t;
+                        island->saved[count] = *other;
+                        count++;
+                }
+        }
+        if ((float)(refine_random(island) & 0xFFFF) < c_collapseRate * 65536.0f) {
+                uint32_t to = triangle->corner[(pick % 3 + 1 + (pick >> 8) % 2) % 3];
+                return collapse_refine_vertex(s, island, v, to, count);
+        }
+        int accepted = move_refine_vertex(s, island, v, count);
+        island->moves++;
+        island->movesAccepted += accepted ? 1 : 0;
+        if (island->moves == c_sigmaWindow) {
+                if (island->movesAccepted * 5 > island->moves) {
+                        island->sigma *= c_sigmaScale;
+                } else {
+                        island->sigma /= c_sigmaScale;
+                }
+                island->sigma = fminf(fmaxf(island->sigma, c_minSigma), c_maxSigma);
+                island->moves = 0;
+                island->movesAccepted = 0;
+        }
+        return accepted;
+}
+
+// Move a vertex by a normally distributed step, keeping it near the frame and its triangles the right way round.
+int move_refine_vertex(const refine_state * s, refine_island * island, uint32_t v, size_t count)
+{
+        vert old = island->positions[v];
+        float x = old.x + refine_gaussian(island) * island->sigma;
+        float y = old.y + refine_gaussian(island) * island->sigma;
+        if (x < -1.0f || y < -1.0f - s->shiftY || x > (float)s->width + 1.0f ||
+            y > (float)s->height + 1.0f - s->shiftY) {
+                return FALSE;
+        }
+        refine_bounds bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        for (size_t i = 0; i < count; i++) {
+                refine_triangle_bounds(island, island->triangles + island->affected[i], &bounds);
+        }
+        island->positions[v].x = x;
+        island->positions[v].y = y;
+        int valid = TRUE;
+        for (size_t i = 0; i < count; i++) {
+                const refine_triangle * triangle = island->triangles + island->affected[i];
+                float area = refine_triangle_area(island, triangle);
+                if (area * (float)triangle->orientation <= 0.0f) valid = FALSE;
+                refine_triangle_bounds(island, triangle, &bounds);
+        }
+        island->positions[v] = old;
+        if (valid == FALSE) return FALSE;
+        double before = refine_region_cost(s, island, &bounds);
+        for (size_t i = 0; i < count; i++) {
+                raster_refine_triangle(s, island, island->saved + i, -1);
+        }
+        island->positions[v].x = x;
+        island->positions[v].y = y;
+        for (size_t i = 0; i < count; i++) {
+                raster_refine_triangle(s, island, island->triangles + island->affected[i], 1);
+        }
+        double after = refine_region_cost(s, island, &bounds);
+        int accept = after <= before;
+        if (accept) {
+                island->fitness += after - before;
+        } else {
+                for (size_t i = 0; i < count; i++) {
+                        raster_refine_triangle(s, island, island->triangles + island->affected[i], -1);
+                }
+                island->positions[v] = old;
+                for (size_t i = 0; i < count; i++) {
+                        raster_refine_triangle(s, island, island->saved + i, 1);
+                }
+        }
+        return accept;
+}
+
+// Merge a vertex into a neighbour, dropping the triangles between them.
+int collapse_refine_vertex(const refine_state * s, refine_island * island, uint32_t v, uint32_t to, size_t count)
+{
+        refine_bounds bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        size_t dropped = 0;
+        for (size_t i = 0; i < count; i++) {
+                refine_triangle * triangle = island->triangles + island->affected[i];
+                refine_triangle_bounds(island, triangle, &bounds);
+                int shared = FALSE;
+                for (int c = 0; c < 3; c++) {
+                        shared = shared || triangle->corner[c] == to;
+                }
+                for (int c = 0; c < 3; c++) {
+                        if (triangle->corner[c] == v) triangle->corner[c] = to;
+                }
+                if (shared) {
+                        triangle->alive = FALSE;
+                        dropped++;
+                } else if (refine_triangle_area(island, triangle) * (float)triangle->orientation <= 0.0f) {
+                        for (size_t j = 0; j <= i; j++) {
+                                island->triangles[island->affected[j]] = island->saved[j];
+                        }
+                        return FALSE;
+                }
+        }
+        // The remaining triangles lie within the ones they replace
+        double before = refine_region_cost(s, island, &bounds);
+        for (size_t i = 0; i < count; i++) {
+                raster_refine_triangle(s, island, island->saved + i, -1);
+        }
+        for (size_t i = 0; i < count; i++) {
+                const refine_triangle * triangle = island->triangles + island->affected[i];
+                if (triangle->alive) raster_refine_triangle(s, island, triangle, 1);
+        }
+        double after = refine_region_cost(s, island, &bounds) - (double)s->triangleCost * (double)dropped;
+        int accept = after <= before;
+        if (accept) {
+                island->fitness += after - before;
+        } else {
+                for (size_t i = 0; i < count; i++) {
+                        const refine_triangle * triangle = island->triangles + island->affected[i];
+                        if (triangle->alive) raster_refine_triangle(s, island, triangle, -1);
+                }
+                for (size_t i = 0; i < count; i++) {
+                        island->triangles[island->affected[i]] = island->saved[i];
+                        raster_refine_triangle(s, island, island->saved + i, 1);
+                }
+        }
+        return accept;
+}
+
+// Pixel costs of the whole mesh plus the cost of its triangles
+double refine_fitness(const refine_state * s, const refine_island * island)
+{
+        refine_bounds all = {-INFINITY, -INFINITY, INFINITY, INFINITY};
+        double fitness = refine_region_cost(s, island, &all);
+        for (size_t t = 0; t < s->triangleCount; t++) {
+                if (island->triangles[t].alive) fitness += s->triangleCost;
+        }
+        return fitness;
+}
+
+double refine_region_cost(const refine_state * s, const refine_island * island, const refine_bounds * bounds)
+{
+        double cost = 0.0;
+        pixel_rect rect;
+        if (refine_pixel_rect(s, bounds, &rect) == FALSE) return cost;
+        for (pxl_pos y = rect.y; y < rect.y + (pxl_pos)rect.h; y++) {
+                size_t row = (size_t)y * s->width;
+                for (pxl_pos x = rect.x; x < rect.x + (pxl_pos)rect.w; x++) {
+                        alpha a = (alpha)(s->tpixels[row + x] & ALPHA_ANYALPHA);
+                        cost += refine_pixel_cost(a, island->partialCover[row + x], island->fullCover[row + x]);
+                }
+        }
+        return cost;
+}
+
+float refine_pixel_cost(alpha a, uint32_t partial, uint32_t full)
+{
+        uint32_t cover = partial + full;
+        if (cover == 0) return (a == ALPHA_ZERO) ? 0.0f : c_missingCost;
+        float cost = (float)(cover - 1) * c_overlapCost;
+        if (full > 0) return cost + ((a == ALPHA_FULL) ? 0.0f : c_opaqueErrorCost);
+        if (a == ALPHA_ZERO) return cost + c_blendedZeroCost;
+        return cost + ((a == ALPHA_FULL) ? c_blendedFullCost : 0.0f);
+}
+
+// Add (delta 1) or remove (delta -1) a triangle from the coverage of the pixels whose centres it holds.  Centres on
+// an edge belong to the triangle on one side only, so triangles sharing an edge never both cover a pixel.
+void raster_refine_triangle(const refine_state * s, refine_island * island, const refine_triangle * t, int delta)
+{
+        refine_bounds bounds = {INFINITY, INFINITY, -INFINITY, -INFINITY};
+        refine_triangle_bounds(island, t, &bounds);
+        pixel_rect rect;
+        if (refine_pixel_rect(s, &bounds, &rect) == FALSE) return;
+        const vert * p[3];
+        for (int c = 0; c < 3; c++) {
+                p[c] = island->positions + t->corner[(t->orientation > 0) ? c : 2 - c];
+        }
+        uint16_t * cover = t->full ? island->fullCover : island->partialCover;
+        for (pxl_pos y = rect.y; y < rect.y + (pxl_pos)rect.h; y++) {
+                float sy = (float)y + 0.5f - s->shiftY;
+                for (pxl_pos x = rect.x; x < rect.x + (pxl_pos)rect.w; x++) {
+                        float sx = (float)x + 0.5f;
+                        int inside = TRUE;
+                        for (int c = 0; c < 3 && inside; c++) {
+                                const vert * a = p[c];
+                                const vert * b = p[(c + 1) % 3];
+                                float dx = b->x - a->x;
+                                float dy = b->y - a->y;
+                                float edge = dx * (sy - a->y) - dy * (sx - a->x);
+                                inside = edge > 0.0f || (edge == 0.0f && (dy > 0.0f || (dy == 0.0f && dx > 0.0f)));
+                        }
+                        if (inside) {
+                                cover[(size_t)y * s->width + x] += (uint16_t)delta;
+                        }
+                }
+        }
+}
+
+void refine_triangle_bounds(const refine_island * island, const refine_triangle * t, refine_bounds * inOutBounds)
+{
+        for (int c = 0; c < 3; c++) {
+                const vert * p = island->positions + t->corner[c];
+                inOutBounds->minX = fminf(inOutBounds->minX, p->x);
+                inOutBounds->maxX = fmaxf(inOutBounds->maxX, p->x);
+                inOutBounds->minY = fminf(inOutBounds->minY, p->y);
+                inOutBounds->maxY = fmaxf(inOutBounds->maxY, p->y);
+        }
+}
+
+// Find the pixels of the frame whose centres lie within bounds.  Returns FALSE if there are none.
+int refine_pixel_rect(const refine_state * s, const refine_bounds * bounds, pixel_rect * outRect)
+{
+        float x0 = fmaxf(ceilf(bounds->minX - 0.5f), 0.0f);
+        float y0 = fmaxf(ceilf(bounds->minY - 0.5f + s->shiftY), 0.0f);
+        float x1 = fminf(floorf(bounds->maxX - 0.5f), (float)s->width - 1.0f);
+        float y1 = fminf(floorf(bounds->maxY - 0.5f + s->shiftY), (float)s->height - 1.0f);
+        if (x0 > x1 || y0 > y1) return FALSE;
+        outRect->x = (pxl_pos)x0;
+        outRect->y = (pxl_pos)y0;
+        outRect->w = (pxl_size)(x1 - x0) + 1;
+        outRect->h = (pxl_size)(y1 - y0) + 1;
+        return TRUE;
+}
+
+// Twice the signed area, positive clockwise on screen
+float refine_triangle_area(const refine_island * island, const refine_triangle * t)
+{
+        const vert * a = island->positions + t->corner[0];
+        const vert * b = island->positions + t->corner[1];
+        const vert * c = island->positions + t->corner[2];
+        return (b->x - a->x) * (c->y - a->y) - (b->y - a->y) * (c->x - a->x);
+}
+
+// xorshift32
+uint32_t refine_random(refine_island * island)
+{
+        uint32_t x = island->random;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        island->random = x;
+        return x;
+}
+
+// Box-Muller
+float refine_gaussian(refine_island * island)
+{
+        float u = ((float)(refine_random(island) >> 8) + 1.0f) / 16777217.0f;
+        float v = (float)(refine_random(island) >> 8) / 16777216.0f;
+        return sqrtf(-2.0f * logf(u)) * cosf(6.28318531f * v);
+}
+
+double refine_now_milliseconds(void)
+{
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return (double)now.tv_sec * 1000.0 + (double)now.tv_nsec / 1000000.0;
+}
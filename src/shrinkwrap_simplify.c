@@ -0,0 +1,320 @@
+//
+//  shrinkwrap_simplify.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_curve_internal.h"
+#include "internal/shrinkwrap_simplify_internal.h"
+
+// Tolerance contract
+///////////////////////////////////////////////////////////////////////////////
+// Every simplifier removes points by replacing a run of a curve with a straight chord between two kept points.  The
+// chord is accepted only if, at each point it replaces:
+// 1) it is no more than 'bleed' pixels from the original point along the x-axis,
+// 2) it only moves the edge in the direction conserve_direction allows (CONSERVE_LEFT lets the region on the left
+//    grow, CONSERVE_RIGHT the region on the right), and
+// 3) it stays between the neighbouring curves on that scanline (see limit_point).
+// Points marked PRESERVE_DONOTREMOVE and curve endings are never removed.
+
+static const char * const c_simplifier_names[] = {"shrinkwrap", "douglas-peucker", "visvalingam-whyatt",
+        "reumann-witkam"};
+static const size_t c_simplifier_count = sizeof(c_simplifier_names) / sizeof(c_simplifier_names[0]);
+
+const char * simplifier_name(simplifier method)
+{
+        assert((size_t)method < c_simplifier_count);
+        return c_simplifier_names[method];
+}
+
+int simplifier_from_name(const char * name, simplifier * outMethod)
+{
+        for (size_t i = 0; i < c_simplifier_count; i++) {
+                if (strcmp(name, c_simplifier_names[i]) == 0) {
+                        *outMethod = (simplifier)i;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Find the x position of the chord from a to b at scanline y.
+float chord_x(const CP * a, const CP * b, float y)
+{
+        const vert * va = &a->vertex;
+        const vert * vb = &b->vertex;
+        assert(vb->y > va->y);
+        return va->x + (vb->x - va->x) * (y - va->y) / (vb->y - va->y);
+}
+
+// Determine if the chord from a to b may replace point p.
+int chord_allowed(const C * c, const CP * a, const CP * b, CP * p, float w, float bleed)
+{
+        float x = p->vertex.x;
+        float newx = chord_x(a, b, p->vertex.y);
+        float diff = newx - x;
+        if (fabsf(diff) > bleed) return FALSE;
+        conserve dir = conserve_direction(p->scanlineList, c);
+        if (dir == CONSERVE_LEFT && diff < 0.0f) return FALSE;
+        if (dir == CONSERVE_RIGHT && diff > 0.0f) return FALSE;
+        return limit_point(newx, p, w) == newx;
+}
+
+// Determine if the chord from a to b may replace every point between them.
+int span_allowed(const C * c, const CP * a, const CP * b, float w, float bleed)
+{
+        CP * p = a->next;
+        while (p != b) {
+                assert(p != NULL && "Span end does not follow span start on curve");
+                if (chord_allowed(c, a, b, p, w, bleed) == FALSE) return FALSE;
+                p = p->next;
+        }
+        return TRUE;
+}
+
+// Curve endings and protected points are kept by every simplifier.
+int is_fixed_point(CP ** points, size_t count, size_t i)
+{
+        return i == 0 || i == count - 1 || points[i]->preserve == PRESERVE_DONOTREMOVE;
+}
+
+// Mark all points strictly between first and last for removal.
+void remove_span(CP ** points, size_t first, size_t last)
+{
+        for (size_t i = first + 1; i < last; i++) {
+                assert(points[i]->preserve != PRESERVE_DONOTREMOVE);
+                points[i]->preserve = PRESERVE_WILLREMOVE;
+        }
+}
+
+// Douglas-Peucker
+///////////////////////////////////////////////////////////////////////////////
+// Keep the chord if it honours the contract, otherwise split at the point furthest from it.
+static void douglas_peucker_span(C * c, CP ** points, size_t first, size_t last, float w, float bleed)
+{
+        if (last - first < 2) return;
+        if (span_allowed(c, points[first], points[last], w, bleed)) {
+                remove_span(points, first, last);
+                return;
+        }
+        size_t split = first + 1;
+        float max = -1.0f;
+        for (size_t i = first + 1; i < last; i++) {
+                float diff = fabsf(chord_x(points[first], points[last], points[i]->vertex.y) - points[i]->vertex.x);
+                if (diff > max) {
+                        max = diff;
+                        split = i;
+                }
+        }
+        douglas_peucker_span(c, points, first, split, w, bleed);
+        douglas_peucker_span(c, points, split, last, w, bleed);
+}
+
+void simplify_douglas_peucker(C * c, CP ** points, size_t count, float w, float bleed)
+{
+        size_t first = 0;
+        for (size_t i = 1; i < count; i++) {
+                if (is_fixed_point(points, count, i)) {
+                        douglas_peucker_span(c, points, first, i, w, bleed);
+                        first = i;
+                }
+        }
+}
+
+// Visvalingam-Whyatt
+///////////////////////////////////////////////////////////////////////////////
+// Repeatedly drop the point spanning the smallest triangle with its neighbours, as long as the chord that replaces it
+// honours the contract.  Entries in the heap go stale when a neighbour is removed and are skipped by version.
+typedef struct vw_entry_struct {
+        float area;
+        size_t point;
+        size_t version;
+} vw_entry;
+
+typedef struct vw_state_struct {
+        size_t * prev;
+        size_t * next;
+        size_t * version;
+        vw_entry * heap;
+        size_t heapcount;
+} vw_state;
+
+static void vw_heap_push(vw_state * s, vw_entry e)
+{
+        size_t i = s->heapcount++;
+        s->heap[i] = e;
+        while (i > 0) {
+                size_t parent = (i - 1) / 2;
+                if (s->heap[parent].area <= s->heap[i].area) break;
+                vw_entry t = s->heap[parent];
+                s->heap[parent] = s->heap[i];
+                s->heap[i] = t;
+                i = parent;
+        }
+}
+
+static vw_entry vw_heap_pop(vw_state * s)
+{
+        vw_entry top = s->heap[0];
+        s->heap[0] = s->heap[--s->heapcount];
+        size_t i = 0;
+        while (TRUE) {
+                size_t smallest = i;
+                size_t l = i * 2 + 1;
+                size_t r = l + 1;
+                if (l < s->heapcount && s->heap[l].area < s->heap[smallest].area) smallest = l;
+                if (r < s->heapcount && s->heap[r].area < s->heap[smallest].area) smallest = r;
+                if (smallest == i) break;
+                vw_entry t = s->heap[smallest];
+                s->heap[smallest] = s->heap[i];
+                s->heap[i] = t;
+                i = smallest;
+        }
+        return top;
+}
+
+static float triangle_area(const CP * a, const CP * b, const CP * c)
+{
+        const vert * va = &a->vertex;
+        const vert * vb = &b->vertex;
+        const vert * vc = &c->vertex;
+        return 0.5f * fabsf((vb->x - va->x) * (vc->y - va->y) - (vc->x - va->x) * (vb->y - va->y));
+}
+
+static void vw_consider(vw_state * s, C * c, CP ** points, size_t count, size_t i, float w, float bleed)
+{
+        s->version[i]++;
+        if (is_fixed_point(points, count, i)) return;
+        CP * before = points[s->prev[i]];
+        CP * after = points[s->next[i]];
+        if (span_allowed(c, before, after, w, bleed) == FALSE) return;
+        vw_entry e = {triangle_area(before, points[i], after), i, s->version[i]};
+        vw_heap_push(s, e);
+}
+
+void simplify_visvalingam_whyatt(C * c, CP ** points, size_t count, float w, float bleed)
+{
+        if (count < 3) return;
+        vw_state s;
+        s.prev = (size_t *)malloc(sizeof(size_t) * count);
+        s.next = (size_t *)malloc(sizeof(size_t) * count);
+        s.version = (size_t *)calloc(count, sizeof(size_t));
+        // Every push is the initial one of a point or one of the two that follow each removal, so there are at most
+        // count + 2 * removals <= 3 * count pushes in all.
+        s.heap = (vw_entry *)malloc(sizeof(vw_entry) * count * 3);
+        s.heapcount = 0;
+        for (size_t i = 0; i < count; i++) {
+                s.prev[i] = (i > 0) ? i - 1 : 0;
+                s.next[i] = (i < count - 1) ? i + 1 : i;
+        }
+        for (size_t i = 1; i < count - 1; i++) {
+                vw_consider(&s, c, points, count, i, w, bleed);
+        }
+        while (s.heapcount > 0) {
+                vw_entry e = vw_heap_pop(&s);
+                if (e.version != s.version[e.point]) continue;
+                size_t i = e.point;
+                size_t before = s.prev[i];
+                size_t after = s.next[i];
+                points[i]->preserve = PRESERVE_WILLREMOVE;
+                s.version[i]++;
+                s.next[before] = after;
+                s.prev[after] = before;
+                vw_consider(&s, c, points, count, before, w, bleed);
+                vw_consider(&s, c, points, count, after, w, bleed);
+        }
+        free(s.prev);
+        free(s.next);
+        free(s.version);
+        free(s.heap);
+}
+
+// Reumann-Witkam
+///////////////////////////////////////////////////////////////////////////////
+// Extend a strip along the direction of the first segment from each key point for as long as the points stay within
+// 'bleed' of it and the chord from the key point honours the contract.
+void simplify_reumann_witkam(C * c, CP ** points, size_t count, float w, float bleed)
+{
+        size_t key = 0;
+        while (key + 2 < count) {
+                size_t end = key + 1;
+                if (is_fixed_point(points, count, end) == FALSE) {
+                        CP * a = points[key];
+                        CP * b = points[key + 1];
+                        size_t candidate = key + 2;
+                        while (candidate < count) {
+                                CP * p = points[candidate];
+                                if (fabsf(chord_x(a, b, p->vertex.y) - p->vertex.x) > bleed) break;
+                                if (span_allowed(c, a, p, w, bleed) == FALSE) break;
+                                end = candidate;
+                                if (is_fixed_point(points, count, candidate)) break;
+                                candidate++;
+                        }
+                        remove_span(points, key, end);
+                }
+                key = end;
+        }
+}
+
+// Dispatch
+///////////////////////////////////////////////////////////////////////////////
+// Simplify a curve with the chosen method and unlink the removed points.
+void simplify_curve(C * c, float w, float bleed, simplifier method)
+{
+        if (method == SIMPLIFY_SHRINKWRAP) {
+                size_t remove = 0;
+                do {
+                        remove = smoothCurve(c, w, bleed);
+                } while (remove > 0);
+        } else {
+                size_t count = 0;
+                CP * p = c->pointList;
+                while (p) {
+                        count++;
+                        p = p->next;
+                }
+                CP ** points = (CP **)malloc(sizeof(CP *) * count);
+                count = 0;
+                p = c->pointList;
+                while (p) {
+                        points[count++] = p;
+                        p = p->next;
+                }
+                switch (method) {
+                        case SIMPLIFY_DOUGLAS_PEUCKER:
+                                simplify_douglas_peucker(c, points, count, w, bleed);
+                                break;
+                        case SIMPLIFY_VISVALINGAM_WHYATT:
+                                simplify_visvalingam_whyatt(c, points, count, w, bleed);
+                                break;
+                        case SIMPLIFY_REUMANN_WITKAM:
+                                simplify_reumann_witkam(c, points, count, w, bleed);
+                                break;
+                        default:
+                                assert(FALSE && "Unknown simplifier");
+                                break;
+                }
+                free(points);
+        }
+        remove_points(c);
+}
@@ -0,0 +1,64 @@
+//
+//  shrinkwrap_stats.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <math.h>
+#include "internal/shrinkwrap_stats_internal.h"
+#include "internal/shrinkwrap_strip_internal.h"
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Measure the pixels each index list fills and count the geometry drawn.
+void measure_shrinkwrap(shrinkwrap * sw, shrinkwrap_stats * outStats)
+{
+        size_t partialTriangles = 0;
+        size_t fullTriangles = 0;
+        outStats->partialFill = index_list_area(sw->vertices, sw->indicesPartialAlpha, sw->primitiveType,
+                                                &partialTriangles);
+        outStats->fullFill = index_list_area(sw->vertices, sw->indicesFullAlpha, sw->primitiveType, &fullTriangles);
+        outStats->triangles = partialTriangles + fullTriangles;
+        outStats->vertices = array_size(sw->vertices);
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Sum the areas of the triangles an index list draws.  This is the fill cost of drawing them, which is more than the
+// area they cover where they overlap.
+double index_list_area(array * vertices, array * indices, primitive mode, size_t * outTriangles)
+{
+        double area = 0.0;
+        size_t position = 0;
+        uint32_t triangle[3];
+        *outTriangles = 0;
+        while (next_triangle(indices, mode, &position, triangle)) {
+                const vert * a = get_vert(vertices, triangle[0]);
+                const vert * b = get_vert(vertices, triangle[1]);
+                const vert * c = get_vert(vertices, triangle[2]);
+                double cross = ((double)b->x - a->x) * ((double)c->y - a->y) -
+                               ((double)c->x - a->x) * ((double)b->y - a->y);
+                area += fabs(cross) * 0.5;
+                (*outTriangles)++;
+        }
+        return area;
+}
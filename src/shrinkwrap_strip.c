@@ -0,0 +1,338 @@
+//
+//  shrinkwrap_strip.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "internal/shrinkwrap_strip_internal.h"
+
+// Stripification
+///////////////////////////////////////////////////////////////////////////////
+// Triangle lists are converted to strips greedily: each strip starts at the remaining triangle with the fewest
+// remaining neighbours, is grown from each of its three edges in turn and the longest is kept.  Strips swap to follow
+// the fans triangulate produces.  A strip only takes a
+// neighbour whose winding agrees with the strip's alternating order, so every triangle keeps the winding triangulate
+// gave it.  Strips are joined by degenerate triangles or by the primitive restart index.
+
+typedef struct strip_edge_struct {
+        uint32_t low;
+        uint32_t high;
+        uint32_t triangle;
+        uint32_t edge;
+} strip_edge;
+
+static const char * const c_primitive_names[] = {"triangles", "strip-degenerate", "strip-restart"};
+static const size_t c_primitive_count = sizeof(c_primitive_names) / sizeof(c_primitive_names[0]);
+
+// Exposed functions
+///////////////////////////////////////////////////////////////////////////////
+// Replace both index lists of the shrinkwrap with strips, unless the strips would need more indices.
+void stripify(shrinkwrap * sw, primitive mode)
+{
+        assert(sw->primitiveType == PRIMITIVE_TRIANGLES && "Geometry is already stripped");
+        if (mode == PRIMITIVE_TRIANGLES) return;
+        array * full = stripify_indices(sw->indicesFullAlpha, mode);
+        array * partial = stripify_indices(sw->indicesPartialAlpha, mode);
+        size_t listCount = array_size(sw->indicesFullAlpha) + array_size(sw->indicesPartialAlpha);
+        size_t stripCount = array_size(full) + array_size(partial);
+        if (stripCount >= listCount) {
+                array_destroy(full);
+                array_destroy(partial);
+                return;
+        }
+        array_destroy(sw->indicesFullAlpha);
+        array_destroy(sw->indicesPartialAlpha);
+        sw->indicesFullAlpha = full;
+        sw->indicesPartialAlpha = partial;
+        sw->primitiveType = mode;
+}
+
+const char * primitive_name(primitive mode)
+{
+        assert((size_t)mode < c_primitive_count);
+        return c_primitive_names[mode];
+}
+
+int primitive_from_name(const char * name, primitive * outMode)
+{
+        for (size_t i = 0; i < c_primitive_count; i++) {
+                if (strcmp(name, c_primitive_names[i]) == 0) {
+                        *outMode = (primitive)i;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
+// Step through the triangles an index list draws, skipping the degenerate triangles and restarts that join strips.
+// Strip triangles are returned in strip order, so odd ones are wound backwards.  Returns FALSE after the last.
+int next_triangle(array * indices, primitive mode, size_t * inOutPosition, uint32_t * outTriangle)
+{
+        size_t count = array_size(indices);
+        if (mode == PRIMITIVE_TRIANGLES) {
+                assert((count % 3) == 0 && "Indices not divisible by 3!");
+                if (*inOutPosition + 3 > count) return FALSE;
+                for (int i = 0; i < 3; i++) {
+                        outTriangle[i] = get_index(indices, *inOutPosition + i);
+                }
+                *inOutPosition += 3;
+                return TRUE;
+        }
+        while (*inOutPosition + 2 < count) {
+                for (int i = 0; i < 3; i++) {
+                        outTriangle[i] = get_index(indices, *inOutPosition + i);
+                }
+                (*inOutPosition)++;
+                if (outTriangle[0] == shrinkwrap_restart_index || outTriangle[1] == shrinkwrap_restart_index ||
+                    outTriangle[2] == shrinkwrap_restart_index) continue;
+                if (outTriangle[0] == outTriangle[1] || outTriangle[1] == outTriangle[2] ||
+                    outTriangle[2] == outTriangle[0]) continue;
+                return TRUE;
+        }
+        return FALSE;
+}
+
+// Internal functions
+///////////////////////////////////////////////////////////////////////////////
+// Convert a triangle list to a single strip in a new array.
+array * stripify_indices(array * indices, primitive mode)
+{
+        size_t count = array_size(indices);
+        assert(count % 3 == 0 && "Indices not divisible by 3!");
+        array * out = array_create(count > 0 ? count : 1, array_stride(indices));
+        if (count == 0) return out;
+        uint32_t * source = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        for (size_t i = 0; i < count; i++) {
+                source[i] = get_index(indices, i);
+        }
+        strip_builder builder;
+        builder.indices = source;
+        builder.triangles = count / 3;
+        builder.adjacent = (uint32_t *)malloc(sizeof(uint32_t) * count);
+        builder.used = (uch *)calloc(builder.triangles, sizeof(uch));
+        builder.trial = (uint32_t *)calloc(builder.triangles, sizeof(uint32_t));
+        builder.attempt = 0;
+        build_adjacency(&builder);
+        array * strip = array_create(64, sizeof(uint32_t));
+        uint32_t start = choose_strip_start(&builder);
+        while (start != c_no_triangle) {
+                int best = 0;
+                size_t bestLength = 0;
+                size_t bestIndices = 0;
+                for (int rotation = 0; rotation < 3; rotation++) {
+                        builder.attempt++;
+                        array_clear(strip);
+                        size_t length = grow_strip(&builder, start, rotation, strip, FALSE);
+                        size_t indices = array_size(strip);
+                        if (length > bestLength || (length == bestLength && indices < bestIndices)) {
+                                best = rotation;
+                                bestLength = length;
+                                bestIndices = indices;
+                        }
+                }
+                array_clear(strip);
+                grow_strip(&builder, start, best, strip, TRUE);
+                join_strip(out, (const uint32_t *)array_get(strip, 0), array_size(strip), mode);
+                start = choose_strip_start(&builder);
+        }
+        array_destroy(strip);
+        free(source);
+        free(builder.adjacent);
+        free(builder.used);
+        free(builder.trial);
+        return out;
+}
+
+static int compare_strip_edges(const void * a, const void * b)
+{
+        const strip_edge * ea = (const strip_edge *)a;
+        const strip_edge * eb = (const strip_edge *)b;
+        if (ea->low != eb->low) return (ea->low < eb->low) ? -1 : 1;
+        if (ea->high != eb->high) return (ea->high < eb->high) ? -1 : 1;
+        return (ea->triangle < eb->triangle) ? -1 : (ea->triangle > eb->triangle);
+}
+
+// Pair up triangles sharing an edge.  Edges shared by more than two triangles are left unconnected.
+void build_adjacency(strip_builder * builder)
+{
+        size_t count = builder->triangles * 3;
+        strip_edge * edges = (strip_edge *)malloc(sizeof(strip_edge) * count);
+        for (size_t i = 0; i < count; i++) {
+                uint32_t a = builder->indices[i];
+                uint32_t b = builder->indices[(i % 3 == 2) ? i - 2 : i + 1];
+                edges[i].low = (a < b) ? a : b;
+                edges[i].high = (a < b) ? b : a;
+                edges[i].triangle = (uint32_t)(i / 3);
+                edges[i].edge = (uint32_t)(i % 3);
+                builder->adjacent[i] = c_no_triangle;
+        }
+        qsort(edges, count, sizeof(strip_edge), compare_strip_edges);
+        size_t i = 0;
+        while (i < count) {
+                size_t run = 1;
+                while (i + run < count && edges[i + run].low == edges[i].low && edges[i + run].high == edges[i].high) {
+                        run++;
+                }
+                if (run == 2 && edges[i].triangle != edges[i + 1].triangle) {
+                        builder->adjacent[edges[i].triangle * 3 + edges[i].edge] = edges[i + 1].triangle;
+                        builder->adjacent[edges[i + 1].triangle * 3 + edges[i + 1].edge] = edges[i].triangle;
+                }
+                i += run;
+        }
+        free(edges);
+}
+
+// Find the triangle across the edge between vertices a and b of the triangle provided.
+uint32_t find_adjacent(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b)
+{
+        const uint32_t * v = builder->indices + triangle * 3;
+        for (int e = 0; e < 3; e++) {
+                uint32_t v1 = v[e];
+                uint32_t v2 = v[(e + 1) % 3];
+                if ((v1 == a && v2 == b) || (v1 == b && v2 == a)) {
+                        return builder->adjacent[triangle * 3 + e];
+                }
+        }
+        return c_no_triangle;
+}
+
+// Find the vertex of the triangle that is not on the edge between vertices a and b.
+uint32_t opposite_vertex(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b)
+{
+        const uint32_t * v = builder->indices + triangle * 3;
+        for (int i = 0; i < 3; i++) {
+                if (v[i] != a && v[i] != b) return v[i];
+        }
+        assert(FALSE && "Triangle is degenerate");
+        return v[0];
+}
+
+// Determine if the triangle lists its vertices in the cyclic order a, b, c.
+int winding_matches(const strip_builder * builder, uint32_t triangle, uint32_t a, uint32_t b, uint32_t c)
+{
+        const uint32_t * v = builder->indices + triangle * 3;
+        for (int r = 0; r < 3; r++) {
+                if (v[r] == a && v[(r + 1) % 3] == b && v[(r + 2) % 3] == c) return TRUE;
+        }
+        return FALSE;
+}
+
+// Determine if a triangle is free to join the strip being grown.
+static int strip_can_take(const strip_builder * builder, uint32_t triangle, int commit)
+{
+        if (triangle == c_no_triangle || builder->used[triangle]) return FALSE;
+        return commit || builder->trial[triangle] != builder->attempt;
+}
+
+static void strip_take(strip_builder * builder, uint32_t triangle, int commit)
+{
+        if (commit) {
+                builder->used[triangle] = TRUE;
+        } else {
+                builder->trial[triangle] = builder->attempt;
+        }
+}
+
+// Grow a strip into 'strip' from a triangle, starting with the edge after the given rotation.  Unless committed, the
+// strip is only measured and its triangles are marked for the current attempt.  Returns the number of triangles.
+// The strip continues across the edge between its last two vertices.  Failing that it swaps - repeats the vertex
+// before the last to pivot around it - and continues across the edge between that vertex and the last.
+size_t grow_strip(strip_builder * builder, uint32_t triangle, int rotation, array * strip, int commit)
+{
+        const uint32_t * v = builder->indices + triangle * 3;
+        push_index(strip, v[rotation]);
+        push_index(strip, v[(rotation + 1) % 3]);
+        push_index(strip, v[(rotation + 2) % 3]);
+        strip_take(builder, triangle, commit);
+        size_t length = 1;
+        while (TRUE) {
+                size_t n = array_size(strip);
+                uint32_t a = get_index(strip, n - 3);
+                uint32_t b = get_index(strip, n - 2);
+                uint32_t c = get_index(strip, n - 1);
+                int swap = FALSE;
+                uint32_t next = find_adjacent(builder, triangle, b, c);
+                if (strip_can_take(builder, next, commit) == FALSE) {
+                        next = find_adjacent(builder, triangle, a, c);
+                        if (strip_can_take(builder, next, commit) == FALSE) break;
+                        swap = TRUE;
+                        b = a;
+                }
+                uint32_t r = opposite_vertex(builder, next, b, c);
+                // Strip triangle k is (k, k + 1, k + 2) when k is even and (k + 1, k, k + 2) when odd
+                size_t k = swap ? n - 1 : n - 2;
+                int odd = (k % 2) == 1;
+                if (winding_matches(builder, next, odd ? c : b, odd ? b : c, r) == FALSE) break;
+                if (swap) {
+                        // a, b, c becomes a, b, a, c: a degenerate triangle, then the last triangle again
+                        set_index(strip, n - 1, a);
+                        push_index(strip, c);
+                }
+                push_index(strip, r);
+                strip_take(builder, next, commit);
+                triangle = next;
+                length++;
+        }
+        return length;
+}
+
+// Pick the remaining triangle with the fewest remaining neighbours, or c_no_triangle if all are stripped.
+uint32_t choose_strip_start(const strip_builder * builder)
+{
+        uint32_t best = c_no_triangle;
+        int bestNeighbours = 4;
+        for (uint32_t t = 0; t < builder->triangles; t++) {
+                if (builder->used[t]) continue;
+                int neighbours = 0;
+                for (int e = 0; e < 3; e++) {
+                        uint32_t n = builder->adjacent[t * 3 + e];
+                        if (n != c_no_triangle && builder->used[n] == FALSE) neighbours++;
+                }
+                if (neighbours < bestNeighbours) {
+                        best = t;
+                        bestNeighbours = neighbours;
+                        if (neighbours == 0) break;
+                }
+        }
+        return best;
+}
+
+// Append a strip to the output, keeping its first triangle on an even position.
+void join_strip(array * out, const uint32_t * strip, size_t count, primitive mode)
+{
+        size_t size = array_size(out);
+        if (size > 0) {
+                if (mode == PRIMITIVE_STRIP_RESTART) {
+                        push_index(out, shrinkwrap_restart_index);
+                } else {
+                        uint32_t last = get_index(out, size - 1);
+                        push_index(out, last);
+                        push_index(out, strip[0]);
+                        if (array_size(out) % 2 == 1) {
+                                push_index(out, strip[0]);
+                        }
+                }
+        }
+        for (size_t i = 0; i < count; i++) {
+                push_index(out, strip[i]);
+        }
+}
@@ -24,6 +24,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <assert.h>
 #include "array.h"
 
 struct vert_struct {
@@ -35,23 +36,214 @@ struct vert_struct {
 typedef struct vert_struct vert;
 typedef vert * vertp;
 
+// How the index lists of a shrinkwrap are drawn
+typedef enum primitive_enum {
+        PRIMITIVE_TRIANGLES,
+        // One triangle strip per list, joined by degenerate triangles
+        PRIMITIVE_STRIP_DEGENERATE,
+        // One triangle strip per list, joined by shrinkwrap_restart_index
+        PRIMITIVE_STRIP_RESTART,
+        PRIMITIVE_COUNT
+} primitive;
+
+// How a frame is drawn, chosen by choose_mesh
+typedef enum mesh_choice_enum {
+        // The frame rectangle as two blended triangles
+        MESH_QUAD,
+        // The partial and full alpha regions drawn together, all blended
+        MESH_HULL,
+        // Partial alpha blended and full alpha opaque
+        MESH_SPLIT,
+        MESH_COUNT
+} mesh_choice;
+
+// Bytes per index in the index lists of a shrinkwrap
+typedef enum index_width_enum {
+        INDEX_WIDTH_16 = 2,
+        INDEX_WIDTH_32 = 4
+} index_width;
+
+// Layout of the vertices a shrinkwrap is written out with
+typedef enum vertex_format_enum {
+        // 16 bytes: float positions and UVs
+        VERTEX_FORMAT_FLOAT,
+        // 8 bytes: int16 positions and unorm16 UVs, see quantised_vert
+        VERTEX_FORMAT_QUANTISED,
+        // 8 bytes: float positions; UVs come from the shrinkwrap's uv_transform
+        VERTEX_FORMAT_POSITION,
+        // 4 bytes: the int16 positions of quantised_vert; UVs come from the uv_transform
+        VERTEX_FORMAT_QUANTISED_POSITION,
+        VERTEX_FORMAT_COUNT
+} vertex_format;
+
+typedef struct quantised_vert_struct {
+        int16_t x;
+        int16_t y;
+        uint16_t u;
+        uint16_t v;
+} quantised_vert;
+
+// Each component dequantises as quantised * scale + bias
+typedef struct vertex_quantisation_struct {
+        vert scale;
+        vert bias;
+        // Largest difference between a float vertex and its dequantised value, per component
+        vert maxError;
+} vertex_quantisation;
+
+// UVs as an affine function of positions: u = x * scaleU + biasU and v = y * scaleV + biasV.  Moving a frame to
+// another place or atlas only changes the biases and scales.
+typedef struct uv_transform_struct {
+        float scaleU;
+        float scaleV;
+        float biasU;
+        float biasV;
+} uv_transform;
+
+// Read back from either width of index list as 0xFFFFFFFF; stored as 0xFFFF in 16-bit lists.
+static const uint32_t shrinkwrap_restart_index = 0xFFFFFFFF;
+static const uint32_t shrinkwrap_restart_index16 = 0xFFFF;
+
 typedef struct shrinkwrap_struct {
         array * vertices;
         array * indicesPartialAlpha;
         array * indicesFullAlpha;
+        primitive primitiveType;
+        mesh_choice meshType;
+        // 16-bit when there are fewer than 65536 vertices, leaving 0xFFFF free for the restart index
+        index_width indexWidth;
+        vertex_format vertexFormat;
+        // Filled by quantise_vertices, otherwise NULL
+        array * quantisedVertices;
+        vertex_quantisation quantisation;
+        // Filled by set_texture_coordinates
+        uv_transform uvTransform;
         float origX;
         float origY;
 } shrinkwrap;
 
+// Curve simplification methods for smooth_curves_ex.  All of them honour the same tolerance, conserve direction and
+// preserved points.
+typedef enum simplifier_enum {
+        SIMPLIFY_SHRINKWRAP,
+        SIMPLIFY_DOUGLAS_PEUCKER,
+        SIMPLIFY_VISVALINGAM_WHYATT,
+        SIMPLIFY_REUMANN_WITKAM,
+        SIMPLIFY_COUNT
+} simplifier;
+
+// Settings for smooth_curves_ex
+typedef struct smooth_options_struct {
+        // Worker threads for smoothing; 0 or 1 smooths serially
+        size_t threads;
+        simplifier method;
+} smooth_options;
+
+// Triangulation engines for triangulate_ex
+typedef enum triangulation_enum {
+        // Zip down the left and right curves of each region, retrying where the edge would cross a curve
+        TRIANGULATE_ZIPPER,
+        // Sweep each region as a y-monotone polygon
+        TRIANGULATE_MONOTONE,
+        TRIANGULATE_COUNT
+} triangulation;
+
+// Front ends that find the borders between alpha types
+typedef enum mesh_engine_enum {
+        // y-monotone curves from build_curves, triangulated by a triangulation engine
+        ENGINE_SCANLINE,
+        // Closed contours from trace_contours, ear clipped by triangulate_contours
+        ENGINE_CONTOUR,
+        // Regions divided until each is one convex hull, from decompose_hulls
+        ENGINE_HULL,
+        ENGINE_COUNT
+} mesh_engine;
+
+// Relative cost of drawing on a device: per vertex transformed and per pixel filled blended or opaque
+typedef struct device_profile_struct {
+        const char * name;
+        float vertexCost;
+        float blendedPixelCost;
+        float opaquePixelCost;
+} device_profile;
+
+// Geometry drawn by a shrinkwrap, from measure_shrinkwrap
+typedef struct shrinkwrap_stats_struct {
+        // Pixels filled drawing indicesPartialAlpha and indicesFullAlpha: the summed areas of their triangles.  Where
+        // triangles overlap, as scanline meshes' can, the overlap is counted once per triangle, as it is filled.
+        double partialFill;
+        double fullFill;
+        size_t triangles;
+        size_t vertices;
+} shrinkwrap_stats;
+
+// Settings for refine_shrinkwrap.  Refinement stops at whichever budget runs out first.
+typedef struct refine_options_struct {
+        // Wall-clock budget per frame; 0 for none
+        double milliseconds;
+        // Mutations tried per island; 0 for no limit
+        size_t iterations;
+        // Islands evolved side by side, one per thread
+        size_t threads;
+        // Fitness cost of a triangle, in misclassified pixels
+        float triangleCost;
+        uint32_t seed;
+} refine_options;
+
+// Outcome of refine_shrinkwrap.  Lower fitness is better.
+typedef struct refine_report_struct {
+        double startFitness;
+        double fitness;
+        size_t mutations;
+        size_t accepted;
+} refine_report;
+
+// Receives each finished mesh in turn, so it can be written out and destroyed before the next frame is meshed.
+// Callbacks return FALSE if the output could not be written.
+typedef struct mesh_sink_struct mesh_sink;
+struct mesh_sink_struct {
+        int (* begin)(mesh_sink * sink, uint32_t atlasWidth, uint32_t atlasHeight);
+        // The sink does not keep the shrinkwrap or name
+        int (* frame)(mesh_sink * sink, shrinkwrap * sw, const char * name);
+        int (* end)(mesh_sink * sink);
+        void (* destroy)(mesh_sink * sink);
+        void * context;
+};
+
 // Forward declarations
 ///////////////////////////////
 struct curves_list_struct;
 typedef struct curves_list_struct curve_list;
+struct contour_list_struct;
+typedef struct contour_list_struct contour_list;
 
 static inline vertp get_vert(array * array, size_t i) {return (vertp)array_get(array, i);}
-static inline uint32_t get_index(array * array, size_t i) {return *(uint32_t *)array_get(array, i);}
 static inline vertp add_vert(array * array) {return (vertp)array_push(array);}
-static inline uint32_t * add_index(array * array) {return (uint32_t *)array_push(array);}
+
+// Index lists are stored with a stride of either 16 or 32 bits.
+static inline uint32_t get_index(array * array, size_t i)
+{
+        if (array_stride(array) == sizeof(uint32_t)) return *(uint32_t *)array_get(array, i);
+        uint16_t index = *(uint16_t *)array_get(array, i);
+        return (index == shrinkwrap_restart_index16) ? shrinkwrap_restart_index : index;
+}
+
+static inline void set_index(array * array, size_t i, uint32_t index)
+{
+        if (array_stride(array) == sizeof(uint32_t)) {
+                *(uint32_t *)array_get(array, i) = index;
+        } else {
+                assert((index < shrinkwrap_restart_index16 || index == shrinkwrap_restart_index) &&
+                       "Index does not fit a 16-bit index list");
+                *(uint16_t *)array_get(array, i) = (uint16_t)index;
+        }
+}
+
+static inline void push_index(array * array, uint32_t index)
+{
+        array_push(array);
+        set_index(array, array_size(array) - 1, index);
+}
 
 static const size_t shrinkwrap_size = sizeof(shrinkwrap);
 #endif
@@ -22,7 +22,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <string.h>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 #include "internal/shrinkwrap_triangle_internal.h"
+#include "internal/shrinkwrap_monotone_internal.h"
+
+#if defined(__SSE__) && SEGMENT_BATCH_SIZE != 4
+#error "intersect_batch tests one SSE register of segments"
+#endif
+
+static const char * const c_triangulation_names[] = {"zipper", "monotone"};
+static const size_t c_triangulation_count = sizeof(c_triangulation_names) / sizeof(c_triangulation_names[0]);
 
 // Exposed functions
 ///////////////////////////////////////////////////////////////////////////////
@@ -111,6 +123,35 @@ shrinkwrap * triangulate(curve_list * cl)
         return sw;
 }
 
+shrinkwrap * triangulate_ex(curve_list * cl, triangulation engine)
+{
+        switch (engine) {
+                case TRIANGULATE_MONOTONE:
+                        return triangulate_monotone(cl);
+                case TRIANGULATE_ZIPPER:
+                default:
+                        assert(engine == TRIANGULATE_ZIPPER && "Unknown triangulation engine");
+                        return triangulate(cl);
+        }
+}
+
+const char * triangulation_name(triangulation engine)
+{
+        assert((size_t)engine < c_triangulation_count);
+        return c_triangulation_names[engine];
+}
+
+int triangulation_from_name(const char * name, triangulation * outEngine)
+{
+        for (size_t i = 0; i < c_triangulation_count; i++) {
+                if (strcmp(name, c_triangulation_names[i]) == 0) {
+                        *outEngine = (triangulation)i;
+                        return TRUE;
+                }
+        }
+        return FALSE;
+}
+
 // Set UV's to frame in texture space and translate geometry by the frame offset if desired.
 // Note: Will mutate geometry.
 void set_texture_coordinates(shrinkwrap * geometry, float framex, float framey, float texturewidth,
@@ -121,6 +162,11 @@ void set_texture_coordinates(shrinkwrap * geometry, float framex, float framey,
         // Could cause inaccuracy - if so divide in loop.
         float invwidth = 1.0 / texturewidth;
         float invheight = 1.0 / textureheight;
+        // Positions lose the frame offset below just as framex does, so their UVs are offset from the original framex
+        geometry->uvTransform.scaleU = invwidth;
+        geometry->uvTransform.scaleV = invheight;
+        geometry->uvTransform.biasU = framex * invwidth;
+        geometry->uvTransform.biasV = framey * invheight;
         framex -= frameoffsetx;
         framey -= frameoffsety;
         size_t count = array_size(verts);
@@ -151,6 +197,8 @@ float lineInwards(const vert * a1, const vert * b1, const vert * a2, const vert
 }
 
 // Determine if line intersects with any line segments continuing from the left curve point provided.
+// Curve points are strictly ordered by y, so the walk ends at the first segment starting below stopy - only segments
+// overlapping the line's y-range are tested.
 // TODO: Merge left and right implementation using function pointer and context data.
 int self_intersection_curve_left(const vert * a1, const vert * b1, float stopy, const CP * first)
 {
@@ -166,6 +214,7 @@ int self_intersection_curve_left(const vert * a1, const vert * b1, float stopy,
                         start = FALSE;
                 }
                 if (vert1->y <= stopy && vert2->y <= stopy) return FALSE;
+                if (vert1->y > stopy) return FALSE;
                 if (intersect(a1, b1, vert1, vert2)) return TRUE;
                 prev = next;
                 next = prev->next;
@@ -174,12 +223,15 @@ int self_intersection_curve_left(const vert * a1, const vert * b1, float stopy,
 }
 
 // Determine if line intersects with any line segments continuing from the right curve provided.
+// Segments are gathered into batches and tested together.
 // TODO: Merge left and right implementation using function pointer and context data.
 int self_intersection_curve_right(const vert * a1, const vert * b1, float stopy, C * left,
                                const CN * right, const vert * before2, const vert * before,
                                CP * first, const CP * l)
 {
-        if (before2 != NULL && intersect(a1, b1, before2, before)) return TRUE;
+        segment_batch batch;
+        segment_batch_clear(&batch);
+        if (before2 != NULL) segment_batch_add(&batch, before2, before);
         CP * prev = first;
         CP * next = get_next_right(prev, l, left, &right);
         int start = TRUE;
@@ -191,12 +243,16 @@ int self_intersection_curve_right(const vert * a1, const vert * b1, float stopy,
                         if (concave) return TRUE;
                         start = FALSE;
                 }
-                if (vert1->y >= stopy && vert2->y >= stopy) return FALSE;
-                if (intersect(a1, b1, vert1, vert2)) return TRUE;
+                if (vert1->y >= stopy && vert2->y >= stopy) break;
+                segment_batch_add(&batch, vert1, vert2);
+                if (batch.count == SEGMENT_BATCH_SIZE) {
+                        if (intersect_batch(a1, b1, &batch)) return TRUE;
+                        segment_batch_clear(&batch);
+                }
                 prev = next;
                 next = get_next_right(prev, l, left, &right);
         }
-        return FALSE;
+        return intersect_batch(a1, b1, &batch);
 }
 
 // Determine if the left and right curve_list intersect the line provided.
@@ -236,8 +292,14 @@ shrinkwrap * create_shrink_wrap(uint32_t numverts)
         shrinkwrap * sw = (shrinkwrap *)malloc(shrinkwrap_size);
         uint32_t estimate = numverts + numverts/3 * 2;
         sw->vertices = array_create(numverts, sizeof(vert));
-        sw->indicesFullAlpha = array_create(estimate, sizeof(uint32_t));
-        sw->indicesPartialAlpha = array_create(estimate, sizeof(uint32_t));
+        sw->indexWidth = (numverts <= shrinkwrap_restart_index16) ? INDEX_WIDTH_16 : INDEX_WIDTH_32;
+        sw->indicesFullAlpha = array_create(estimate, sw->indexWidth);
+        sw->indicesPartialAlpha = array_create(estimate, sw->indexWidth);
+        sw->primitiveType = PRIMITIVE_TRIANGLES;
+        sw->meshType = MESH_SPLIT;
+        sw->vertexFormat = VERTEX_FORMAT_FLOAT;
+        sw->quantisedVertices = NULL;
+        memset(&sw->uvTransform, 0, sizeof(uv_transform));
         return sw;
 }
 
@@ -246,6 +308,9 @@ void destroy_shrinkwrap(shrinkwrap * sw)
         array_destroy(sw->indicesFullAlpha);
         array_destroy(sw->indicesPartialAlpha);
         array_destroy(sw->vertices);
+        if (sw->quantisedVertices) {
+                array_destroy(sw->quantisedVertices);
+        }
         free(sw);
 }
 
@@ -288,9 +353,9 @@ void add_triangle(shrinkwrap * sw, alpha a, const CP * p1, const CP * p2,
 //        printf("%6.3f %6.3f -> %6.3f %6.3f -> %6.3f %6.3f\n", p1->vertex.x, p1->vertex.y, p2->vertex.x, p2->vertex.y,
 //               p3->vertex.x, p3->vertex.y);
         if (triangle_is_degenerate(p1, p2, p3)) return;
-        *add_index(array) = p1->index;
-        *add_index(array) = p2->index;
-        *add_index(array) = p3->index;
+        push_index(array, p1->index);
+        push_index(array, p2->index);
+        push_index(array, p3->index);
 }
 
 // Returns TRUE if ray 1 and 2 are intersecting.
@@ -317,6 +382,66 @@ int intersect(const vert * a1, const vert * b1, const vert * a2, const vert * b2
         return result;
 }
 
+// Empty a batch.  Unused lanes hold zero-length segments, which never intersect.
+void segment_batch_clear(segment_batch * batch)
+{
+        memset(batch, 0, sizeof(segment_batch));
+}
+
+void segment_batch_add(segment_batch * batch, const vert * a, const vert * b)
+{
+        assert(batch->count < SEGMENT_BATCH_SIZE);
+        size_t i = batch->count++;
+        batch->ax[i] = a->x;
+        batch->ay[i] = a->y;
+        batch->dx[i] = b->x - a->x;
+        batch->dy[i] = b->y - a->y;
+}
+
+// Returns TRUE if the line from a1 to b1 intersects any segment in the batch.  As intersect, but division-free: the
+// line parameters t = tn / d and u = un / d lie strictly inside (0, 1) when tn and un, with the sign of d removed,
+// lie strictly between 0 and |d|.
+int intersect_batch(const vert * a1, const vert * b1, const segment_batch * batch)
+{
+        float bx = b1->x - a1->x;
+        float by = b1->y - a1->y;
+#ifdef __SSE__
+        const __m128 sign = _mm_set1_ps(-0.0f);
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vbx = _mm_set1_ps(bx);
+        __m128 vby = _mm_set1_ps(by);
+        __m128 dx = _mm_loadu_ps(batch->dx);
+        __m128 dy = _mm_loadu_ps(batch->dy);
+        __m128 cx = _mm_sub_ps(_mm_loadu_ps(batch->ax), _mm_set1_ps(a1->x));
+        __m128 cy = _mm_sub_ps(_mm_loadu_ps(batch->ay), _mm_set1_ps(a1->y));
+        __m128 d = _mm_sub_ps(_mm_mul_ps(vbx, dy), _mm_mul_ps(vby, dx));
+        __m128 tn = _mm_sub_ps(_mm_mul_ps(cx, dy), _mm_mul_ps(cy, dx));
+        __m128 un = _mm_sub_ps(_mm_mul_ps(cx, vby), _mm_mul_ps(cy, vbx));
+        __m128 dsign = _mm_and_ps(d, sign);
+        d = _mm_xor_ps(d, dsign);
+        tn = _mm_xor_ps(tn, dsign);
+        un = _mm_xor_ps(un, dsign);
+        __m128 hit = _mm_and_ps(_mm_cmpgt_ps(tn, zero), _mm_cmplt_ps(tn, d));
+        hit = _mm_and_ps(hit, _mm_and_ps(_mm_cmpgt_ps(un, zero), _mm_cmplt_ps(un, d)));
+        return _mm_movemask_ps(hit) != 0;
+#else
+        int hit = 0;
+        for (size_t i = 0; i < SEGMENT_BATCH_SIZE; i++) {
+                float cx = batch->ax[i] - a1->x;
+                float cy = batch->ay[i] - a1->y;
+                float d = bx * batch->dy[i] - by * batch->dx[i];
+                float tn = cx * batch->dy[i] - cy * batch->dx[i];
+                float un = cx * by - cy * bx;
+                float s = (d < 0.0f) ? -1.0f : 1.0f;
+                d *= s;
+                tn *= s;
+                un *= s;
+                hit |= (tn > 0.0f) & (tn < d) & (un > 0.0f) & (un < d);
+        }
+        return hit;
+#endif
+}
+
 // Find next point on the right with y equal/greater and directly subsequent
 // to the left hand curve (unless curve is ending).
 CP * get_next_right(CP * pr, const CP * pl, C * left,
@@ -0,0 +1,245 @@
+//
+//  taskpool.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "taskpool.h"
+
+typedef struct task_struct {
+        task_function function;
+        void * context;
+        size_t task;
+} task;
+
+// Ring buffer of tasks.  Its owner runs the newest first; other threads steal the oldest.
+typedef struct task_deque_struct {
+        task * tasks;
+        size_t head;
+        size_t count;
+        size_t capacity;
+} task_deque;
+
+struct taskpool_struct {
+        pthread_t * workers;
+        size_t workercount;
+        // A deque per worker, one for the thread in taskpool_wait and, last, one for tasks submitted from outside
+        task_deque * deques;
+        size_t dequecount;
+        // The thread in taskpool_wait, if 'waiting'
+        pthread_t waiter;
+        int waiting;
+        // Tasks submitted but not yet completed
+        size_t pending;
+        int stopping;
+        pthread_mutex_t lock;
+        pthread_cond_t work;
+        pthread_cond_t idle;
+};
+static const size_t taskpool_size = sizeof(taskpool);
+static const size_t task_start_capacity = 64;
+
+// The deque of the calling thread.  Must be called with the lock held.
+static size_t own_deque(taskpool * pool)
+{
+        pthread_t self = pthread_self();
+        for (size_t i = 0; i < pool->workercount; i++) {
+                if (pthread_equal(self, pool->workers[i])) return i;
+        }
+        if (pool->waiting && pthread_equal(self, pool->waiter)) return pool->workercount;
+        return pool->dequecount - 1;
+}
+
+static void push_task(task_deque * deque, task t)
+{
+        if (deque->count == deque->capacity) {
+                size_t capacity = deque->capacity * 2;
+                task * tasks = (task *)malloc(sizeof(task) * capacity);
+                for (size_t i = 0; i < deque->count; i++) {
+                        tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+                }
+                free(deque->tasks);
+                deque->tasks = tasks;
+                deque->head = 0;
+                deque->capacity = capacity;
+        }
+        deque->tasks[(deque->head + deque->count) % deque->capacity] = t;
+        deque->count++;
+}
+
+static task pop_newest(task_deque * deque)
+{
+        assert(deque->count > 0);
+        deque->count--;
+        return deque->tasks[(deque->head + deque->count) % deque->capacity];
+}
+
+static task pop_oldest(task_deque * deque)
+{
+        assert(deque->count > 0);
+        task t = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+        return t;
+}
+
+// Take the newest task of the thread's own deque, else the oldest submitted from outside, else steal the oldest task
+// of another thread.  Must be called with the lock held.
+static int take_task(taskpool * pool, size_t own, task * outTask)
+{
+        size_t shared = pool->dequecount - 1;
+        if (own != shared && pool->deques[own].count > 0) {
+                *outTask = pop_newest(pool->deques + own);
+                return 1;
+        }
+        if (pool->deques[shared].count > 0) {
+                *outTask = pop_oldest(pool->deques + shared);
+                return 1;
+        }
+        for (size_t i = 1; i < shared; i++) {
+                task_deque * victim = pool->deques + (own + i) % shared;
+                if (victim->count > 0) {
+                        *outTask = pop_oldest(victim);
+                        return 1;
+                }
+        }
+        return 0;
+}
+
+// Runs a task outside of the lock, re-acquiring it afterwards to retire the task.
+static void run_task(taskpool * pool, task t)
+{
+        pthread_mutex_unlock(&pool->lock);
+        t.function(pool, t.context, t.task);
+        pthread_mutex_lock(&pool->lock);
+        assert(pool->pending > 0);
+        pool->pending--;
+        if (pool->pending == 0) {
+                pthread_cond_broadcast(&pool->idle);
+        }
+}
+
+static void * worker_main(void * data)
+{
+        taskpool * pool = (taskpool *)data;
+        pthread_mutex_lock(&pool->lock);
+        size_t own = own_deque(pool);
+        while (pool->stopping == 0) {
+                task t;
+                if (take_task(pool, own, &t)) {
+                        run_task(pool, t);
+                } else {
+                        pthread_cond_wait(&pool->work, &pool->lock);
+                }
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+}
+
+taskpool * taskpool_create(size_t threads)
+{
+        taskpool * pool = (taskpool *)malloc(taskpool_size);
+        pool->workercount = (threads > 1) ? threads - 1 : 0;
+        pool->workers = (pthread_t *)malloc(sizeof(pthread_t) * (pool->workercount + 1));
+        pool->dequecount = pool->workercount + 2;
+        pool->deques = (task_deque *)malloc(sizeof(task_deque) * pool->dequecount);
+        for (size_t i = 0; i < pool->dequecount; i++) {
+                pool->deques[i].tasks = (task *)malloc(sizeof(task) * task_start_capacity);
+                pool->deques[i].head = 0;
+                pool->deques[i].count = 0;
+                pool->deques[i].capacity = task_start_capacity;
+        }
+        pool->waiting = 0;
+        pool->pending = 0;
+        pool->stopping = 0;
+        pthread_mutex_init(&pool->lock, NULL);
+        pthread_cond_init(&pool->work, NULL);
+        pthread_cond_init(&pool->idle, NULL);
+        // Workers find their deques in 'workers', so they wait for it to be filled in
+        pthread_mutex_lock(&pool->lock);
+        for (size_t i = 0; i < pool->workercount; i++) {
+                if (pthread_create(pool->workers + i, NULL, worker_main, pool) != 0) {
+                        // Carry on with however many workers could be started.  Their deques are left empty.
+                        pool->workercount = i;
+                        break;
+                }
+        }
+        pthread_mutex_unlock(&pool->lock);
+        return pool;
+}
+
+void taskpool_destroy(taskpool * pool)
+{
+        pthread_mutex_lock(&pool->lock);
+        assert(pool->pending == 0 && "Destroying task pool with outstanding tasks");
+        pool->stopping = 1;
+        pthread_cond_broadcast(&pool->work);
+        pthread_mutex_unlock(&pool->lock);
+        for (size_t i = 0; i < pool->workercount; i++) {
+                pthread_join(pool->workers[i], NULL);
+        }
+        pthread_cond_destroy(&pool->idle);
+        pthread_cond_destroy(&pool->work);
+        pthread_mutex_destroy(&pool->lock);
+        for (size_t i = 0; i < pool->dequecount; i++) {
+                free(pool->deques[i].tasks);
+        }
+        free(pool->deques);
+        free(pool->workers);
+        free(pool);
+}
+
+void taskpool_submit(taskpool * pool, task_function function, void * context, size_t taskid)
+{
+        task t = {function, context, taskid};
+        pthread_mutex_lock(&pool->lock);
+        push_task(pool->deques + own_deque(pool), t);
+        pool->pending++;
+        pthread_cond_signal(&pool->work);
+        // Let a waiting caller help out with the new task
+        pthread_cond_signal(&pool->idle);
+        pthread_mutex_unlock(&pool->lock);
+}
+
+void taskpool_wait(taskpool * pool)
+{
+        pthread_mutex_lock(&pool->lock);
+        assert(pool->waiting == 0 && "Only one thread may wait on a task pool");
+        pool->waiter = pthread_self();
+        pool->waiting = 1;
+        size_t own = pool->workercount;
+        while (pool->pending > 0) {
+                task t;
+                if (take_task(pool, own, &t)) {
+                        run_task(pool, t);
+                } else {
+                        pthread_cond_wait(&pool->idle, &pool->lock);
+                }
+        }
+        pool->waiting = 0;
+        pthread_mutex_unlock(&pool->lock);
+}
+
+size_t taskpool_threads(taskpool * pool)
+{
+        return pool->workercount + 1;
+}
@@ -0,0 +1,46 @@
+//
+//  taskpool.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef shrinkwrap_taskpool_h
+#define shrinkwrap_taskpool_h
+
+#include <stddef.h>
+
+struct taskpool_struct;
+typedef struct taskpool_struct taskpool;
+
+// Tasks may submit further tasks to the pool they are running on.  Tasks submitted from outside the pool, including
+// those submitted before taskpool_wait, go on one shared queue and are started in the order they were submitted.
+// Each thread runs the tasks its own tasks submitted newest first, and a thread with nothing to do steals the oldest
+// of another's, so stealing only comes into play when tasks submit follow-up work.
+typedef void (* task_function)(taskpool * pool, void * context, size_t task);
+
+// A pool of 'threads' workers, counting the thread that calls taskpool_wait.  A pool of 0 or 1 threads runs every
+// task on the waiting thread.
+taskpool * taskpool_create(size_t threads);
+void taskpool_destroy(taskpool * pool);
+void taskpool_submit(taskpool * pool, task_function function, void * context, size_t task);
+// Blocks until every submitted task, including tasks submitted while waiting, has completed.
+void taskpool_wait(taskpool * pool);
+size_t taskpool_threads(taskpool * pool);
+
+#endif
@@ -0,0 +1,590 @@
+//
+//  textwriter.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <pthread.h>
+#include "textwriter.h"
+
+struct textwriter_struct {
+        FILE * output;
+        char * buffer;
+        size_t used;
+        size_t capacity;
+        int failed;
+        // Background writing: a full buffer is handed to the worker as 'pending' and filling carries on in 'spare'
+        int background;
+        pthread_t worker;
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+        char * pending;
+        size_t pendingSize;
+        char * spare;
+        int stopping;
+};
+
+// Shortest round trip
+///////////////////////////////////////////////////////////////////////////////
+// Free-format digit generation (Steele & White, Burger & Dybvig).  The value and the halfway points to its neighbours
+// are held as exact ratios r / s, m- / s and m+ / s of big integers, and digits are generated until the digits so far
+// lie within the halfway points.  Floats need no more than 200 bits, so the big integers are fixed size.
+#define FLOAT_BIGNUM_WORDS 8
+
+typedef struct float_bignum_struct {
+        uint32_t words[FLOAT_BIGNUM_WORDS];
+        size_t size;
+} float_bignum;
+
+static void bignum_set(float_bignum * n, uint64_t value)
+{
+        n->size = 0;
+        while (value) {
+                n->words[n->size++] = (uint32_t)value;
+                value >>= 32;
+        }
+}
+
+static void bignum_shift(float_bignum * n, int bits)
+{
+        if (n->size == 0) return;
+        int wordShift = bits / 32;
+        int bitShift = bits % 32;
+        assert(n->size + wordShift + 1 <= FLOAT_BIGNUM_WORDS);
+        n->words[n->size + wordShift] = 0;
+        for (int i = (int)n->size - 1; i >= 0; i--) {
+                uint32_t word = n->words[i];
+                if (bitShift) {
+                        n->words[i + wordShift + 1] |= word >> (32 - bitShift);
+                }
+                n->words[i + wordShift] = word << bitShift;
+        }
+        for (int i = 0; i < wordShift; i++) {
+                n->words[i] = 0;
+        }
+        n->size += wordShift + 1;
+        while (n->size && n->words[n->size - 1] == 0) n->size--;
+}
+
+static void bignum_multiply(float_bignum * n, uint32_t factor)
+{
+        uint64_t carry = 0;
+        for (size_t i = 0; i < n->size; i++) {
+                uint64_t product = (uint64_t)n->words[i] * factor + carry;
+                n->words[i] = (uint32_t)product;
+                carry = product >> 32;
+        }
+        if (carry) {
+                assert(n->size < FLOAT_BIGNUM_WORDS);
+                n->words[n->size++] = (uint32_t)carry;
+        }
+}
+
+static void bignum_add(float_bignum * outSum, const float_bignum * a, const float_bignum * b)
+{
+        size_t size = a->size > b->size ? a->size : b->size;
+        uint64_t carry = 0;
+        for (size_t i = 0; i < size; i++) {
+                uint64_t sum = carry;
+                if (i < a->size) sum += a->words[i];
+                if (i < b->size) sum += b->words[i];
+                outSum->words[i] = (uint32_t)sum;
+                carry = sum >> 32;
+        }
+        outSum->size = size;
+        if (carry) {
+                assert(size < FLOAT_BIGNUM_WORDS);
+                outSum->words[outSum->size++] = (uint32_t)carry;
+        }
+}
+
+// a must not be less than b
+static void bignum_subtract(float_bignum * a, const float_bignum * b)
+{
+        int64_t borrow = 0;
+        for (size_t i = 0; i < a->size; i++) {
+                int64_t difference = (int64_t)a->words[i] - borrow - (i < b->size ? b->words[i] : 0);
+                borrow = difference < 0;
+                a->words[i] = (uint32_t)(difference + (borrow << 32));
+        }
+        while (a->size && a->words[a->size - 1] == 0) a->size--;
+}
+
+static int bignum_compare(const float_bignum * a, const float_bignum * b)
+{
+        if (a->size != b->size) return (a->size < b->size) ? -1 : 1;
+        for (size_t i = a->size; i > 0; i--) {
+                if (a->words[i - 1] != b->words[i - 1]) return (a->words[i - 1] < b->words[i - 1]) ? -1 : 1;
+        }
+        return 0;
+}
+
+// Generate the digits of a positive finite float, returning how many and setting the decimal exponent so the value is
+// 0.digits * 10^exponent.
+static size_t shortest_digits(uint32_t mantissa, int exponent, int lowerGapSmaller, char * digits, int * outExponent)
+{
+        float_bignum r;
+        float_bignum s;
+        float_bignum mMinus;
+        float_bignum mPlus;
+        float_bignum bound;
+        // The gap below a power of two is half the gap above it
+        int gapShift = lowerGapSmaller ? 1 : 0;
+        bignum_set(&r, (uint64_t)mantissa << (1 + gapShift));
+        bignum_set(&s, 2 << gapShift);
+        bignum_set(&mMinus, 1);
+        bignum_set(&mPlus, 1 << gapShift);
+        if (exponent >= 0) {
+                bignum_shift(&r, exponent);
+                bignum_shift(&mMinus, exponent);
+                bignum_shift(&mPlus, exponent);
+        } else {
+                bignum_shift(&s, -exponent);
+        }
+        // Round to nearest even reads the halfway points back as the value when its mantissa is even
+        int even = (mantissa & 1) == 0;
+        double value = ldexp((double)mantissa, exponent);
+        int k = (int)ceil(log10(value) - 1e-10);
+        if (k >= 0) {
+                for (int i = 0; i < k; i++) bignum_multiply(&s, 10);
+        } else {
+                for (int i = 0; i < -k; i++) {
+                        bignum_multiply(&r, 10);
+                        bignum_multiply(&mMinus, 10);
+                        bignum_multiply(&mPlus, 10);
+                }
+        }
+        while (1) {
+                bignum_add(&bound, &r, &mPlus);
+                int c = bignum_compare(&bound, &s);
+                if (c < 0 || (c == 0 && even == 0)) break;
+                bignum_multiply(&s, 10);
+                k++;
+        }
+        size_t count = 0;
+        while (1) {
+                bignum_multiply(&r, 10);
+                bignum_multiply(&mMinus, 10);
+                bignum_multiply(&mPlus, 10);
+                int digit = 0;
+                while (bignum_compare(&r, &s) >= 0) {
+                        bignum_subtract(&r, &s);
+                        digit++;
+                }
+                assert(digit < 10);
+                int c = bignum_compare(&r, &mMinus);
+                int low = c < 0 || (c == 0 && even);
+                bignum_add(&bound, &r, &mPlus);
+                c = bignum_compare(&bound, &s);
+                int high = c > 0 || (c == 0 && even);
+                if (low == 0 && high == 0) {
+                        digits[count++] = (char)('0' + digit);
+                        continue;
+                }
+                if (low && high) {
+                        // Both digits read back correctly; take the nearer, or the even one on a tie
+                        bignum_add(&bound, &r, &r);
+                        c = bignum_compare(&bound, &s);
+                        if (c > 0 || (c == 0 && (digit & 1))) digit++;
+                } else if (high) {
+                        digit++;
+                }
+                digits[count++] = (char)('0' + digit);
+                break;
+        }
+        *outExponent = k;
+        return count;
+}
+
+// shortest_digits in 64-bit integers, for exponents from -56 to 28.  Within them s never passes 2^59, and r + m+
+// stays below 11s.
+static size_t shortest_digits64(uint32_t mantissa, int exponent, int lowerGapSmaller, char * digits, int * outExponent)
+{
+        assert(exponent >= -56 && exponent <= 28);
+        int gapShift = lowerGapSmaller ? 1 : 0;
+        uint64_t r = (uint64_t)mantissa << (1 + gapShift);
+        uint64_t s = (uint64_t)2 << gapShift;
+        uint64_t mMinus = 1;
+        uint64_t mPlus = (uint64_t)1 << gapShift;
+        if (exponent >= 0) {
+                r <<= exponent;
+                mMinus <<= exponent;
+                mPlus <<= exponent;
+        } else {
+                s <<= -exponent;
+        }
+        int even = (mantissa & 1) == 0;
+        int k = (int)ceil(log10(ldexp((double)mantissa, exponent)) - 1e-10);
+        if (k >= 0) {
+                for (int i = 0; i < k; i++) s *= 10;
+        } else {
+                for (int i = 0; i < -k; i++) {
+                        r *= 10;
+                        mMinus *= 10;
+                        mPlus *= 10;
+                }
+        }
+        while (r + mPlus > s || (r + mPlus == s && even)) {
+                s *= 10;
+                k++;
+        }
+        size_t count = 0;
+        while (1) {
+                r *= 10;
+                mMinus *= 10;
+                mPlus *= 10;
+                int digit = (int)(r / s);
+                r %= s;
+                int low = r < mMinus || (r == mMinus && even);
+                int high = r + mPlus > s || (r + mPlus == s && even);
+                if (low == 0 && high == 0) {
+                        digits[count++] = (char)('0' + digit);
+                        continue;
+                }
+                if (low && high) {
+                        if (2 * r > s || (2 * r == s && (digit & 1))) digit++;
+                } else if (high) {
+                        digit++;
+                }
+                digits[count++] = (char)('0' + digit);
+                break;
+        }
+        *outExponent = k;
+        return count;
+}
+
+size_t format_float(float value, char * outText)
+{
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        char * p = outText;
+        if (bits >> 31) *p++ = '-';
+        uint32_t biased = (bits >> 23) & 0xFF;
+        uint32_t fraction = bits & 0x7FFFFF;
+        if (biased == 0xFF) {
+                strcpy(fraction ? outText : p, fraction ? "nan" : "inf");
+                return strlen(outText);
+        }
+        if (biased == 0 && fraction == 0) {
+                strcpy(p, "0");
+                return strlen(outText);
+        }
+        uint32_t mantissa = biased ? (fraction | 0x800000) : fraction;
+        int exponent = (biased ? (int)biased : 1) - 150;
+        char digits[12];
+        size_t count;
+        int k;
+        float magnitude = fabsf(value);
+        if (magnitude < 1048576.0f && magnitude * 4.0f == floorf(magnitude * 4.0f)) {
+                // Quarters below 2^20 and integers are their own shortest form, as no shorter decimal is within half
+                // a gap of them
+                uint32_t quarters = (uint32_t)(magnitude * 4.0f);
+                uint32_t whole = quarters / 4;
+                static const char * const c_quarters[] = {"", "25", "5", "75"};
+                char text[TEXT_FLOAT_SIZE];
+                size_t length = 0;
+                do {
+                        text[length++] = (char)('0' + whole % 10);
+                        whole /= 10;
+                } while (whole);
+                k = (int)length;
+                count = 0;
+                while (length) digits[count++] = text[--length];
+                const char * part = c_quarters[quarters % 4];
+                while (*part) digits[count++] = *part++;
+                // Leading zeros of a fraction below one and trailing zeros of an integer carry no digits
+                size_t first = 0;
+                while (first < count && digits[first] == '0') {
+                        first++;
+                        k--;
+                }
+                memmove(digits, digits + first, count - first);
+                count -= first;
+                while (count > 1 && digits[count - 1] == '0') count--;
+        } else if (exponent >= -56 && exponent <= 28) {
+                count = shortest_digits64(mantissa, exponent, biased > 1 && fraction == 0, digits, &k);
+        } else {
+                count = shortest_digits(mantissa, exponent, biased > 1 && fraction == 0, digits, &k);
+        }
+        if (k > 9 || k < -3) {
+                *p++ = digits[0];
+                if (count > 1) {
+                        *p++ = '.';
+                        memcpy(p, digits + 1, count - 1);
+                        p += count - 1;
+                }
+                int e = k - 1;
+                *p++ = 'e';
+                if (e < 0) {
+                        *p++ = '-';
+                        e = -e;
+                }
+                if (e >= 10) *p++ = (char)('0' + e / 10);
+                *p++ = (char)('0' + e % 10);
+        } else if (k <= 0) {
+                *p++ = '0';
+                *p++ = '.';
+                for (int i = 0; i < -k; i++) *p++ = '0';
+                memcpy(p, digits, count);
+                p += count;
+        } else if ((size_t)k >= count) {
+                memcpy(p, digits, count);
+                p += count;
+                for (size_t i = count; i < (size_t)k; i++) *p++ = '0';
+        } else {
+                memcpy(p, digits, k);
+                p += k;
+                *p++ = '.';
+                memcpy(p, digits + k, count - k);
+                p += count - k;
+        }
+        *p = '\0';
+        return (size_t)(p - outText);
+}
+
+// Buffered writing
+///////////////////////////////////////////////////////////////////////////////
+static void * textwriter_worker(void * data)
+{
+        textwriter * writer = (textwriter *)data;
+        pthread_mutex_lock(&writer->lock);
+        while (1) {
+                while (writer->pending == NULL && writer->stopping == 0) {
+                        pthread_cond_wait(&writer->changed, &writer->lock);
+                }
+                if (writer->pending == NULL) break;
+                char * pending = writer->pending;
+                size_t size = writer->pendingSize;
+                pthread_mutex_unlock(&writer->lock);
+                int written = fwrite(pending, 1, size, writer->output) == size;
+                pthread_mutex_lock(&writer->lock);
+                if (written == 0) writer->failed = 1;
+                writer->spare = pending;
+                writer->pending = NULL;
+                pthread_cond_broadcast(&writer->changed);
+        }
+        pthread_mutex_unlock(&writer->lock);
+        return NULL;
+}
+
+static textwriter * create_writer(FILE * output, size_t capacity, int background)
+{
+        textwriter * writer = (textwriter *)calloc(1, sizeof(textwriter));
+        writer->output = output;
+        writer->capacity = capacity > TEXT_FLOAT_SIZE ? capacity : TEXT_FLOAT_SIZE;
+        writer->buffer = (char *)malloc(writer->capacity);
+        writer->background = background;
+        if (background) {
+                writer->spare = (char *)malloc(writer->capacity);
+                pthread_mutex_init(&writer->lock, NULL);
+                pthread_cond_init(&writer->changed, NULL);
+                pthread_create(&writer->worker, NULL, textwriter_worker, writer);
+        }
+        return writer;
+}
+
+// Wait for the worker to finish the pending buffer, then hand it the current one unless 'wait' asks for it to be
+// written before returning.
+static void hand_over(textwriter * writer, int wait)
+{
+        pthread_mutex_lock(&writer->lock);
+        while (writer->pending) {
+                pthread_cond_wait(&writer->changed, &writer->lock);
+        }
+        if (writer->used) {
+                writer->pending = writer->buffer;
+                writer->pendingSize = writer->used;
+                writer->buffer = writer->spare;
+                writer->spare = NULL;
+                writer->used = 0;
+                pthread_cond_broadcast(&writer->changed);
+                while (wait && writer->pending) {
+                        pthread_cond_wait(&writer->changed, &writer->lock);
+                }
+        }
+        pthread_mutex_unlock(&writer->lock);
+}
+
+// Make room in the buffer, writing it out, handing it to the worker or, with no output, growing it.
+static void drain(textwriter * writer)
+{
+        if (writer->output == NULL) {
+                writer->capacity *= 2;
+                writer->buffer = (char *)realloc(writer->buffer, writer->capacity);
+        } else if (writer->background) {
+                hand_over(writer, 0);
+        } else {
+                textwriter_flush(writer);
+        }
+}
+
+textwriter * textwriter_create(FILE * output, size_t capacity)
+{
+        return create_writer(output, capacity, 0);
+}
+
+textwriter * textwriter_create_background(FILE * output, size_t capacity)
+{
+        return create_writer(output, capacity, 1);
+}
+
+textwriter * textwriter_create_memory(size_t capacity)
+{
+        return create_writer(NULL, capacity, 0);
+}
+
+const char * textwriter_contents(textwriter * writer, size_t * outLength)
+{
+        assert(writer->output == NULL && "Only memory writers keep their text");
+        *outLength = writer->used;
+        return writer->buffer;
+}
+
+void textwriter_destroy(textwriter * writer)
+{
+        textwriter_flush(writer);
+        if (writer->background) {
+                pthread_mutex_lock(&writer->lock);
+                writer->stopping = 1;
+                pthread_cond_broadcast(&writer->changed);
+                pthread_mutex_unlock(&writer->lock);
+                pthread_join(writer->worker, NULL);
+                pthread_mutex_destroy(&writer->lock);
+                pthread_cond_destroy(&writer->changed);
+                free(writer->spare);
+        }
+        free(writer->buffer);
+        free(writer);
+}
+
+int textwriter_flush(textwriter * writer)
+{
+        if (writer->background) {
+                hand_over(writer, 1);
+                pthread_mutex_lock(&writer->lock);
+                int failed = writer->failed;
+                pthread_mutex_unlock(&writer->lock);
+                return failed == 0;
+        }
+        if (writer->output == NULL) return 1;
+        if (writer->used && fwrite(writer->buffer, 1, writer->used, writer->output) != writer->used) {
+                writer->failed = 1;
+        }
+        writer->used = 0;
+        return writer->failed == 0;
+}
+
+int textwriter_ok(textwriter * writer)
+{
+        if (writer->background == 0) return writer->failed == 0;
+        pthread_mutex_lock(&writer->lock);
+        int failed = writer->failed;
+        pthread_mutex_unlock(&writer->lock);
+        return failed == 0;
+}
+
+void textwriter_write(textwriter * writer, const char * text, size_t length)
+{
+        while (length) {
+                if (writer->used == writer->capacity) drain(writer);
+                size_t chunk = writer->capacity - writer->used;
+                chunk = chunk < length ? chunk : length;
+                memcpy(writer->buffer + writer->used, text, chunk);
+                writer->used += chunk;
+                text += chunk;
+                length -= chunk;
+        }
+}
+
+void textwriter_string(textwriter * writer, const char * text)
+{
+        textwriter_write(writer, text, strlen(text));
+}
+
+void textwriter_char(textwriter * writer, char c)
+{
+        if (writer->used == writer->capacity) drain(writer);
+        writer->buffer[writer->used++] = c;
+}
+
+void textwriter_uint(textwriter * writer, uint64_t value)
+{
+        char text[20];
+        size_t length = 0;
+        do {
+                text[length++] = (char)('0' + value % 10);
+                value /= 10;
+        } while (value);
+        if (writer->capacity - writer->used < length) drain(writer);
+        while (length) writer->buffer[writer->used++] = text[--length];
+}
+
+void textwriter_int(textwriter * writer, int64_t value)
+{
+        if (value < 0) {
+                textwriter_char(writer, '-');
+                textwriter_uint(writer, 0 - (uint64_t)value);
+        } else {
+                textwriter_uint(writer, (uint64_t)value);
+        }
+}
+
+void textwriter_float(textwriter * writer, float value)
+{
+        if (writer->capacity - writer->used < TEXT_FLOAT_SIZE) drain(writer);
+        writer->used += format_float(value, writer->buffer + writer->used);
+}
+
+void textwriter_printf(textwriter * writer, const char * format, ...)
+{
+        va_list args;
+        va_start(args, format);
+        size_t room = writer->capacity - writer->used;
+        int length = vsnprintf(writer->buffer + writer->used, room, format, args);
+        va_end(args);
+        if (length < 0) {
+                // Nothing was written, so a later flush still reports the failure
+                if (writer->background) pthread_mutex_lock(&writer->lock);
+                writer->failed = 1;
+                if (writer->background) pthread_mutex_unlock(&writer->lock);
+                return;
+        }
+        if ((size_t)length < room) {
+                writer->used += (size_t)length;
+                return;
+        }
+        // Too long for what is left: format again into an emptied or grown buffer, or on the heap if it still won't fit
+        drain(writer);
+        va_start(args, format);
+        room = writer->capacity - writer->used;
+        if ((size_t)length < room) {
+                vsnprintf(writer->buffer + writer->used, room, format, args);
+                writer->used += (size_t)length;
+        } else {
+                char * text = (char *)malloc((size_t)length + 1);
+                vsnprintf(text, (size_t)length + 1, format, args);
+                textwriter_write(writer, text, (size_t)length);
+                free(text);
+        }
+        va_end(args);
+}
@@ -0,0 +1,61 @@
+//
+//  textwriter.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+#ifndef shrinkwrap_textwriter_h
+#define shrinkwrap_textwriter_h
+
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Enough for any float from format_float and its terminating NUL
+#define TEXT_FLOAT_SIZE 16
+
+struct textwriter_struct;
+typedef struct textwriter_struct textwriter;
+
+// Collects text in a buffer of 'capacity' bytes and writes it out a buffer at a time.
+textwriter * textwriter_create(FILE * output, size_t capacity);
+// As textwriter_create, but full buffers are written on a thread of the writer's own while the next one fills
+textwriter * textwriter_create_background(FILE * output, size_t capacity);
+// Keeps all of its text in a buffer that grows as needed, for textwriter_contents
+textwriter * textwriter_create_memory(size_t capacity);
+const char * textwriter_contents(textwriter * writer, size_t * outLength);
+// Flushes before freeing
+void textwriter_destroy(textwriter * writer);
+void textwriter_write(textwriter * writer, const char * text, size_t length);
+void textwriter_string(textwriter * writer, const char * text);
+void textwriter_char(textwriter * writer, char c);
+void textwriter_uint(textwriter * writer, uint64_t value);
+void textwriter_int(textwriter * writer, int64_t value);
+void textwriter_float(textwriter * writer, float value);
+// printf formatting straight into the buffer
+void textwriter_printf(textwriter * writer, const char * format, ...);
+// Both return 0 if anything written so far failed to reach the output
+int textwriter_flush(textwriter * writer);
+int textwriter_ok(textwriter * writer);
+
+// Write the shortest decimal that reads back as exactly 'value', without a locale and the same on every platform.
+// Plain notation is used from 1e-4 up to 1e9 and scientific outside it, e.g. "0.1", "-3.5", "16777216", "1e-45".
+// Returns the length, not counting the NUL.
+size_t format_float(float value, char * outText);
+
+#endif
@@ -0,0 +1,100 @@
+//
+//  workqueue.c
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+#include "workqueue.h"
+
+struct workqueue_struct {
+        // Ring buffer of items
+        void ** items;
+        size_t head;
+        size_t count;
+        size_t capacity;
+        int closed;
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+};
+
+static const size_t workqueue_size = sizeof(workqueue);
+
+workqueue * workqueue_create(size_t capacity)
+{
+        workqueue * queue = (workqueue *)malloc(workqueue_size);
+        queue->capacity = capacity > 0 ? capacity : 1;
+        queue->items = (void **)malloc(sizeof(void *) * queue->capacity);
+        queue->head = 0;
+        queue->count = 0;
+        queue->closed = 0;
+        pthread_mutex_init(&queue->lock, NULL);
+        pthread_cond_init(&queue->changed, NULL);
+        return queue;
+}
+
+void workqueue_destroy(workqueue * queue)
+{
+        assert(queue->count == 0 && "Destroying work queue with items left in it");
+        pthread_cond_destroy(&queue->changed);
+        pthread_mutex_destroy(&queue->lock);
+        free(queue->items);
+        free(queue);
+}
+
+void workqueue_push(workqueue * queue, void * item)
+{
+        assert(item != NULL);
+        pthread_mutex_lock(&queue->lock);
+        assert(queue->closed == 0 && "Pushing to a closed work queue");
+        while (queue->count == queue->capacity) {
+                pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        queue->items[(queue->head + queue->count) % queue->capacity] = item;
+        queue->count++;
+        pthread_cond_broadcast(&queue->changed);
+        pthread_mutex_unlock(&queue->lock);
+}
+
+void * workqueue_pop(workqueue * queue)
+{
+        pthread_mutex_lock(&queue->lock);
+        while (queue->count == 0 && queue->closed == 0) {
+                pthread_cond_wait(&queue->changed, &queue->lock);
+        }
+        void * item = NULL;
+        if (queue->count > 0) {
+                item = queue->items[queue->head];
+                queue->head = (queue->head + 1) % queue->capacity;
+                queue->count--;
+                pthread_cond_broadcast(&queue->changed);
+        }
+        pthread_mutex_unlock(&queue->lock);
+        return item;
+}
+
+void workqueue_close(workqueue * queue)
+{
+        pthread_mutex_lock(&queue->lock);
+        queue->closed = 1;
+        pthread_cond_broadcast(&queue->changed);
+        pthread_mutex_unlock(&queue->lock);
+}
@@ -0,0 +1,42 @@
+//
+//  workqueue.h
+//
+//  shrinkwrap is a tool for triangulating bitmap alpha.
+//  Copyright (c) 2014 Jarrod Moldrich. All rights reserved.
+//
+//  This file is part of shrinkwrap.
+//
+//  shrinkwrap is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU Affero General Public License as
+//  published by the Free Software Foundation, either version 3 of the
+//  License, or (at your option) any later version.
+//
+//  shrinkwrap is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU Affero General Public License for more details.
+//
+//  You should have received a copy of the GNU Affero General Public License
+//  along with shrinkwrap.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef shrinkwrap_workqueue_h
+#define shrinkwrap_workqueue_h
+
+#include <stddef.h>
+
+struct workqueue_struct;
+typedef struct workqueue_struct workqueue;
+
+// A first-in first-out queue of items handed from one stage of a pipeline to the next, holding at most 'capacity'
+// at once so a fast stage cannot run ahead of a slow one.
+workqueue * workqueue_create(size_t capacity);
+void workqueue_destroy(workqueue * queue);
+// Blocks while the queue is full.  Items may not be NULL.
+void workqueue_push(workqueue * queue, void * item);
+// Blocks while the queue is empty.  Returns NULL once the queue is closed and empty.
+void * workqueue_pop(workqueue * queue);
+// Nothing more will be pushed
+void workqueue_close(workqueue * queue);
+
+#endif
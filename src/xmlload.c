@@ -9,15 +9,11 @@
 #include "expat-2.1.0/lib/expat.h"
 #include "xmlload.h"
 
-#define XML_BUFFSIZE        8192
-
 typedef struct xml_image_parse_info_struct {
         const char * name;
         size_t offset;
 } xml_image_parse_info;
 typedef xml_image_parse_info * xml_image_parse_infop;
-static const size_t xml_image_parse_size = sizeof(xml_image_parse_info);
-static const size_t xml_image_parse_num_elements = 8;
 
 typedef struct xml_context_struct {
         xml_image * firstImage;
@@ -26,14 +22,6 @@ typedef struct xml_context_struct {
 typedef xml_context * xml_contextp;
 static const size_t xml_context_size = sizeof(xml_context);
 
-static xml_image_parse_info createImageParseInfo(const char * name, size_t offset)
-{
-        xml_image_parse_info info;
-        info.name = name;
-        info.offset = offset;
-        return info;
-}
-
 static xml_contextp createXmlContext()
 {
         xml_contextp newContext = (xml_contextp)malloc(xml_context_size);
@@ -73,34 +61,24 @@ static void addImageToContext(xml_contextp xmlContext, xml_image * imageData)
         xmlContext->lastImage = imageData;
 }
 
-static xml_image_parse_info * xmlParseInfo = NULL;
-
-void initXMLParseInfos()
-{
-        if (xmlParseInfo != NULL) return;
-        xmlParseInfo = malloc(xml_image_parse_size * xml_image_parse_num_elements);
-        size_t num = 0;
-        xmlParseInfo[num++] = createImageParseInfo("x", offsetof(xml_image, x));
-        xmlParseInfo[num++] = createImageParseInfo("y", offsetof(xml_image, y));
-        xmlParseInfo[num++] = createImageParseInfo("width", offsetof(xml_image, width));
-        xmlParseInfo[num++] = createImageParseInfo("height", offsetof(xml_image, height));
-        xmlParseInfo[num++] = createImageParseInfo("frameX", offsetof(xml_image, xOffset));
-        xmlParseInfo[num++] = createImageParseInfo("frameY", offsetof(xml_image, yOffset));
-        xmlParseInfo[num++] = createImageParseInfo("frameWidth", offsetof(xml_image, fullWidth));
-        xmlParseInfo[num++] = createImageParseInfo("frameHeight", offsetof(xml_image, fullHeight));
-        assert(num == xml_image_parse_num_elements);
+// Read-only, so any number of files can be parsed at once
+static const xml_image_parse_info c_xmlParseInfo[] = {
+        {"x", offsetof(xml_image, x)},
+        {"y", offsetof(xml_image, y)},
+        {"width", offsetof(xml_image, width)},
+        {"height", offsetof(xml_image, height)},
+        {"frameX", offsetof(xml_image, xOffset)},
+        {"frameY", offsetof(xml_image, yOffset)},
+        {"frameWidth", offsetof(xml_image, fullWidth)},
+        {"frameHeight", offsetof(xml_image, fullHeight)}
 };
-
-void deinitXMLParseInfos()
-{
-        free(xmlParseInfo);
-}
+static const size_t xml_image_parse_num_elements = sizeof(c_xmlParseInfo) / sizeof(c_xmlParseInfo[0]);
 
 void parseAttribute(const char * attrName, const char * attrValue, xml_image * outInfo,
-                    xml_image_parse_infop parseInfos, size_t parseInfoCount)
+                    const xml_image_parse_info * parseInfos, size_t parseInfoCount)
 {
-        for (int x = 0; x < parseInfoCount; x++) {
-                xml_image_parse_infop parseInfo = parseInfos+x;
+        for (size_t x = 0; x < parseInfoCount; x++) {
+                const xml_image_parse_info * parseInfo = parseInfos + x;
                 if (strcmp(attrName, parseInfo->name) == 0) {
                         float * value = (float *)((intptr_t)outInfo + parseInfo->offset);
                         *value = atof(attrValue);
@@ -118,8 +96,14 @@ static void XMLCALL start(void *data, const char *el, const char **attr)
                 // Found a sub texture element - discover dimensions
                 xml_image * newImage = createXmlImage();
                 while (*attr != NULL) {
-                        parseAttribute(attr[0], attr[1], newImage, xmlParseInfo, xml_image_parse_num_elements);
-                        attr++;
+                        parseAttribute(attr[0], attr[1], newImage, c_xmlParseInfo, xml_image_parse_num_elements);
+                        if (strcmp(attr[0], "name") == 0 && newImage->name == NULL) {
+                                size_t length = strlen(attr[1]) + 1;
+                                newImage->name = (char *)malloc(length);
+                                memcpy(newImage->name, attr[1], length);
+                        }
+                        // Attributes come as name, value pairs
+                        attr += 2;
                 }
                 addImageToContext(context, newImage);
         }
@@ -133,7 +117,6 @@ xml_image * processXML(FILE * file, size_t bufferSize)
 {
         char * buffer = (char *)malloc(bufferSize);
         
-        initXMLParseInfos();
         xml_contextp context = createXmlContext();
         XML_Parser p = XML_ParserCreate(NULL);
         if (! p) {
@@ -148,7 +131,7 @@ xml_image * processXML(FILE * file, size_t bufferSize)
                 int done;
                 int len;
                 
-                len = (int)fread(buffer, 1, XML_BUFFSIZE, file);
+                len = (int)fread(buffer, 1, bufferSize, file);
                 if (ferror(file)) {
                         fprintf(stderr, "Read error\n");
                         exit(-1);
@@ -166,16 +149,17 @@ xml_image * processXML(FILE * file, size_t bufferSize)
                         break;
         }
         XML_ParserFree(p);
-        deinitXMLParseInfos();
+        xml_image * firstImage = context->firstImage;
         destroyXmlContext(context);
         free(buffer);
-        return context->firstImage;
+        return firstImage;
 }
 
 void destroyImageStructList(xml_image * toDestroy)
 {
         while (toDestroy) {
                 xml_image * next = toDestroy->next;
+                free(toDestroy->name);
                 free(toDestroy);
                 toDestroy = next;
         }
@@ -16,6 +16,8 @@ typedef struct xml_image_struct {
   float yOffset;
   float fullWidth;
   float fullHeight;
+  // Value of the name attribute, or NULL
+  char * name;
   struct xml_image_struct * next;
 } xml_image;
 static const size_t xml_image_size = sizeof(xml_image);